@@ -1010,12 +1010,12 @@ public:
 
 	// ThingIDs
 	static void ClearTIDHashes ();
+	static void FreeTIDChains ();
 	void AddToHash ();
 	void RemoveFromHash ();
 
 private:
-	static AActor *TIDHash[128];
-	static inline int TIDHASH (int key) { return key & 127; }
+	static AActor **FindTIDChain (int tid, bool create);
 	static FSharedStringArena mStringPropertyData;
 
 	friend class FActorIterator;
@@ -1081,7 +1081,10 @@ public:
 		if (id == 0)
 			return NULL;
 		if (!base)
-			base = AActor::TIDHash[id & 127];
+		{
+			AActor **chain = AActor::FindTIDChain (id, false);
+			base = chain != NULL ? *chain : NULL;
+		}
 		else
 			base = base->inext;
 
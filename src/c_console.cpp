@@ -66,6 +66,7 @@
 #include "d_event.h"
 #include "d_player.h"
 #include "c_consolebuffer.h"
+#include "threadpool.h"
 
 #include "gi.h"
 
@@ -550,6 +551,12 @@ int PrintString (int printlevel, const char *outline)
 		return 0;
 	}
 
+	if (ThreadPool.IsWorkerThread())
+	{
+		ThreadPool.DeferPrint(printlevel, outline);
+		return (int)strlen(outline);
+	}
+
 	if (printlevel != PRINT_LOG)
 	{
 		I_PrintStr (outline);
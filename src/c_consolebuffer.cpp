@@ -273,7 +273,7 @@ void FConsoleBuffer::FormatText(FFont *formatfont, int displaywidth)
 	if (brokensize == mConsoleText.Size())
 	{
 		// The last line got text appended. We have to wait until here to format it because
-		// it is possible that during display new text will be added from the NetUpdate calls in the software version of DrawTextureV.
+		// it is possible that during display new text will be added from the NetUpdate calls in the software version of DrawTextureParms.
 		if (mLastLineNeedsUpdate)
 		{
 			brokensize--;
@@ -51,6 +51,7 @@
 #include "v_palette.h"
 #include "v_video.h"
 #include "colormatcher.h"
+#include "stats.h"
 
 struct FLatchedValue
 {
@@ -66,6 +67,10 @@ bool FBaseCVar::m_UseCallback = false;
 
 FBaseCVar *CVars = NULL;
 
+// Index over CVars for name lookups. Cvars get constructed during static
+// initialization so this must not be anything that needs a constructor.
+static FBaseCVar *CVarHash[FBaseCVar::HASH_SIZE];
+
 int cvar_defflags;
 
 FBaseCVar::FBaseCVar (const FBaseCVar &var)
@@ -89,6 +94,12 @@ FBaseCVar::FBaseCVar (const char *var_name, DWORD flags, void (*callback)(FBaseC
 		Name = copystring (var_name);
 		m_Next = CVars;
 		CVars = this;
+		CVarHashInsert (this);
+	}
+	else
+	{
+		m_HashNext = NULL;
+		m_HashPrev = NULL;
 	}
 
 	if (var)
@@ -127,6 +138,12 @@ FBaseCVar::~FBaseCVar ()
 			else
 				CVars = m_Next;
 		}
+		if (m_HashPrev != NULL)
+		{
+			*m_HashPrev = m_HashNext;
+			if (m_HashNext)
+				m_HashNext->m_HashPrev = m_HashPrev;
+		}
 		C_RemoveTabCommand(Name);
 		delete[] Name;
 	}
@@ -1424,17 +1441,44 @@ void C_ForgetCVars (void)
 	CVarBackups.Clear();
 }
 
+//===========================================================================
+//
+// CVarHashInsert
+//
+// Newer cvars go in front so that they hide older ones of the same name,
+// just like in the CVars list.
+//
+//===========================================================================
+
+void CVarHashInsert (FBaseCVar *var)
+{
+	FBaseCVar **bucket = &CVarHash[MakeKey (var->Name) % FBaseCVar::HASH_SIZE];
+
+	var->m_HashNext = *bucket;
+	var->m_HashPrev = bucket;
+	if (var->m_HashNext)
+		var->m_HashNext->m_HashPrev = &var->m_HashNext;
+	*bucket = var;
+}
+
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev)
 {
 	FBaseCVar *var;
-	FBaseCVar *dummy;
 
 	if (var_name == NULL)
 		return NULL;
 
 	if (prev == NULL)
-		prev = &dummy;
+	{
+		for (var = CVarHash[MakeKey (var_name) % FBaseCVar::HASH_SIZE]; var != NULL; var = var->m_HashNext)
+		{
+			if (stricmp (var->GetName (), var_name) == 0)
+				break;
+		}
+		return var;
+	}
 
+	// The list predecessor is only needed for unlinking, so this is rare.
 	var = CVars;
 	*prev = NULL;
 	while (var)
@@ -1454,7 +1498,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 	if (var_name == NULL)
 		return NULL;
 
-	var = CVars;
+	var = CVarHash[MakeKey (var_name, namelen) % FBaseCVar::HASH_SIZE];
 	while (var)
 	{
 		const char *probename = var->GetName ();
@@ -1464,7 +1508,7 @@ FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 		{
 			break;
 		}
-		var = var->m_Next;
+		var = var->m_HashNext;
 	}
 	return var;
 }
@@ -1617,11 +1661,11 @@ CCMD (unset)
 
 CCMD (get)
 {
-	FBaseCVar *var, *prev;
+	FBaseCVar *var;
 
 	if (argv.argc() >= 2)
 	{
-		if ( (var = FindCVar (argv[1], &prev)) )
+		if ( (var = FindCVar (argv[1], NULL)) )
 		{
 			UCVarValue val;
 			val = var->GetGenericRep (CVAR_String);
@@ -1640,12 +1684,12 @@ CCMD (get)
 
 CCMD (toggle)
 {
-	FBaseCVar *var, *prev;
+	FBaseCVar *var;
 	UCVarValue val;
 
 	if (argv.argc() > 1)
 	{
-		if ( (var = FindCVar (argv[1], &prev)) )
+		if ( (var = FindCVar (argv[1], NULL)) )
 		{
 			val = var->GetGenericRep (CVAR_Bool);
 			val.Bool = !val.Bool;
@@ -1730,3 +1774,42 @@ CCMD (archivecvar)
 		}
 	}
 }
+
+//===========================================================================
+//
+// bench_findcvar [count]
+//
+// Looks up every cvar by name count times.
+//
+//===========================================================================
+
+CCMD (bench_findcvar)
+{
+	TArray<FString> names;
+	cycle_t timer;
+	int count = argv.argc() > 1 ? atoi (argv[1]) : 100;
+	int found = 0;
+
+	for (FBaseCVar *var = CVars; var != NULL; var = var->GetNext())
+	{
+		names.Push (var->GetName ());
+		// Make sure the case insensitive match gets tested, too.
+		names.Last().ToUpper();
+	}
+	if (count < 1) count = 1;
+
+	timer.Reset();
+	timer.Clock();
+	for (int i = 0; i < count; i++)
+	{
+		for (unsigned j = 0; j < names.Size(); j++)
+		{
+			if (FindCVar (names[j], NULL) != NULL) found++;
+		}
+	}
+	timer.Unclock();
+
+	double lookups = (double)count * names.Size();
+	Printf ("%.0f lookups (%d found) in %.2f ms, %.0f lookups/s\n",
+		lookups, found, timer.TimeMS(), lookups * 1000. / MAX(timer.TimeMS(), 0.001));
+}
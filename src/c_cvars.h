@@ -100,6 +100,8 @@ public:
 	inline uint32 GetFlags () const { return Flags; }
 	inline FBaseCVar *GetNext() const { return m_Next; }
 
+	enum { HASH_SIZE = 1021 };	// for the name lookup table
+
 	void CmdSet (const char *newval);
 	void ForceSet (UCVarValue value, ECVarType type, bool nouserinfosend=false);
 	void SetGenericRep (UCVarValue value, ECVarType type);
@@ -149,6 +151,7 @@ private:
 
 	void (*m_Callback)(FBaseCVar &);
 	FBaseCVar *m_Next;
+	FBaseCVar *m_HashNext, **m_HashPrev;
 
 	static bool m_UseCallback;
 	static bool m_DoNoSet;
@@ -164,6 +167,7 @@ private:
 	friend void C_SetCVarsToDefaults (void);
 	friend void FilterCompactCVars (TArray<FBaseCVar *> &cvars, uint32 filter);
 	friend void C_DeinitConsole();
+	friend void CVarHashInsert(FBaseCVar *var);
 };
 
 // Returns a string with all cvars whose flags match filter. In compact mode,
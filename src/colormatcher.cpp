@@ -34,7 +34,14 @@
 ** It was, but the results were not as good as I would like, so I didn't
 ** actually use it. But I did keep the code around in case I ever felt like
 ** revisiting the problem. I never did, so now it's relegated to the mists
-** of SVN history, and this is just a thin wrapper around BestColor().
+** of SVN history.
+**
+** Picking is now done with an inverse colormap. Color space is split into
+** 32x64x32 cells, and for each cell we keep the list of palette entries
+** that could possibly be the closest match for any color inside it. Most
+** cells end up with only one or two candidates, so a pick is a table
+** lookup followed by a very short search. Unlike the old approximations,
+** the result is always identical to what BestColor() returns.
 **
 */
 
@@ -42,9 +49,73 @@
 #include <string.h>
 
 #include "doomtype.h"
+#include "templates.h"
 #include "colormatcher.h"
 #include "v_palette.h"
 
+// Super cells are used to narrow down the candidates before the actual
+// cells are built. Each one covers 4x8x4 cells.
+enum
+{
+	SUPER_RBITS = 3, SUPER_GBITS = 3, SUPER_BBITS = 3,
+};
+
+//==========================================================================
+//
+// Distance bounds between a palette entry and a box in color space
+//
+//==========================================================================
+
+static inline int AxisMinDist (int c, int lo, int hi)
+{
+	int d = c < lo ? lo - c : c > hi ? c - hi : 0;
+	return d * d;
+}
+
+static inline int AxisMaxDist (int c, int lo, int hi)
+{
+	int d = MAX (abs(c - lo), abs(c - hi));
+	return d * d;
+}
+
+//==========================================================================
+//
+// FilterCandidates
+//
+// Keeps only those entries of in[] that could be the closest color for
+// some point in the box: Any entry whose nearest distance to the box is
+// larger than the smallest farthest distance of all entries can never win.
+// Ties are kept so that the lowest index still wins like in BestColor().
+//
+//==========================================================================
+
+static int FilterCandidates (const PalEntry *pal, const BYTE *in, int numin, BYTE *out,
+	int rlo, int rhi, int glo, int ghi, int blo, int bhi)
+{
+	int mindist[256];
+	int bound = INT_MAX;
+	int i, numout;
+
+	for (i = 0; i < numin; ++i)
+	{
+		const PalEntry &pe = pal[in[i]];
+		int maxdist = AxisMaxDist (pe.r, rlo, rhi) + AxisMaxDist (pe.g, glo, ghi) + AxisMaxDist (pe.b, blo, bhi);
+		if (maxdist < bound)
+		{
+			bound = maxdist;
+		}
+		mindist[i] = AxisMinDist (pe.r, rlo, rhi) + AxisMinDist (pe.g, glo, ghi) + AxisMinDist (pe.b, blo, bhi);
+	}
+	for (i = numout = 0; i < numin; ++i)
+	{
+		if (mindist[i] <= bound)
+		{
+			out[numout++] = in[i];
+		}
+	}
+	return numout;
+}
+
 FColorMatcher::FColorMatcher ()
 {
 	Pal = NULL;
@@ -63,18 +134,132 @@ FColorMatcher::FColorMatcher (const FColorMatcher &other)
 FColorMatcher &FColorMatcher::operator= (const FColorMatcher &other)
 {
 	Pal = other.Pal;
+	Cells = other.Cells;
+	Candidates = other.Candidates;
 	return *this;
 }
 
+//==========================================================================
+//
+// FColorMatcher :: SetPalette
+//
+// The table is built right away rather than on first use, because Pick()
+// may be called from several texture loading threads at once.
+//
+//==========================================================================
+
 void FColorMatcher::SetPalette (const DWORD *palette)
 {
 	Pal = (const PalEntry *)palette;
+	Cells.Clear ();
+	Candidates.Clear ();
+	if (Pal != NULL)
+	{
+		BuildTable ();
+	}
+}
+
+//==========================================================================
+//
+// FColorMatcher :: BuildTable
+//
+// Pick() matches BestColor()'s defaults, so only entries 1-254 are
+// considered.
+//
+//==========================================================================
+
+void FColorMatcher::BuildTable ()
+{
+	const int cellr = 1 << (8 - RBITS), cellg = 1 << (8 - GBITS), cellb = 1 << (8 - BBITS);
+	const int subr = 1 << (RBITS - SUPER_RBITS), subg = 1 << (GBITS - SUPER_GBITS), subb = 1 << (BBITS - SUPER_BBITS);
+	BYTE all[256], supercands[256], cellcands[256];
+	int numall = 0;
+
+	// Duplicate colors can never win over the first entry with that color.
+	for (int i = 1; i < 255; ++i)
+	{
+		int j;
+		for (j = 1; j < i; ++j)
+		{
+			if (((Pal[i].d ^ Pal[j].d) & 0xFFFFFF) == 0)
+				break;
+		}
+		if (j == i)
+		{
+			all[numall++] = (BYTE)i;
+		}
+	}
+
+	Cells.Resize (NUM_CELLS);
+	Candidates.Grow (NUM_CELLS * 2);
+
+	for (int sr = 0; sr < (1 << SUPER_RBITS); ++sr)
+	for (int sg = 0; sg < (1 << SUPER_GBITS); ++sg)
+	for (int sb = 0; sb < (1 << SUPER_BBITS); ++sb)
+	{
+		// Any entry that can win somewhere inside a cell can also win
+		// somewhere inside the super cell containing it, so the cells
+		// only need to look at the super cell's candidates.
+		int r0 = sr * subr, g0 = sg * subg, b0 = sb * subb;
+		int numsuper = FilterCandidates (Pal, all, numall, supercands,
+			r0 * cellr, (r0 + subr) * cellr - 1, g0 * cellg, (g0 + subg) * cellg - 1, b0 * cellb, (b0 + subb) * cellb - 1);
+
+		for (int r = r0; r < r0 + subr; ++r)
+		for (int g = g0; g < g0 + subg; ++g)
+		for (int b = b0; b < b0 + subb; ++b)
+		{
+			int numcell = FilterCandidates (Pal, supercands, numsuper, cellcands,
+				r * cellr, (r + 1) * cellr - 1, g * cellg, (g + 1) * cellg - 1, b * cellb, (b + 1) * cellb - 1);
+			unsigned int start = Candidates.Reserve (numcell);
+			memcpy (&Candidates[start], cellcands, numcell);
+			Cells[(r << (GBITS + BBITS)) | (g << BBITS) | b] = (start << 8) | numcell;
+		}
+	}
+	Candidates.ShrinkToFit ();
 }
 
+//==========================================================================
+//
+// FColorMatcher :: Pick
+//
+//==========================================================================
+
 BYTE FColorMatcher::Pick (int r, int g, int b)
 {
 	if (Pal == NULL)
 		return 1;
 
-	return (BYTE)BestColor ((uint32 *)Pal, r, g, b);
+	if (Cells.Size() == 0 || (unsigned)(r|g|b) > 255)
+	{
+		return (BYTE)BestColor ((uint32 *)Pal, r, g, b);
+	}
+
+	DWORD cell = Cells[((r >> (8 - RBITS)) << (GBITS + BBITS)) | ((g >> (8 - GBITS)) << BBITS) | (b >> (8 - BBITS))];
+	const BYTE *cands = &Candidates[cell >> 8];
+	int count = cell & 255;
+
+	if (count == 1)
+	{
+		return cands[0];
+	}
+
+	int bestcolor = cands[0];
+	int bestdist = INT_MAX;
+	for (int i = 0; i < count; ++i)
+	{
+		const PalEntry &pe = Pal[cands[i]];
+		int x = r - pe.r;
+		int y = g - pe.g;
+		int z = b - pe.b;
+		int dist = x*x + y*y + z*z;
+		if (dist < bestdist)
+		{
+			if (dist == 0)
+				return cands[i];
+
+			bestdist = dist;
+			bestcolor = cands[i];
+		}
+	}
+	return (BYTE)bestcolor;
 }
@@ -50,8 +50,27 @@ public:
 
 	FColorMatcher &operator= (const FColorMatcher &other);
 
+	bool IsBuiltFor (const DWORD *palette) const
+	{
+		return Pal == (const PalEntry *)palette && Cells.Size() != 0;
+	}
+
+	// The inverse colormap has 32x64x32 cells. Each cell lists every
+	// palette entry that can be the closest one for some color inside it.
+	enum
+	{
+		RBITS = 5, GBITS = 6, BBITS = 5,
+		NUM_CELLS = 1 << (RBITS + GBITS + BBITS)
+	};
+
+	int GetNumCandidates () const { return Candidates.Size(); }
+
 private:
+	void BuildTable ();
+
 	const PalEntry *Pal;
+	TArray<DWORD> Cells;		// (offset << 8) | count into Candidates
+	TArray<BYTE> Candidates;
 };
 
 extern FColorMatcher ColorMatcher;
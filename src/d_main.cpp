@@ -151,6 +151,7 @@ EXTERN_CVAR (Bool, lookstrafe)
 EXTERN_CVAR (Int, screenblocks)
 EXTERN_CVAR (Bool, sv_cheats)
 EXTERN_CVAR (Bool, sv_unlimited_pickup)
+EXTERN_CVAR (Bool, decorate_profile)
 
 extern int testingmode;
 extern bool setmodeneeded;
@@ -787,6 +788,7 @@ void D_Display ()
 
 	{
 		unsigned int nowtime = I_FPSTime();
+		TexMan.TrimPixelCache();
 		TexMan.UpdateAnimations(nowtime);
 		R_UpdateSky(nowtime);
 		switch (gamestate)
@@ -2502,6 +2504,11 @@ void D_DoomMain (void)
 		// Create replacements for dehacked pickups
 		FinishDehPatch();
 
+		if (Args->CheckParm("-profileactions"))
+		{
+			decorate_profile = true;
+		}
+
 		FActorInfo::StaticSetActorNums ();
 
 		//Added by MC:
@@ -272,6 +272,7 @@ static const char *DecalKeywords[] =
 	"lowerdecal",
 	NULL
 };
+static FKeywordTable DecalKeywordTable(DecalKeywords);
 
 enum
 {
@@ -466,7 +467,7 @@ void FDecalLib::ParseDecal (FScanner &sc)
 			AddDecal (decalName, decalNum, newdecal);
 			break;
 		}
-		switch (sc.MustMatchString (DecalKeywords))
+		switch (sc.MustMatchString (DecalKeywordTable))
 		{
 		case DECAL_XSCALE:
 			newdecal.ScaleX = ReadScale (sc);
@@ -67,6 +67,7 @@
 #include "v_font.h"
 #include "r_data/colormaps.h"
 #include "farchive.h"
+#include "p_tags.h"
 
 static FRandom pr_script("FScript");
 
@@ -4369,6 +4370,9 @@ void FParser::SF_SetLineTrigger()
 										(f & ~(ML_MONSTERSCANACTIVATE|ML_REPEAT_SPECIAL|ML_SPAC_MASK|ML_FIRSTSIDEONLY));
 
 		}
+
+		// The line IDs may have changed.
+		P_InitTagLists();
 	}
 }
 
@@ -4391,16 +4395,8 @@ void FParser::SF_ChangeTag()
 			sectors[secnum].tag=t_argv[1].value.i;
 		}
 
-		// Recreate the hash tables
-		int i;
-
-		for (i=numsectors; --i>=0; ) sectors[i].firsttag = -1;
-		for (i=numsectors; --i>=0; )
-		{
-			int j = (unsigned) sectors[i].tag % (unsigned) numsectors;
-			sectors[i].nexttag = sectors[j].firsttag;
-			sectors[j].firsttag = i;
-		}
+		// Recreate the tag index
+		P_InitTagLists();
 	}
 }
 
@@ -2777,6 +2777,8 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				P_ActionProfileSummary();
+
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -1336,6 +1336,7 @@ MapFlagHandlers[] =
 	{ "cd_title_track",					MITYPE_EATNEXT,	0, 0 },
 	{ NULL, MITYPE_IGNORE, 0, 0}
 };
+static FKeywordTable MapFlagKeywords(&MapFlagHandlers->name, sizeof(*MapFlagHandlers));
 
 //==========================================================================
 //
@@ -1352,7 +1353,7 @@ void FMapInfoParser::ParseMapDefinition(level_info_t &info)
 
 	while (sc.GetString())
 	{
-		if ((index = sc.MatchString(&MapFlagHandlers->name, sizeof(*MapFlagHandlers))) >= 0)
+		if ((index = sc.MatchString(MapFlagKeywords)) >= 0)
 		{
 			MapInfoFlagHandler *handler = &MapFlagHandlers[index];
 			switch (handler->type)
@@ -1370,6 +1370,18 @@ public:
 			}
 			adjustRelCenter(x.RelCenter(), y.RelCenter(), *x, *y, ax, ay, xScale, yScale);
 		}
+
+		// Every character is drawn with the same tags, so only set them up once.
+		FDrawTags shadowTags, charTags;
+		int shadowWidth = shadowTags.AddFloat(DTA_DestWidthF, 0);
+		int shadowHeight = shadowTags.AddFloat(DTA_DestHeightF, 0);
+		shadowTags.AddInt(DTA_Alpha, fixed_t(((double) alpha / (double) FRACUNIT) * ((double) HR_SHADOW / (double) FRACUNIT) * FRACUNIT));
+		shadowTags.AddInt(DTA_FillColor, 0);
+		int charWidth = charTags.AddFloat(DTA_DestWidthF, 0);
+		int charHeight = charTags.AddFloat(DTA_DestHeightF, 0);
+		int charTranslation = charTags.AddPtr(DTA_Translation, remap);
+		charTags.AddInt(DTA_Alpha, alpha);
+
 		while(*str != '\0')
 		{
 			if(*str == ' ')
@@ -1458,22 +1470,16 @@ public:
 			}
 			if(drawshadow)
 			{
-				int salpha = fixed_t(((double) alpha / (double) FRACUNIT) * ((double) HR_SHADOW / (double) FRACUNIT) * FRACUNIT);
 				double srx = rx + (shadowX*xScale);
 				double sry = ry + (shadowY*yScale);
-				screen->DrawTexture(character, srx, sry,
-					DTA_DestWidthF, rw,
-					DTA_DestHeightF, rh,
-					DTA_Alpha, salpha,
-					DTA_FillColor, 0,
-					TAG_DONE);
+				shadowTags[shadowWidth].Float = rw;
+				shadowTags[shadowHeight].Float = rh;
+				screen->DrawTexture(character, srx, sry, shadowTags);
 			}
-			screen->DrawTexture(character, rx, ry,
-				DTA_DestWidthF, rw,
-				DTA_DestHeightF, rh,
-				DTA_Translation, remap,
-				DTA_Alpha, alpha,
-				TAG_DONE);
+			charTags[charWidth].Float = rw;
+			charTags[charHeight].Float = rh;
+			charTags[charTranslation].Ptr = remap;
+			screen->DrawTexture(character, rx, ry, charTags);
 			if(script->spacingCharacter == '\0')
 				ax += width + spacing - (character->LeftOffset+1);
 			else //width gets changed at the call to GetChar()
@@ -291,7 +291,7 @@ void FFlatVertexBuffer::UnmapVBO()
 //
 //==========================================================================
 
-void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
+void FFlatVertexBuffer::SetPlaneVertices(sector_t *sec, int plane)
 {
 	int startvt = sec->vboindex[plane];
 	int countvt = sec->vbocount[plane];
@@ -302,6 +302,22 @@ void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
 		vt->z = splane.ZatPoint(vt->x, vt->y);
 		if (plane == sector_t::floor && sec->transdoor) vt->z -= 1;
 	}
+}
+
+void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
+{
+	SetPlaneVertices(sec, plane);
+	UploadVertices(sec->vboindex[plane], sec->vbocount[plane]);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FFlatVertexBuffer::UploadVertices(int startvt, int countvt)
+{
 	if (gl.flags & RFL_MAP_BUFFER_RANGE)
 	{
 		MapVBO();
@@ -324,6 +340,12 @@ void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
 void FFlatVertexBuffer::CreateVBO()
 {
 	vbo_shadowdata.Clear();
+	for (unsigned i = 0; i < DirtyPlaneSectors.Size(); i++)
+	{
+		DirtyPlaneSectors[i]->planesdirty = false;
+	}
+	DirtyPlaneSectors.Clear();
+
 	if (vbo_arg > 0)
 	{
 		CreateFlatVBO();
@@ -365,47 +387,77 @@ void FFlatVertexBuffer::BindVBO()
 
 //==========================================================================
 //
+// Updates the planes whose height has changed since the last frame.
+// Anything moving will not be updated unless it stops. This is to ensure
+// that we never have to synchronize with the rendering process.
 //
+// The sectors only need to be checked when a mover or the savegame code
+// has flagged them. Sorting the changed ranges allows to upload adjacent
+// planes in one go.
 //
 //==========================================================================
 
-void FFlatVertexBuffer::CheckPlanes(sector_t *sector)
+static int CompareVertexRanges(const void *a, const void *b)
 {
-	if (sector->GetPlaneTexZ(sector_t::ceiling) != sector->vboheight[sector_t::ceiling])
+	return *(const int *)a - *(const int *)b;
+}
+
+void FFlatVertexBuffer::UpdateDirtyPlanes()
+{
+	unsigned keep = 0;
+
+	if (vbo_arg != 2)
 	{
-		if (sector->ceilingdata == NULL) // only update if there's no thinker attached
+		for (unsigned i = 0; i < DirtyPlaneSectors.Size(); i++)
 		{
-			UpdatePlaneVertices(sector, sector_t::ceiling);
-			sector->vboheight[sector_t::ceiling] = sector->GetPlaneTexZ(sector_t::ceiling);
+			DirtyPlaneSectors[i]->planesdirty = false;
 		}
+		DirtyPlaneSectors.Clear();
+		return;
 	}
-	if (sector->GetPlaneTexZ(sector_t::floor) != sector->vboheight[sector_t::floor])
+
+	UpdateRanges.Clear();
+	for (unsigned i = 0; i < DirtyPlaneSectors.Size(); i++)
 	{
-		if (sector->floordata == NULL) // only update if there's no thinker attached
+		sector_t *sector = DirtyPlaneSectors[i];
+		bool moving = false;
+
+		for (int plane = sector_t::floor; plane <= sector_t::ceiling; plane++)
 		{
-			UpdatePlaneVertices(sector, sector_t::floor);
-			sector->vboheight[sector_t::floor] = sector->GetPlaneTexZ(sector_t::floor);
+			if (sector->GetPlaneTexZ(plane) != sector->vboheight[plane])
+			{
+				void *mover = plane == sector_t::floor ? (void*)sector->floordata : (void*)sector->ceilingdata;
+				if (mover == NULL) // only update if there's no thinker attached
+				{
+					SetPlaneVertices(sector, plane);
+					sector->vboheight[plane] = sector->GetPlaneTexZ(plane);
+
+					FVertexRange range = { sector->vboindex[plane], sector->vbocount[plane] };
+					if (range.count > 0) UpdateRanges.Push(range);
+				}
+				else moving = true;
+			}
 		}
+		// Sectors that are still moving have to be checked again next frame.
+		if (moving) DirtyPlaneSectors[keep++] = sector;
+		else sector->planesdirty = false;
 	}
-}
+	DirtyPlaneSectors.Resize(keep);
 
-//==========================================================================
-//
-// checks the validity of all planes attached to this sector
-// and updates them if possible. Anything moving will not be
-// updated unless it stops. This is to ensure that we never
-// have to synchronize with the rendering process.
-//
-//==========================================================================
+	if (UpdateRanges.Size() == 0) return;
 
-void FFlatVertexBuffer::CheckUpdate(sector_t *sector)
-{
-	if (vbo_arg == 2)
+	qsort(&UpdateRanges[0], UpdateRanges.Size(), sizeof(FVertexRange), CompareVertexRanges);
+
+	int start = UpdateRanges[0].start;
+	int end = start + UpdateRanges[0].count;
+	for (unsigned i = 1; i < UpdateRanges.Size(); i++)
 	{
-		CheckPlanes(sector);
-		sector_t *hs = sector->GetHeightSec();
-		if (hs != NULL) CheckPlanes(hs);
-		for(unsigned i = 0; i < sector->e->XFloor.ffloors.Size(); i++)
-			CheckPlanes(sector->e->XFloor.ffloors[i]->model);
+		if (UpdateRanges[i].start > end)
+		{
+			UploadVertices(start, end - start);
+			start = UpdateRanges[i].start;
+		}
+		end = MAX(end, UpdateRanges[i].start + UpdateRanges[i].count);
 	}
-}
\ No newline at end of file
+	UploadVertices(start, end - start);
+}
@@ -36,8 +36,16 @@ class FFlatVertexBuffer : public FVertexBuffer
 {
 	FFlatVertex *map;
 
+	struct FVertexRange
+	{
+		int start;
+		int count;
+	};
+	TArray<FVertexRange> UpdateRanges;
+
 	void MapVBO();
-	void CheckPlanes(sector_t *sector);
+	void SetPlaneVertices(sector_t *sec, int plane);
+	void UploadVertices(int startvt, int countvt);
 
 public:
 	int vbo_arg;
@@ -54,7 +62,7 @@ public:
 	void CreateVBO();
 	void UpdatePlaneVertices(sector_t *sec, int plane);
 	void BindVBO();
-	void CheckUpdate(sector_t *sector);
+	void UpdateDirtyPlanes();
 	void UnmapVBO();
 
 };
@@ -42,6 +42,8 @@
 #include "g_level.h"
 #include "thingdef/thingdef.h"
 #include "i_system.h"
+#include "memarena.h"
+#include "stats.h"
 
 
 #include "gl/renderer/gl_renderer.h"
@@ -54,6 +56,19 @@ EXTERN_CVAR (Float, gl_lights_size);
 EXTERN_CVAR (Bool, gl_lights_additive);
 EXTERN_CVAR(Int, vid_renderer)
 
+// Light nodes are allocated in blocks and recycled through a free list.
+// Moving lights relink every tic so going through the heap for each
+// node adds up quickly.
+static FMemArena LightNodeArena;
+static FLightNode *FreeLightNodes;
+static int LightNodesAllocated;
+static int LightNodesFree;
+
+// Relink statistics
+static int LinkTic = -1;
+static int LinksThisTic;
+static int FloodThisTic;
+
 
 //==========================================================================
 //
@@ -358,6 +373,12 @@ void ADynamicLight::UpdateLocation()
 		{
 			intensity = float(m_intensity[1]);
 		}
+		else if (lighttype == PulseLight)
+		{
+			// pulsing lights change their size every tic so they get linked
+			// with the largest size of their cycle.
+			intensity = float(MAX(m_intensity[0], m_intensity[1]));
+		}
 		else
 		{
 			intensity = m_currentIntensity;
@@ -430,7 +451,17 @@ FLightNode * AddLightNode(FLightNode ** thread, void * linkto, ADynamicLight * l
 	// Couldn't find an existing node for this sector. Add one at the head
 	// of the list.
 	
-	node = new FLightNode;
+	if (FreeLightNodes != NULL)
+	{
+		node = FreeLightNodes;
+		FreeLightNodes = node->nextLight;
+		LightNodesFree--;
+	}
+	else
+	{
+		node = (FLightNode *)LightNodeArena.Alloc(sizeof(FLightNode));
+		LightNodesAllocated++;
+	}
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -473,7 +504,9 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		
 		// Return this node to the freelist
 		tn=node->nextTarget;
-		delete node;
+		node->nextLight = FreeLightNodes;
+		FreeLightNodes = node;
+		LightNodesFree++;
 		return(tn);
     }
 	return(NULL);
@@ -523,6 +556,7 @@ void ADynamicLight::CollectWithinRadius(subsector_t *subSec, float radius)
 	bool additive = (flags4&MF4_ADDITIVE) || gl_lights_additive;
 
 	subSec->validcount = ::validcount;
+	FloodThisTic++;
 
 	touching_subsectors = AddLightNode(&subSec->lighthead[additive], subSec, this, touching_subsectors);
 
@@ -567,6 +601,13 @@ void ADynamicLight::LinkLight()
 {
 	// mark the old light nodes
 	FLightNode * node;
+
+	if (LinkTic != level.maptime)
+	{
+		LinksThisTic = FloodThisTic = 0;
+		LinkTic = level.maptime;
+	}
+	LinksThisTic++;
 	
 	node = touching_sides;
 	while (node)
@@ -667,6 +708,24 @@ size_t AActor::PropagateMark()
 
 
 
+//==========================================================================
+//
+// Shows how much relinking the lights did during the last tic
+//
+//==========================================================================
+
+ADD_STAT(lightlinks)
+{
+	FString out;
+	// level.maptime has already been advanced when this gets drawn.
+	bool recent = LinkTic >= level.maptime - 1;
+	out.Format("Relinks: %d, subsectors flooded: %d, nodes: %d (%d free)",
+		recent? LinksThisTic : 0, recent? FloodThisTic : 0,
+		LightNodesAllocated - LightNodesFree, LightNodesFree);
+	return out;
+}
+
+
 CCMD(listlights)
 {
 	int walls, sectors;
@@ -210,6 +210,7 @@ static const char *LightTags[]=
    "dontlightself",
    NULL
 };
+static FKeywordTable LightTagTable(LightTags);
 
 
 enum {
@@ -320,7 +321,7 @@ void gl_ParsePointLight(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -394,7 +395,7 @@ void gl_ParsePulseLight(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -473,7 +474,7 @@ void gl_ParseFlickerLight(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -552,7 +553,7 @@ void gl_ParseFlickerLight2(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -637,7 +638,7 @@ void gl_ParseSectorLight(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -740,7 +741,7 @@ void gl_ParseFrame(FScanner &sc, FString name)
 		while (ScriptDepth > startDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -790,7 +791,7 @@ void gl_ParseObject(FScanner &sc)
 		while (ScriptDepth)
 		{
 			sc.GetString();
-			type = sc.MatchString(LightTags);
+			type = sc.MatchString(LightTagTable);
 			switch (type)
 			{
 			case LIGHTTAG_OPENBRACE:
@@ -860,6 +861,7 @@ static const char *CoreKeywords[]=
    "#include",
    NULL
 };
+static FKeywordTable CoreKeywordTable(CoreKeywords);
 
 
 enum
@@ -1214,7 +1216,7 @@ void gl_DoParseDefs(FScanner &sc, int workingLump)
 		{
 			return;
 		}
-		type = sc.MatchString(CoreKeywords);
+		type = sc.MatchString(CoreKeywordTable);
 		switch (type)
 		{
 		case TAG_INCLUDE:
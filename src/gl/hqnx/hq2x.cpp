@@ -171,9 +171,15 @@ inline void Interp10(unsigned char * pc, int c1, int c2, int c3)
 #define PIXEL11_100   Interp10(pOut+BpL+4, c[5], c[6], c[8]);
 
 
-bool Diff(const unsigned int, const unsigned int);
 
 void DLL hq2x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
+{
+  hq2x_32_rows( pIn, pOut, Xres, Yres, BpL, 0, Yres );
+}
+
+// Only scales the input rows [ystart, yend) so that separate row bands
+// can be processed concurrently. The full image must still be passed in.
+void DLL hq2x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend )
 {
   int  i, j, k;
   int  w[10];
@@ -190,7 +196,10 @@ void DLL hq2x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
   //   | w7 | w8 | w9 |
   //   +----+----+----+
 
-  for (j=0; j<Yres; j++)
+  pIn += ystart * Xres;
+  pOut += ystart * 2 * BpL;
+
+  for (j = ystart; j < yend; j++)
   {
     for (i=0; i<Xres; i++)
     {
@@ -270,16 +279,7 @@ void DLL hq2x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
         }
       }
 
-      int pattern = 0;
-
-      if ( Diff(w[5],w[1]) ) pattern |= 0x0001;
-      if ( Diff(w[5],w[2]) ) pattern |= 0x0002;
-      if ( Diff(w[5],w[3]) ) pattern |= 0x0004;
-      if ( Diff(w[5],w[4]) ) pattern |= 0x0008;
-      if ( Diff(w[5],w[6]) ) pattern |= 0x0010;
-      if ( Diff(w[5],w[7]) ) pattern |= 0x0020;
-      if ( Diff(w[5],w[8]) ) pattern |= 0x0040;
-      if ( Diff(w[5],w[9]) ) pattern |= 0x0080;
+      int pattern = DiffPattern(w);
 
       for (k=1; k<=9; k++)
       {
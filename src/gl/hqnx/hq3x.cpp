@@ -144,9 +144,15 @@ inline void Interp5(unsigned char * pc, int c1, int c2)
 #define PIXEL22_5   Interp5(pOut+BpL+BpL+8, c[6], c[8]);
 #define PIXEL22_C   *((int*)(pOut+BpL+BpL+8)) = c[5];
 
-bool Diff(const unsigned int, const unsigned int);
 
 void DLL hq3x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
+{
+  hq3x_32_rows( pIn, pOut, Xres, Yres, BpL, 0, Yres );
+}
+
+// Only scales the input rows [ystart, yend) so that separate row bands
+// can be processed concurrently. The full image must still be passed in.
+void DLL hq3x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend )
 {
   int  i, j, k;
   int  w[10];
@@ -163,7 +169,10 @@ void DLL hq3x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
   //   | w7 | w8 | w9 |
   //   +----+----+----+
 
-  for (j=0; j<Yres; j++)
+  pIn += ystart * Xres;
+  pOut += ystart * 3 * BpL;
+
+  for (j = ystart; j < yend; j++)
   {
     for (i=0; i<Xres; i++)
     {
@@ -197,16 +206,7 @@ void DLL hq3x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
         if (i<Xres-1) w[9] = *(pIn + Xres + 1); else w[9] = 0;
       }
 
-      int pattern = 0;
-
-      if ( Diff(w[5],w[1]) ) pattern |= 0x0001;
-      if ( Diff(w[5],w[2]) ) pattern |= 0x0002;
-      if ( Diff(w[5],w[3]) ) pattern |= 0x0004;
-      if ( Diff(w[5],w[4]) ) pattern |= 0x0008;
-      if ( Diff(w[5],w[6]) ) pattern |= 0x0010;
-      if ( Diff(w[5],w[7]) ) pattern |= 0x0020;
-      if ( Diff(w[5],w[8]) ) pattern |= 0x0040;
-      if ( Diff(w[5],w[9]) ) pattern |= 0x0080;
+      int pattern = DiffPattern(w);
 
       for (k=1; k<=9; k++)
         c[k] = LUT16to32[w[k]];
@@ -21,6 +21,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include "hqnx.h"
+#include "x86.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__i386__) || defined(__amd64__)
+int HQDiffPattern_SSE2(const int *w, const int *yuvtable);
+#endif
 
 int   LUT16to32[65536*2];
 int   RGBtoYUV[65536*2];
@@ -286,7 +291,37 @@ bool Diff(const unsigned int rgb1, const unsigned int rgb2)
   return 0 != result;
 }
 
+int DiffPattern(const int *w)
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__i386__) || defined(__amd64__)
+  if (CPU.bSSE2)
+  {
+    return HQDiffPattern_SSE2(w, RGBtoYUV);
+  }
+#endif
+
+  int pattern = 0;
+
+  if ( Diff(w[5],w[1]) ) pattern |= 0x0001;
+  if ( Diff(w[5],w[2]) ) pattern |= 0x0002;
+  if ( Diff(w[5],w[3]) ) pattern |= 0x0004;
+  if ( Diff(w[5],w[4]) ) pattern |= 0x0008;
+  if ( Diff(w[5],w[6]) ) pattern |= 0x0010;
+  if ( Diff(w[5],w[7]) ) pattern |= 0x0020;
+  if ( Diff(w[5],w[8]) ) pattern |= 0x0040;
+  if ( Diff(w[5],w[9]) ) pattern |= 0x0080;
+
+  return pattern;
+}
+
 void DLL hq4x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
+{
+  hq4x_32_rows( pIn, pOut, Xres, Yres, BpL, 0, Yres );
+}
+
+// Only scales the input rows [ystart, yend) so that separate row bands
+// can be processed concurrently. The full image must still be passed in.
+void DLL hq4x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend )
 {
   int  i, j, k;
   int  w[10];
@@ -303,7 +338,10 @@ void DLL hq4x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
   //   | w7 | w8 | w9 |
   //   +----+----+----+
 
-  for (j = 0; j < Yres; j++)
+  pIn += ystart * Xres;
+  pOut += ystart * 4 * BpL;
+
+  for (j = ystart; j < yend; j++)
   {
     for (i = 0; i < Xres; i++)
     {
@@ -361,16 +399,7 @@ void DLL hq4x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
            w[9] = 0;
       }
 
-      int pattern = 0;
-
-      if ( Diff(w[5],w[1]) ) pattern |= 0x0001;
-      if ( Diff(w[5],w[2]) ) pattern |= 0x0002;
-      if ( Diff(w[5],w[3]) ) pattern |= 0x0004;
-      if ( Diff(w[5],w[4]) ) pattern |= 0x0008;
-      if ( Diff(w[5],w[6]) ) pattern |= 0x0010;
-      if ( Diff(w[5],w[7]) ) pattern |= 0x0020;
-      if ( Diff(w[5],w[8]) ) pattern |= 0x0040;
-      if ( Diff(w[5],w[9]) ) pattern |= 0x0080;
+      int pattern = DiffPattern(w);
 
       for (k=1; k<=9; k++)
         c[k] = LUT16to32[w[k]];
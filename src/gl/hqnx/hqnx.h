@@ -122,9 +122,16 @@ inline bool operator!=(const int left, const hq_vec& right)
 void DLL hq2x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL );
 void DLL hq3x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL );
 void DLL hq4x_32( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL );
+void DLL hq2x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend );
+void DLL hq3x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend );
+void DLL hq4x_32_rows( int * pIn, unsigned char * pOut, int Xres, int Yres, int BpL, int ystart, int yend );
 int DLL hq4x_32 ( CImage &ImageIn, CImage &ImageOut );
 
 void DLL InitLUTs();
 
+bool Diff(const unsigned int, const unsigned int);
+// Returns the Diff() results of w[5] against its 8 neighbours as a bit mask
+int DiffPattern(const int *w);
+
 
 #endif //__HQNX_H__
@@ -48,6 +48,7 @@
 #include "g_level.h"
 #include "r_state.h"
 #include "d_player.h"
+#include "threadpool.h"
 //#include "resources/voxels.h"
 //#include "gl/gl_intern.h"
 
@@ -227,7 +228,9 @@ static FModel * FindModel(const char * path, const char * modelfile)
 		FVoxel *voxel = R_LoadKVX(lump);
 		if (voxel != NULL)
 		{
-			model = new FVoxelModel(voxel, true);
+			FVoxelModel *md = new FVoxelModel(voxel, true);
+			md->Initialize();
+			model = md;
 		}
 		else
 		{
@@ -247,6 +250,12 @@ static FModel * FindModel(const char * path, const char * modelfile)
 //
 //===========================================================================
 
+static void InitVoxelModel(void *userdata, int index)
+{
+	FVoxelModel **models = (FVoxelModel **)userdata;
+	models[index]->Initialize();
+}
+
 void gl_InitModels()
 {
 	int Lump, lastLump;
@@ -267,10 +276,17 @@ void gl_InitModels()
 	DeleteModelHash();
 
 	// First, create models for each voxel
+	TArray<FVoxelModel *> voxelmodels;
 	for (unsigned i = 0; i < Voxels.Size(); i++)
 	{
 		FVoxelModel *md = new FVoxelModel(Voxels[i], false);
 		Voxels[i]->VoxelIndex = Models.Push(md);
+		voxelmodels.Push(md);
+	}
+	// The meshes do not depend on each other so they can be built in parallel.
+	if (voxelmodels.Size() > 0)
+	{
+		ThreadPool.ParallelFor(voxelmodels.Size(), InitVoxelModel, &voxelmodels[0]);
 	}
 	// now create GL model frames for the voxeldefs
 	for (unsigned i = 0; i < VoxelDefs.Size(); i++)
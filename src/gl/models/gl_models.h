@@ -86,11 +86,19 @@ protected:
 		int             offsetEnd;
 	};
 
+	// Frames are kept in the quantized form they are stored in the file.
+	// RenderFrame(Interpolated) unpacks the vertices it needs on the fly.
+	struct FPackedVertex
+	{
+		BYTE            xyz[3];
+	};
+
 	struct ModelFrame
 	{
 		char            name[16];
-		FModelVertex *vertices;
-		FModelVertex *normals;
+		float           scale[3];
+		float           translate[3];
+		FPackedVertex  *vertices;
 	};
 
 	struct DMDLoDInfo
@@ -121,6 +129,11 @@ protected:
 	bool			allowTexComp;  // Allow texture compression with this.
 
 	static void RenderGLCommands(void *glCommands, unsigned int numVertices,FModelVertex * vertices);
+	void UnpackFrame(const ModelFrame *frame, FModelVertex *vertices);
+
+	// Scratch space for the unpacked vertices of the frame(s) being drawn.
+	static TArray<FModelVertex> UnpackedVertices;
+	static TArray<FModelVertex> UnpackedVertices2;
 
 public:
 	FDMDModel() 
@@ -167,7 +180,13 @@ class FMD3Model : public FModel
 	struct MD3Vertex
 	{
 		float x,y,z;
-		float nx,ny,nz;
+	};
+
+	// The vertices are kept in the file's 10.6 fixed point format and
+	// only converted to floats for the frames being rendered.
+	struct MD3PackedVertex
+	{
+		short x,y,z;
 	};
 
 	struct MD3Triangle
@@ -184,7 +203,7 @@ class FMD3Model : public FModel
 		FTexture ** skins;
 		MD3Triangle * tris;
 		MD3TexCoord * texcoords;
-		MD3Vertex * vertices;
+		MD3PackedVertex * vertices;
 
 		MD3Surface()
 		{
@@ -218,6 +237,10 @@ class FMD3Model : public FModel
 	MD3Surface * surfaces;
 
 	void RenderTriangles(MD3Surface * surf, MD3Vertex * vert);
+	static MD3Vertex *UnpackVertices(const MD3PackedVertex *packed, int count, TArray<MD3Vertex> &buffer);
+
+	static TArray<MD3Vertex> UnpackedVertices;
+	static TArray<MD3Vertex> UnpackedVertices2;
 
 public:
 	FMD3Model() { }
@@ -276,9 +299,13 @@ protected:
 	FVoxelVertexBuffer *mVBO;
 	FTexture *mPalette;
 	
-	void MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check);
+	void AddRect(int dir, int slice, int a1, int b1, int a2, int b2, BYTE color, FVoxelMap &check);
 	void AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3, int y3, int z3, int x4, int y4, int z4, BYTE color, FVoxelMap &check);
 	void AddVertex(FVoxelVertex &vert, FVoxelMap &check);
+	void BuildMesh();
+	void MakeCacheKey(BYTE key[16]);
+	bool ReadCache(const BYTE key[16]);
+	void WriteCache(const BYTE key[16]);
 
 public:
 	FVoxelModel(FVoxel *voxel, bool owned);
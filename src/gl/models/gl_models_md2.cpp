@@ -49,27 +49,8 @@
 #include "gl/textures/gl_material.h"
 #include "gl/shaders/gl_shader.h"
 
-static float   avertexnormals[NUMVERTEXNORMALS][3] = {
-#include "tab_anorms.h"
-};
-
-//===========================================================================
-//
-// UnpackVector
-//  Packed: pppppppy yyyyyyyy. Yaw is on the XY plane.
-//
-//===========================================================================
-
-static void UnpackVector(unsigned short packed, float vec[3])
-{
-	float   yaw = (packed & 511) / 512.0f * 2 * PI;
-	float   pitch = ((packed >> 9) / 127.0f - 0.5f) * PI;
-	float   cosp = (float) cos(pitch);
-
-	vec[VX] = (float) cos(yaw) * cosp;
-	vec[VY] = (float) sin(yaw) * cosp;
-	vec[VZ] = (float) sin(pitch);
-}
+TArray<FDMDModel::FModelVertex> FDMDModel::UnpackedVertices;
+TArray<FDMDModel::FModelVertex> FDMDModel::UnpackedVertices2;
 
 
 //===========================================================================
@@ -114,7 +95,6 @@ bool FDMDModel::Load(const char * path, int, const char * buffer, int length)
 	ModelFrame *frame;
 	int     i, k, c;
 	FTriangle *triangles[MAX_LODS];
-	int     axis[3] = { VX, VY, VZ };
 
 	int fileoffset=12+sizeof(dmd_chunk_t);
 
@@ -170,18 +150,17 @@ bool FDMDModel::Load(const char * path, int, const char * buffer, int length)
 		dmd_packedVertex_t *pVtx;
 
 		memcpy(frame->name, pfr->name, sizeof(pfr->name));
-		frame->vertices = new FModelVertex[info.numVertices];
-		frame->normals = new FModelVertex[info.numVertices];
+		frame->vertices = new FPackedVertex[info.numVertices];
+		for(c = 0; c < 3; c++)
+		{
+			frame->scale[c] = FLOAT(pfr->scale[c]);
+			frame->translate[c] = FLOAT(pfr->translate[c]);
+		}
 
-		// Translate each vertex.
+		// The vertices stay packed until the frame gets drawn. The normals are not needed.
 		for(k = 0, pVtx = pfr->vertices; k < info.numVertices; k++, pVtx++)
 		{
-			UnpackVector((unsigned short)(pVtx->normal), frame->normals[k].xyz);
-			for(c = 0; c < 3; c++)
-			{
-				frame->vertices[k].xyz[axis[c]] =
-					(pVtx->vertex[c] * FLOAT(pfr->scale[c]) + FLOAT(pfr->translate[c]));
-			}
+			memcpy(frame->vertices[k].xyz, pVtx->vertex, 3);
 		}
 	}
 
@@ -229,7 +208,6 @@ FDMDModel::~FDMDModel()
 		for (i=0;i<info.numFrames;i++)
 		{
 			delete [] frames[i].vertices;
-			delete [] frames[i].normals;
 		}
 		delete [] frames;
 	}
@@ -332,7 +310,9 @@ void FDMDModel::RenderFrame(FTexture * skin, int frameno, int cm, int translatio
 		activeLod = 0;
 	}
 
-	RenderGLCommands(lods[activeLod].glCommands, numVerts, frame->vertices/*, modelColors, NULL*/);
+	UnpackedVertices.Resize(numVerts);
+	UnpackFrame(frame, &UnpackedVertices[0]);
+	RenderGLCommands(lods[activeLod].glCommands, numVerts, &UnpackedVertices[0]/*, modelColors, NULL*/);
 }
 
 void FDMDModel::RenderFrameInterpolated(FTexture * skin, int frameno, int frameno2, double inter, int cm, int translation)
@@ -341,9 +321,6 @@ void FDMDModel::RenderFrameInterpolated(FTexture * skin, int frameno, int framen
 
 	if (frameno>=info.numFrames || frameno2>=info.numFrames) return;
 
-	FModelVertex *vertices1 = frames[frameno].vertices;
-	FModelVertex *vertices2 = frames[frameno2].vertices;
-
 	if (!skin)
 	{
 		if (info.numSkins==0) return;
@@ -357,16 +334,44 @@ void FDMDModel::RenderFrameInterpolated(FTexture * skin, int frameno, int framen
 
 	int numVerts = info.numVertices;
 
+	UnpackedVertices.Resize(numVerts);
+	UnpackedVertices2.Resize(numVerts);
+	FModelVertex *vertices1 = &UnpackedVertices[0];
+	FModelVertex *vertices2 = &UnpackedVertices2[0];
+	UnpackFrame(&frames[frameno], vertices1);
+	UnpackFrame(&frames[frameno2], vertices2);
+
 	// [BB] Calculate the interpolated vertices by linear interpolation.
-	FModelVertex *verticesInterpolated = new FModelVertex[numVerts];
+	// The result goes into the first frame's buffer.
 	for( int k = 0; k < numVerts; k++ )
 	{
 		for ( int i = 0; i < 3; i++ )
-			verticesInterpolated[k].xyz[i] = (1-inter)*vertices1[k].xyz[i]+ (inter)*vertices2[k].xyz[i];
+			vertices1[k].xyz[i] = (1-inter)*vertices1[k].xyz[i]+ (inter)*vertices2[k].xyz[i];
 	}
 
-	RenderGLCommands(lods[activeLod].glCommands, numVerts, verticesInterpolated/*, modelColors, NULL*/);
-	delete[] verticesInterpolated;
+	RenderGLCommands(lods[activeLod].glCommands, numVerts, vertices1/*, modelColors, NULL*/);
+}
+
+//===========================================================================
+//
+// FDMDModel::UnpackFrame
+//
+// Expands a frame's quantized vertices into model space.
+//
+//===========================================================================
+
+void FDMDModel::UnpackFrame(const ModelFrame *frame, FModelVertex *vertices)
+{
+	static const int axis[3] = { VX, VY, VZ };
+	const FPackedVertex *pVtx = frame->vertices;
+
+	for(int k = 0; k < info.numVertices; k++, pVtx++)
+	{
+		for(int c = 0; c < 3; c++)
+		{
+			vertices[k].xyz[axis[c]] = (pVtx->xyz[c] * frame->scale[c] + frame->translate[c]);
+		}
+	}
 }
 
 
@@ -418,7 +423,6 @@ bool FMD2Model::Load(const char * path, int, const char * buffer, int length)
 	ModelFrame *frame;
 	byte   *md2_frames;
 	int     i, k, c;
-	int     axis[3] = { VX, VY, VZ };
 
 	// Convert it to DMD.
 	header.magic = MD2_MAGIC;
@@ -465,20 +469,17 @@ bool FMD2Model::Load(const char * path, int, const char * buffer, int length)
 		md2_triangleVertex_t *pVtx;
 
 		memcpy(frame->name, pfr->name, sizeof(pfr->name));
-		frame->vertices = new FModelVertex[info.numVertices];
-		frame->normals = new FModelVertex[info.numVertices];
+		frame->vertices = new FPackedVertex[info.numVertices];
+		for(c = 0; c < 3; c++)
+		{
+			frame->scale[c] = pfr->scale[c];
+			frame->translate[c] = pfr->translate[c];
+		}
 
-		// Translate each vertex.
+		// The vertices stay packed until the frame gets drawn. The normals are not needed.
 		for(k = 0, pVtx = pfr->vertices; k < info.numVertices; k++, pVtx++)
 		{
-			memcpy(frame->normals[k].xyz,
-				avertexnormals[pVtx->lightNormalIndex], sizeof(float) * 3);
-
-			for(c = 0; c < 3; c++)
-			{
-				frame->vertices[k].xyz[axis[c]] =
-					(pVtx->vertex[c] * pfr->scale[c] + pfr->translate[c]);
-			}
+			memcpy(frame->vertices[k].xyz, pVtx->vertex, 3);
 		}
 	}
 
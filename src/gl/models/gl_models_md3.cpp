@@ -49,18 +49,8 @@
 
 #define MAX_QPATH 64
 
-static void UnpackVector(unsigned short packed, float & nx, float & ny, float & nz)
-{
-	// decode the lat/lng normal to a 3 float normal
-	double lat = ( packed >> 8 ) & 0xff;
-	double lng = ( packed & 0xff );
-	lat *= PI/128;
-	lng *= PI/128;
-
-	nx = cos(lat) * sin(lng);
-	ny = sin(lat) * sin(lng);
-	nz = cos(lng);
-}
+TArray<FMD3Model::MD3Vertex> FMD3Model::UnpackedVertices;
+TArray<FMD3Model::MD3Vertex> FMD3Model::UnpackedVertices2;
 
 
 
@@ -191,16 +181,15 @@ bool FMD3Model::Load(const char * path, int, const char * buffer, int length)
 			s->texcoords[i].t = tc[i].t;
 		}
 
-		// Load vertices and texture coordinates
+		// Load vertices. They are kept in fixed point and the normals are not needed.
 		md3_vertex_t * vt = (md3_vertex_t*)(((char*)ss)+LittleLong(ss->Ofs_XYZNormal));
-		s->vertices = new MD3Vertex[s->numVertices * numFrames];
+		s->vertices = new MD3PackedVertex[s->numVertices * numFrames];
 
 		for(int i=0;i<s->numVertices * numFrames;i++)
 		{
-			s->vertices[i].x = LittleShort(vt[i].x)/64.f;
-			s->vertices[i].y = LittleShort(vt[i].y)/64.f;
-			s->vertices[i].z = LittleShort(vt[i].z)/64.f;
-			UnpackVector( LittleShort(vt[i].n), s->vertices[i].nx, s->vertices[i].ny, s->vertices[i].nz);
+			s->vertices[i].x = LittleShort(vt[i].x);
+			s->vertices[i].y = LittleShort(vt[i].y);
+			s->vertices[i].z = LittleShort(vt[i].z);
 		}
 	}
 	return true;
@@ -215,6 +204,26 @@ int FMD3Model::FindFrame(const char * name)
 	return -1;
 }
 
+//===========================================================================
+//
+// FMD3Model::UnpackVertices
+//
+// Converts one frame of a surface's vertices to floating point.
+//
+//===========================================================================
+
+FMD3Model::MD3Vertex *FMD3Model::UnpackVertices(const MD3PackedVertex *packed, int count, TArray<MD3Vertex> &buffer)
+{
+	buffer.Resize(count);
+	for(int i=0;i<count;i++)
+	{
+		buffer[i].x = packed[i].x/64.f;
+		buffer[i].y = packed[i].y/64.f;
+		buffer[i].z = packed[i].z/64.f;
+	}
+	return &buffer[0];
+}
+
 void FMD3Model::RenderTriangles(MD3Surface * surf, MD3Vertex * vert)
 {
 	gl_RenderState.Apply();
@@ -259,7 +268,7 @@ void FMD3Model::RenderFrame(FTexture * skin, int frameno, int cm, int translatio
 		FMaterial * tex = FMaterial::ValidateTexture(surfaceSkin);
 
 		tex->Bind(cm, 0, translation);
-		RenderTriangles(surf, surf->vertices + frameno * surf->numVertices);
+		RenderTriangles(surf, UnpackVertices(surf->vertices + frameno * surf->numVertices, surf->numVertices, UnpackedVertices));
 	}
 }
 
@@ -285,22 +294,19 @@ void FMD3Model::RenderFrameInterpolated(FTexture * skin, int frameno, int framen
 
 		tex->Bind(cm, 0, translation);
 
-		MD3Vertex* verticesInterpolated = new MD3Vertex[surfaces[i].numVertices];
-		MD3Vertex* vertices1 = surf->vertices + frameno * surf->numVertices;
-		MD3Vertex* vertices2 = surf->vertices + frameno2 * surf->numVertices;
+		MD3Vertex* vertices1 = UnpackVertices(surf->vertices + frameno * surf->numVertices, surf->numVertices, UnpackedVertices);
+		MD3Vertex* vertices2 = UnpackVertices(surf->vertices + frameno2 * surf->numVertices, surf->numVertices, UnpackedVertices2);
 
 		// [BB] Calculate the interpolated vertices by linear interpolation.
+		// The result goes into the first frame's buffer.
 		for( int k = 0; k < surf->numVertices; k++ )
 		{
-			verticesInterpolated[k].x = (1-inter)*vertices1[k].x+ (inter)*vertices2[k].x;
-			verticesInterpolated[k].y = (1-inter)*vertices1[k].y+ (inter)*vertices2[k].y;
-			verticesInterpolated[k].z = (1-inter)*vertices1[k].z+ (inter)*vertices2[k].z;
-			// [BB] Apparently RenderTriangles doesn't use nx, ny, nz, so don't interpolate them.
+			vertices1[k].x = (1-inter)*vertices1[k].x+ (inter)*vertices2[k].x;
+			vertices1[k].y = (1-inter)*vertices1[k].y+ (inter)*vertices2[k].y;
+			vertices1[k].z = (1-inter)*vertices1[k].z+ (inter)*vertices2[k].z;
 		}
 
-		RenderTriangles(surf, verticesInterpolated);
-
-		delete[] verticesInterpolated;
+		RenderTriangles(surf, vertices1);
 	}
 }
 
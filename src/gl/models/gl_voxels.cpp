@@ -37,6 +37,8 @@
 **
 */
 
+#include <zlib.h>
+
 #include "gl/system/gl_system.h"
 #include "w_wad.h"
 #include "cmdlib.h"
@@ -48,6 +50,10 @@
 #include "g_level.h"
 #include "colormatcher.h"
 #include "textures/bitmap.h"
+#include "m_misc.h"
+#include "m_swap.h"
+#include "md5.h"
+#include "threadpool.h"
 //#include "gl/gl_intern.h"
 
 #include "gl/system/gl_interface.h"
@@ -302,7 +308,6 @@ FVoxelModel::FVoxelModel(FVoxel *voxel, bool owned)
 	mOwningVoxel = owned;
 	mVBO = NULL;
 	mPalette = new FVoxelTexture(voxel);
-	Initialize();
 }
 
 //===========================================================================
@@ -376,63 +381,76 @@ void FVoxelModel::AddFace(int x1, int y1, int z1, int x2, int y2, int z2, int x3
 
 //===========================================================================
 //
-// 
+// Adds a rectangle of faces that all point in the same direction
+// (see FVoxelFace) and lie in the same plane
 //
 //===========================================================================
 
-void FVoxelModel::MakeSlabPolys(int x, int y, kvxslab_t *voxptr, FVoxelMap &check)
+void FVoxelModel::AddRect(int dir, int slice, int a1, int b1, int a2, int b2, BYTE color, FVoxelMap &check)
 {
-	const BYTE *col = voxptr->col;
-	int zleng = voxptr->zleng;
-	int ztop = voxptr->ztop;
-	int cull = voxptr->backfacecull;
-
-	if (cull & 16)
-	{
-		AddFace(x, y, ztop, x+1, y, ztop, x, y+1, ztop, x+1, y+1, ztop, *col, check);
-	}
-	int z = ztop;
-	while (z < ztop+zleng)
+	switch (dir)
 	{
-		int c = 0;
-		while (z+c < ztop+zleng && col[c] == col[0]) c++;
+	case 0:	// -x
+		AddFace(slice, a1, b1, slice, a2, b1, slice, a1, b2, slice, a2, b2, color, check);
+		break;
 
-		if (cull & 1)
-		{
-			AddFace(x, y, z, x, y+1, z, x, y, z+c, x, y+1, z+c, *col, check);
-		}
-		if (cull & 2)
-		{
-			AddFace(x+1, y+1, z, x+1, y, z, x+1, y+1, z+c, x+1, y, z+c, *col, check);
-		}
-		if (cull & 4)
-		{
-			AddFace(x, y, z, x+1, y, z, x, y, z+c, x+1, y, z+c, *col, check);
-		}
-		if (cull & 8)
-		{
-			AddFace(x+1, y+1, z, x, y+1, z, x+1, y+1, z+c, x, y+1, z+c, *col, check);
-		}
-		z+=c;
-		col+=c;
-	}
-	if (cull & 32)
-	{
-		int z = ztop+zleng-1;
-		AddFace(x+1, y, z+1, x, y, z+1, x+1, y+1, z+1, x, y+1, z+1, voxptr->col[zleng-1], check);
+	case 1:	// +x
+		AddFace(slice+1, a2, b1, slice+1, a1, b1, slice+1, a2, b2, slice+1, a1, b2, color, check);
+		break;
+
+	case 2:	// -y
+		AddFace(a1, slice, b1, a2, slice, b1, a1, slice, b2, a2, slice, b2, color, check);
+		break;
+
+	case 3:	// +y
+		AddFace(a2, slice+1, b1, a1, slice+1, b1, a2, slice+1, b2, a1, slice+1, b2, color, check);
+		break;
+
+	case 4:	// top
+		AddFace(a1, b1, slice, a2, b1, slice, a1, b2, slice, a2, b2, slice, color, check);
+		break;
+
+	case 5:	// bottom
+		AddFace(a2, b1, slice, a1, b1, slice, a2, b2, slice, a1, b2, slice, color, check);
+		break;
 	}
 }
 
 //===========================================================================
 //
-// 
+// One visible face of a single voxel. The 6 directions are the bits of
+// the slab's backfacecull field. 'slice' is the coordinate along the
+// face's normal, a and b the other two (x/y, x/z or y/z).
 //
 //===========================================================================
 
-void FVoxelModel::Initialize()
+struct FVoxelFace
+{
+	int slice;
+	int a, b;
+	BYTE color;
+};
+
+static int CompareVoxelFaces(const void *a, const void *b)
+{
+	return ((const FVoxelFace *)a)->slice - ((const FVoxelFace *)b)->slice;
+}
+
+//===========================================================================
+//
+// Creates the mesh. All visible faces are collected per direction and
+// plane and adjacent faces of the same color are merged into as few
+// rectangles as possible.
+//
+//===========================================================================
+
+void FVoxelModel::BuildMesh()
 {
 	FVoxelMap check;
+	TArray<FVoxelFace> faces[6];
+	TArray<int> mask;
 	FVoxelMipLevel *mip = &mVoxel->Mips[0];
+
 	for (int x = 0; x < mip->SizeX; x++)
 	{
 		BYTE *slabxoffs = &mip->SlabData[mip->OffsetX[x]];
@@ -443,10 +461,291 @@ void FVoxelModel::Initialize()
 			kvxslab_t *voxend = (kvxslab_t *)(slabxoffs + xyoffs[y+1]);
 			for (; voxptr < voxend; voxptr = (kvxslab_t *)((BYTE *)voxptr + voxptr->zleng + 3))
 			{
-				MakeSlabPolys(x, y, voxptr, check);
+				int cull = voxptr->backfacecull;
+				int ztop = voxptr->ztop;
+				int zleng = voxptr->zleng;
+				FVoxelFace face;
+
+				if (zleng == 0) continue;
+				if (cull & 16)
+				{
+					face.slice = ztop; face.a = x; face.b = y; face.color = voxptr->col[0];
+					faces[4].Push(face);
+				}
+				if (cull & 32)
+				{
+					face.slice = ztop + zleng; face.a = x; face.b = y; face.color = voxptr->col[zleng-1];
+					faces[5].Push(face);
+				}
+				for (int z = 0; z < zleng; z++)
+				{
+					face.color = voxptr->col[z];
+					face.slice = x; face.a = y; face.b = ztop + z;
+					if (cull & 1) faces[0].Push(face);
+					if (cull & 2) faces[1].Push(face);
+					face.slice = y; face.a = x;
+					if (cull & 4) faces[2].Push(face);
+					if (cull & 8) faces[3].Push(face);
+				}
 			}
 		}
 	}
+
+	for (int dir = 0; dir < 6; dir++)
+	{
+		TArray<FVoxelFace> &list = faces[dir];
+		if (list.Size() == 0) continue;
+
+		qsort(&list[0], list.Size(), sizeof(FVoxelFace), CompareVoxelFaces);
+
+		for (unsigned first = 0, last; first < list.Size(); first = last)
+		{
+			int mina = list[first].a, maxa = mina;
+			int minb = list[first].b, maxb = minb;
+
+			for (last = first + 1; last < list.Size() && list[last].slice == list[first].slice; last++)
+			{
+				mina = MIN(mina, list[last].a); maxa = MAX(maxa, list[last].a);
+				minb = MIN(minb, list[last].b); maxb = MAX(maxb, list[last].b);
+			}
+
+			int width = maxa - mina + 1;
+			int height = maxb - minb + 1;
+			mask.Resize(width * height);
+			for (unsigned i = 0; i < mask.Size(); i++) mask[i] = -1;
+			for (unsigned i = first; i < last; i++)
+			{
+				mask[(list[i].a - mina) + (list[i].b - minb) * width] = list[i].color;
+			}
+
+			for (int b = 0; b < height; b++)
+			{
+				for (int a = 0; a < width; )
+				{
+					int color = mask[a + b * width];
+					if (color < 0)
+					{
+						a++;
+						continue;
+					}
+
+					int w = 1, h = 1;
+					while (a + w < width && mask[a + w + b * width] == color) w++;
+					for (; b + h < height; h++)
+					{
+						int k;
+						for (k = 0; k < w && mask[a + k + (b + h) * width] == color; k++);
+						if (k < w) break;
+					}
+					for (int j = 0; j < h; j++)
+					{
+						for (int k = 0; k < w; k++) mask[a + k + (b + j) * width] = -1;
+					}
+
+					AddRect(dir, list[first].slice, a + mina, b + minb, a + mina + w, b + minb + h, color, check);
+					a += w;
+				}
+			}
+		}
+	}
+}
+
+//===========================================================================
+//
+// Voxel mesh cache
+//
+// Big voxels take a while to convert so the finished meshes are kept
+// in the cache directory, keyed by the MD5 of the voxel data.
+//
+//===========================================================================
+
+CVAR(Bool, gl_cachevoxels, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+static FThreadLock VoxelCacheLock;
+
+enum { VOXELCACHE_VERSION = 1 };
+
+struct FVoxelCacheHeader
+{
+	char Magic[4];		// "VXLC"
+	DWORD Version;
+	DWORD NumVertices;
+	DWORD NumIndices;
+	DWORD CompressedSize;
+	BYTE Key[16];
+};
+
+static FString CreateVoxelCacheName(const BYTE key[16], bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/voxels";
+	if (create) CreatePath(path);
+
+	path << '/';
+	for (int i = 0; i < 16; i++)
+	{
+		path.AppendFormat("%02x", key[i]);
+	}
+	path << ".vxc";
+	return path;
+}
+
+void FVoxelModel::MakeCacheKey(BYTE key[16])
+{
+	MD5Context md5;
+	FVoxelMipLevel *mip = &mVoxel->Mips[0];
+	// Everything is hashed in little endian order so that the key does not depend on the host.
+	DWORD header[7] = { LittleLong(DWORD(VOXELCACHE_VERSION)), LittleLong(DWORD(mip->SizeX)), LittleLong(DWORD(mip->SizeY)),
+		LittleLong(DWORD(mip->SizeZ)), LittleLong(DWORD(mip->PivotX)), LittleLong(DWORD(mip->PivotY)), LittleLong(DWORD(mip->PivotZ)) };
+	int i, count;
+
+	md5.Update((const BYTE *)header, sizeof(header));
+	for (i = 0, count = mip->SizeX + 1; i < count; i++)
+	{
+		DWORD offset = LittleLong(DWORD(mip->OffsetX[i]));
+		md5.Update((const BYTE *)&offset, sizeof(offset));
+	}
+	for (i = 0, count = mip->SizeX * (mip->SizeY + 1); i < count; i++)
+	{
+		WORD offset = LittleShort(WORD(mip->OffsetXY[i]));
+		md5.Update((const BYTE *)&offset, sizeof(offset));
+	}
+	md5.Update(mip->SlabData, mip->OffsetX[mip->SizeX]);
+	md5.Final(key);
+}
+
+//===========================================================================
+//
+// The mesh is stored as a sequence of little endian DWORDs:
+// 5 per vertex (the floats' bit patterns) followed by the indices.
+//
+//===========================================================================
+
+bool FVoxelModel::ReadCache(const BYTE key[16])
+{
+	FVoxelCacheHeader header;
+	FString path = CreateVoxelCacheName(key, false);
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) return false;
+
+	bool ok = false;
+	if (fread(&header, sizeof(header), 1, f) == 1 &&
+		!memcmp(header.Magic, "VXLC", 4) &&
+		LittleLong(header.Version) == VOXELCACHE_VERSION &&
+		LittleLong(header.NumVertices) < 0x1000000 && LittleLong(header.NumIndices) < 0x4000000 &&
+		!memcmp(header.Key, key, 16))
+	{
+		DWORD numverts = LittleLong(header.NumVertices);
+		DWORD numindices = LittleLong(header.NumIndices);
+		DWORD complen = LittleLong(header.CompressedSize);
+		uLongf datalen = (numverts * 5 + numindices) * 4;
+		BYTE *compressed = new BYTE[complen];
+		DWORD *data = new DWORD[numverts * 5 + numindices];
+
+		if (fread(compressed, 1, complen, f) == complen &&
+			uncompress((Bytef *)data, &datalen, compressed, complen) == Z_OK &&
+			datalen == (numverts * 5 + numindices) * 4)
+		{
+			mVertices.Resize(numverts);
+			for (unsigned i = 0; i < numverts; i++)
+			{
+				DWORD v[5];
+				for (int j = 0; j < 5; j++) v[j] = LittleLong(data[i * 5 + j]);
+				memcpy(&mVertices[i], v, sizeof(v));
+			}
+			mIndices.Resize(numindices);
+			ok = true;
+			for (unsigned i = 0; i < numindices; i++)
+			{
+				mIndices[i] = LittleLong(data[numverts * 5 + i]);
+				if (mIndices[i] >= numverts) ok = false;
+			}
+		}
+		delete[] data;
+		delete[] compressed;
+	}
+	fclose(f);
+
+	if (!ok)
+	{
+		mVertices.Clear();
+		mIndices.Clear();
+	}
+	return ok;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+void FVoxelModel::WriteCache(const BYTE key[16])
+{
+	unsigned count = mVertices.Size() * 5 + mIndices.Size();
+	DWORD *data = new DWORD[count];
+
+	for (unsigned i = 0; i < mVertices.Size(); i++)
+	{
+		DWORD v[5];
+		memcpy(v, &mVertices[i], sizeof(v));
+		for (int j = 0; j < 5; j++) data[i * 5 + j] = LittleLong(v[j]);
+	}
+	for (unsigned i = 0; i < mIndices.Size(); i++)
+	{
+		data[mVertices.Size() * 5 + i] = LittleLong(mIndices[i]);
+	}
+
+	uLongf outlen = compressBound(count * 4);
+	BYTE *compressed = new BYTE[outlen];
+
+	if (compress(compressed, &outlen, (const Bytef *)data, count * 4) == Z_OK)
+	{
+		FVoxelCacheHeader header;
+
+		memcpy(header.Magic, "VXLC", 4);
+		header.Version = LittleLong(DWORD(VOXELCACHE_VERSION));
+		header.NumVertices = LittleLong(mVertices.Size());
+		header.NumIndices = LittleLong(mIndices.Size());
+		header.CompressedSize = LittleLong(DWORD(outlen));
+		memcpy(header.Key, key, 16);
+
+		// Several models may be built at the same time on the worker threads.
+		FThreadLockGuard lock(VoxelCacheLock);
+		FString path = CreateVoxelCacheName(key, true);
+		FILE *f = fopen(path, "wb");
+		if (f != NULL)
+		{
+			bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(compressed, outlen, 1, f) == 1;
+			fclose(f);
+			if (!ok) remove(path);
+		}
+	}
+	delete[] compressed;
+	delete[] data;
+}
+
+//===========================================================================
+//
+// Creates the mesh or gets it from the cache. This gets called on
+// the worker threads so it may not touch anything but the model itself.
+//
+//===========================================================================
+
+void FVoxelModel::Initialize()
+{
+	BYTE key[16];
+
+	if (gl_cachevoxels)
+	{
+		MakeCacheKey(key);
+		if (ReadCache(key)) return;
+	}
+	BuildMesh();
+	if (gl_cachevoxels && mIndices.Size() > 0)
+	{
+		WriteCache(key);
+	}
 }
 
 //===========================================================================
@@ -96,6 +96,8 @@ FGLRenderer::FGLRenderer(OpenGLFrameBuffer *fb)
 	mShaderManager = NULL;
 	glpart2 = glpart = gllight = mirrortexture = NULL;
 	beforeRenderView = afterRenderView = NULL;
+	m2DBatchCount = m2DQuadCount = 0;
+	m2DLastBatchCount = m2DLastQuadCount = 0;
 }
 
 void FGLRenderer::Initialize()
@@ -111,6 +113,7 @@ void FGLRenderer::Initialize()
 	SetupLevel();
 	mShaderManager = new FShaderManager;
 	//mThreadManager = new FGLThreadManager;
+	gl_PruneHQResizeCache();
 }
 
 FGLRenderer::~FGLRenderer() 
@@ -141,6 +144,7 @@ void FGLRenderer::SetupLevel()
 
 void FGLRenderer::Begin2D()
 {
+	Flush();
 	gl_RenderState.EnableFog(false);
 	gl_RenderState.Set2DMode(true);
 }
@@ -202,6 +206,7 @@ void FGLRenderer::ProcessSector(sector_t *fakesector)
 
 void FGLRenderer::FlushTextures()
 {
+	Flush();
 	FMaterial::FlushAll();
 }
 
@@ -261,6 +266,7 @@ unsigned char *FGLRenderer::GetTextureBuffer(FTexture *tex, int &w, int &h)
 
 void FGLRenderer::ClearBorders()
 {
+	Flush();
 	OpenGLFrameBuffer *glscreen = static_cast<OpenGLFrameBuffer*>(screen);
 
 	// Letterbox time! Draw black top and bottom borders.
@@ -303,8 +309,21 @@ void FGLRenderer::ClearBorders()
 //
 // Draws a texture
 //
+// Plain textures are not drawn right away but collected into a batch
+// as long as they share texture, translation, clipping, render style and
+// color. Status bars and text mostly draw the same font or graphic many
+// times in a row, so this saves a lot of state changes. The draw order
+// is never changed.
+//
 //==========================================================================
 
+bool FGLRenderer::F2DBatchState::operator== (const F2DBatchState &other) const
+{
+	return Texture == other.Texture && Translation == other.Translation &&
+		AlphaChannel == other.AlphaChannel && Masked == other.Masked && Style == other.Style &&
+		!memcmp(Clip, other.Clip, sizeof(Clip)) && !memcmp(Color, other.Color, sizeof(Color));
+}
+
 void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 {
 	double xscale = parms.destwidth / parms.texwidth;
@@ -315,6 +334,7 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 	double h = parms.destheight;
 	float u1, v1, u2, v2, r, g, b;
 	float light = 1.f;
+	int translation = 0;
 
 	FMaterial * gltex = FMaterial::ValidateTexture(img);
 
@@ -329,20 +349,12 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 	{
 		if (!parms.alphaChannel) 
 		{
-			int translation = 0;
 			if (parms.remap != NULL && !parms.remap->Inactive)
 			{
 				GLTranslationPalette * pal = static_cast<GLTranslationPalette*>(parms.remap->GetNative());
 				if (pal) translation = -pal->GetIndex();
 			}
-			gltex->BindPatch(CM_DEFAULT, translation);
 		}
-		else 
-		{
-			// This is an alpha texture
-			gltex->BindPatch(CM_SHADE, 0);
-		}
-
 		u1 = gltex->GetUL();
 		v1 = gltex->GetVT();
 		u2 = gltex->GetUR();
@@ -350,11 +362,9 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 	}
 	else
 	{
-		gltex->Bind(CM_DEFAULT, 0, 0);
 		u2=1.f;
 		v2=-1.f;
 		u1 = v1 = 0.f;
-		gl_RenderState.SetTextureMode(TM_OPAQUE);
 	}
 	
 	if (parms.flipX)
@@ -384,6 +394,63 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 	{
 		r = g = b = light;
 	}
+
+	if (!img->bHasCanvas && !parms.colorOverlay)
+	{
+		F2DBatchState state;
+		F2DQuad quad;
+
+		state.Texture = gltex;
+		state.Translation = translation;
+		state.AlphaChannel = !!parms.alphaChannel;
+		state.Masked = !!parms.masked;
+		state.Style = parms.style.AsDWORD;
+		state.Clip[0] = parms.lclip;
+		state.Clip[1] = parms.uclip;
+		state.Clip[2] = parms.rclip;
+		state.Clip[3] = parms.dclip;
+		state.Color[0] = r;
+		state.Color[1] = g;
+		state.Color[2] = b;
+		state.Color[3] = FIXED2FLOAT(parms.alpha);
+
+		if (m2DBatch.Size() > 0 && !(state == m2DBatchState))
+		{
+			Flush();
+		}
+		m2DBatchState = state;
+		quad.x1 = float(x);
+		quad.y1 = float(y);
+		quad.x2 = float(x + w);
+		quad.y2 = float(y + h);
+		quad.u1 = u1;
+		quad.v1 = v1;
+		quad.u2 = u2;
+		quad.v2 = v2;
+		m2DBatch.Push(quad);
+		return;
+	}
+
+	// Camera textures and color overlays are drawn immediately.
+	Flush();
+
+	if (!img->bHasCanvas)
+	{
+		if (!parms.alphaChannel) 
+		{
+			gltex->BindPatch(CM_DEFAULT, translation);
+		}
+		else 
+		{
+			// This is an alpha texture
+			gltex->BindPatch(CM_SHADE, 0);
+		}
+	}
+	else
+	{
+		gltex->Bind(CM_DEFAULT, 0, 0);
+		gl_RenderState.SetTextureMode(TM_OPAQUE);
+	}
 	
 	// scissor test doesn't use the current viewport for the coordinates, so use real screen coordinates
 	int btm = (SCREENHEIGHT - screen->GetHeight()) / 2;
@@ -442,6 +509,84 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 	gl_RenderState.BlendEquation(GL_FUNC_ADD);
 }
 
+//==========================================================================
+//
+// Draws all batched 2D textures. This must be called before anything
+// else gets drawn.
+//
+//==========================================================================
+
+void FGLRenderer::Flush()
+{
+	if (m2DBatch.Size() == 0)
+	{
+		return;
+	}
+
+	F2DBatchState &state = m2DBatchState;
+	FRenderStyle style;
+
+	style.AsDWORD = state.Style;
+	if (!state.AlphaChannel)
+	{
+		state.Texture->BindPatch(CM_DEFAULT, state.Translation);
+	}
+	else
+	{
+		// This is an alpha texture
+		state.Texture->BindPatch(CM_SHADE, 0);
+	}
+
+	// scissor test doesn't use the current viewport for the coordinates, so use real screen coordinates
+	int btm = (SCREENHEIGHT - screen->GetHeight()) / 2;
+	btm = SCREENHEIGHT - btm;
+
+	glEnable(GL_SCISSOR_TEST);
+	int space = (static_cast<OpenGLFrameBuffer*>(screen)->GetTrueHeight()-screen->GetHeight())/2;
+	glScissor(state.Clip[0], btm - state.Clip[3] + space, state.Clip[2] - state.Clip[0], state.Clip[3] - state.Clip[1]);
+
+	gl_SetRenderStyle(style, !state.Masked, false);
+	glColor4f(state.Color[0], state.Color[1], state.Color[2], state.Color[3]);
+
+	gl_RenderState.EnableAlphaTest(false);
+	gl_RenderState.Apply();
+	glBegin(GL_QUADS);
+	for (unsigned i = 0; i < m2DBatch.Size(); i++)
+	{
+		const F2DQuad &q = m2DBatch[i];
+		glTexCoord2f(q.u1, q.v1);
+		glVertex2f(q.x1, q.y1);
+		glTexCoord2f(q.u1, q.v2);
+		glVertex2f(q.x1, q.y2);
+		glTexCoord2f(q.u2, q.v2);
+		glVertex2f(q.x2, q.y2);
+		glTexCoord2f(q.u2, q.v1);
+		glVertex2f(q.x2, q.y1);
+	}
+	glEnd();
+	gl_RenderState.EnableAlphaTest(true);
+
+	glScissor(0, 0, screen->GetWidth(), screen->GetHeight());
+	glDisable(GL_SCISSOR_TEST);
+	gl_RenderState.SetTextureMode(TM_MODULATE);
+	gl_RenderState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gl_RenderState.BlendEquation(GL_FUNC_ADD);
+
+	m2DBatchCount++;
+	m2DQuadCount += m2DBatch.Size();
+	m2DBatch.Clear();
+}
+
+ADD_STAT(2dbatch)
+{
+	FString out;
+	if (GLRenderer != NULL)
+	{
+		out.Format("2D batches: %d, quads: %d", GLRenderer->m2DLastBatchCount, GLRenderer->m2DLastQuadCount);
+	}
+	return out;
+}
+
 //==========================================================================
 //
 //
@@ -449,6 +594,7 @@ void FGLRenderer::DrawTexture(FTexture *img, DCanvas::DrawParms &parms)
 //==========================================================================
 void FGLRenderer::DrawLine(int x1, int y1, int x2, int y2, int palcolor, uint32 color)
 {
+	Flush();
 	PalEntry p = color? (PalEntry)color : GPalette.BaseColors[palcolor];
 	gl_RenderState.EnableTexture(false);
 	gl_RenderState.Apply(true);
@@ -467,6 +613,7 @@ void FGLRenderer::DrawLine(int x1, int y1, int x2, int y2, int palcolor, uint32
 //==========================================================================
 void FGLRenderer::DrawPixel(int x1, int y1, int palcolor, uint32 color)
 {
+	Flush();
 	PalEntry p = color? (PalEntry)color : GPalette.BaseColors[palcolor];
 	gl_RenderState.EnableTexture(false);
 	gl_RenderState.Apply(true);
@@ -485,6 +632,7 @@ void FGLRenderer::DrawPixel(int x1, int y1, int palcolor, uint32 color)
 
 void FGLRenderer::Dim(PalEntry color, float damount, int x1, int y1, int w, int h)
 {
+	Flush();
 	float r, g, b;
 	
 	gl_RenderState.EnableTexture(false);
@@ -514,6 +662,7 @@ void FGLRenderer::Dim(PalEntry color, float damount, int x1, int y1, int w, int
 //==========================================================================
 void FGLRenderer::FlatFill (int left, int top, int right, int bottom, FTexture *src, bool local_origin)
 {
+	Flush();
 	float fU1,fU2,fV1,fV2;
 
 	FMaterial *gltexture=FMaterial::ValidateTexture(src);
@@ -554,6 +703,7 @@ void FGLRenderer::FlatFill (int left, int top, int right, int bottom, FTexture *
 //==========================================================================
 void FGLRenderer::Clear(int left, int top, int right, int bottom, int palcolor, uint32 color)
 {
+	Flush();
 	int rt;
 	int offY = 0;
 	PalEntry p = palcolor==-1 || color != 0? (PalEntry)color : GPalette.BaseColors[palcolor];
@@ -595,6 +745,7 @@ void FGLRenderer::FillSimplePoly(FTexture *texture, FVector2 *points, int npoint
 	double originx, double originy, double scalex, double scaley,
 	angle_t rotation, FDynamicColormap *colormap, int lightlevel)
 {
+	Flush();
 	if (npoints < 3)
 	{ // This is no polygon.
 		return;
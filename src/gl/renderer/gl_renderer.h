@@ -8,6 +8,7 @@
 
 struct particle_t;
 class FCanvasTexture;
+class FMaterial;
 class FFlatVertexBuffer;
 class OpenGLFrameBuffer;
 struct FDrawInfo;
@@ -73,6 +74,32 @@ public:
 	void (*beforeRenderView)();
 	void (*afterRenderView)();
 
+	// 2D textures that share texture, clipping and render state are
+	// collected here and drawn together by Flush.
+	struct F2DQuad
+	{
+		float x1, y1, x2, y2;
+		float u1, v1, u2, v2;
+	};
+
+	struct F2DBatchState
+	{
+		FMaterial *Texture;
+		int Translation;
+		bool AlphaChannel;
+		bool Masked;
+		DWORD Style;
+		int Clip[4];
+		float Color[4];
+
+		bool operator== (const F2DBatchState &other) const;
+	};
+
+	F2DBatchState m2DBatchState;
+	TArray<F2DQuad> m2DBatch;
+	int m2DBatchCount, m2DQuadCount;			// for the current frame
+	int m2DLastBatchCount, m2DLastQuadCount;	// for the previous frame
+
 
 	FGLRenderer(OpenGLFrameBuffer *fb);
 	~FGLRenderer() ;
@@ -118,7 +145,7 @@ public:
 	void SetFixedColormap (player_t *player);
 	void WriteSavePic (player_t *player, FILE *file, int width, int height);
 	void EndDrawScene(sector_t * viewsector);
-	void Flush() {}
+	void Flush();
 
 	void SetProjection(float fov, float ratio, float fovratio);
 	void SetViewMatrix(fixed_t viewx, fixed_t viewy, fixed_t viewz, bool mirror, bool planemirror);
@@ -134,6 +161,7 @@ public:
 
 // Global functions. Make them members of GLRenderer later?
 void gl_RenderBSPNode (void *node);
+void gl_ProcessWallJobs();
 bool gl_CheckClip(side_t * sidedef, sector_t * frontsector, sector_t * backsector);
 void gl_CheckViewArea(vertex_t *v1, vertex_t *v2, sector_t *frontsector, sector_t *backsector);
 
@@ -52,8 +52,10 @@
 #include "gl/scene/gl_portal.h"
 #include "gl/scene/gl_wall.h"
 #include "gl/utility/gl_clock.h"
+#include "threadpool.h"
 
 EXTERN_CVAR(Bool, gl_render_segs)
+EXTERN_CVAR(Bool, gl_seamless)
 
 Clipper clipper;
 
@@ -61,6 +63,125 @@ Clipper clipper;
 CVAR(Bool, gl_render_things, true, 0)
 CVAR(Bool, gl_render_walls, true, 0)
 CVAR(Bool, gl_render_flats, true, 0)
+// Off by default: the wall setup can still create texture buffers on the
+// workers (FMaterial::CheckTransparent) and the hires replacement lookup
+// done there may add files to the WAD directory, which is not thread safe.
+CVAR(Bool, gl_multithreading, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+
+// making these 2 variables global instead of passing them as function parameters is faster.
+static subsector_t *currentsubsector;
+static sector_t *currentsector;
+
+//==========================================================================
+//
+// Wall processing on worker threads
+//
+// The BSP traversal has to remain serial because it does the occlusion
+// clipping, but the walls it finds are only queued. Once the traversal
+// is done they get set up in parallel, in chunks, and each chunk's result
+// is committed to the draw lists in traversal order.
+//
+//==========================================================================
+
+struct FWallJob
+{
+	seg_t *seg;
+	subsector_t *sub;
+	sector_t *frontsector;
+	sector_t *backsector;
+};
+
+enum
+{
+	WALLS_PER_CHUNK = 32
+};
+
+static TArray<FWallJob> WallJobs;
+static TDeletingArray<FWallOutput *> WallOutputs;
+static TDeletingArray<sector_t *> SectorCopies;
+static unsigned int NumSectorCopies;
+static sector_t *currentsectorcopy;
+
+//==========================================================================
+//
+// gl_FakeFlat returns temporary copies for sectors with height transfers
+// and those will be gone by the time the wall is processed.
+//
+//==========================================================================
+
+static sector_t *KeepSector(sector_t *sec)
+{
+	if (sec == NULL || sec == &sectors[sec->sectornum]) return sec;
+
+	if (NumSectorCopies == SectorCopies.Size())
+	{
+		SectorCopies.Push(new sector_t);
+	}
+	sector_t *copy = SectorCopies[NumSectorCopies++];
+	*copy = *sec;
+	return copy;
+}
+
+static void QueueWall(seg_t *seg, sector_t *backsector)
+{
+	FWallJob job;
+
+	if (currentsectorcopy == NULL)
+	{
+		currentsectorcopy = KeepSector(currentsector);
+	}
+	job.seg = seg;
+	job.sub = currentsubsector;
+	job.frontsector = currentsectorcopy;
+	job.backsector = backsector == currentsector ? currentsectorcopy : KeepSector(backsector);
+
+	// Vertices are shared between walls so this can't be left to the workers.
+	if (gl_seamless && !(seg->sidedef->Flags & WALLF_POLYOBJ))
+	{
+		if (seg->linedef->v1->dirty) gl_RecalcVertexHeights(seg->linedef->v1);
+		if (seg->linedef->v2->dirty) gl_RecalcVertexHeights(seg->linedef->v2);
+	}
+	WallJobs.Push(job);
+}
+
+static void ProcessWallChunk(void *, int chunk)
+{
+	unsigned int start = chunk * WALLS_PER_CHUNK;
+	unsigned int end = MIN<unsigned int>(start + WALLS_PER_CHUNK, WallJobs.Size());
+	FWallOutput *output = WallOutputs[chunk];
+
+	for (unsigned int i = start; i < end; i++)
+	{
+		FWallJob &job = WallJobs[i];
+		GLWall wall;
+		wall.sub = job.sub;
+		wall.Process(job.seg, job.frontsector, job.backsector, output);
+	}
+}
+
+void gl_ProcessWallJobs()
+{
+	if (WallJobs.Size() > 0)
+	{
+		int numchunks = (WallJobs.Size() + WALLS_PER_CHUNK - 1) / WALLS_PER_CHUNK;
+
+		SetupWall.Clock();
+		while (WallOutputs.Size() < (unsigned)numchunks)
+		{
+			WallOutputs.Push(new FWallOutput);
+		}
+		ThreadPool.ParallelFor(numchunks, ProcessWallChunk, NULL);
+		for (int i = 0; i < numchunks; i++)
+		{
+			WallOutputs[i]->Commit();
+			WallOutputs[i]->Clear();
+		}
+		WallJobs.Clear();
+		SetupWall.Unclock();
+	}
+	NumSectorCopies = 0;
+}
 
 
 static void UnclipSubsector(subsector_t *sub)
@@ -90,10 +211,6 @@ static void UnclipSubsector(subsector_t *sub)
 //
 //==========================================================================
 
-// making these 2 variables global instead of passing them as function parameters is faster.
-static subsector_t *currentsubsector;
-static sector_t *currentsector;
-
 static void AddLine (seg_t *seg)
 {
 #ifdef _DEBUG
@@ -186,20 +303,16 @@ static void AddLine (seg_t *seg)
 		{
 			SetupWall.Clock();
 
-			//if (!gl_multithreading)
+			if (!gl_multithreading || ThreadPool.GetNumThreads() < 2)
 			{
 				GLWall wall;
 				wall.sub = currentsubsector;
 				wall.Process(seg, currentsector, backsector);
 			}
-			/*
 			else
 			{
-				FJob *job = new FGLJobProcessWall(currentsubsector, seg, 
-					currentsector->sectornum, backsector != NULL? backsector->sectornum : -1);
-				GLRenderer->mThreadManager->AddJob(job);
+				QueueWall(seg, backsector);
 			}
-			*/
 			rendered_lines++;
 
 			SetupWall.Unclock();
@@ -305,6 +418,7 @@ static inline void AddLines(subsector_t * sub, sector_t * sector)
 {
 	currentsector = sector;
 	currentsubsector = sub;
+	currentsectorcopy = NULL;
 
 	ClipWall.Clock();
 	if (sub->polys != NULL)
@@ -410,11 +524,6 @@ static void DoSubsector(subsector_t * sub)
 
 	fakesector=gl_FakeFlat(sector, &fake, false);
 
-	if (sector->validcount != validcount)
-	{
-		GLRenderer->mVBO->CheckUpdate(sector);
-	}
-
 	// [RH] Add particles
 	//int shade = LIGHT2SHADE((floorlightlevel + ceilinglightlevel)/2 + r_actualextralight);
 	if (gl_render_things)
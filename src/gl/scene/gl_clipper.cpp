@@ -35,50 +35,35 @@
 **
 */
 
+#include "gl/system/gl_system.h"
+#include "c_dispatch.h"
+#include "stats.h"
 #include "gl/scene/gl_clipper.h"
 
 
 
-ClipNode * ClipNode::freelist;
 int Clipper::anglecache;
 
 
 //-----------------------------------------------------------------------------
 //
-// Destructor
+// Returns the index of the first range that ends at or after the
+// given angle. Ranges ending before it can never be affected by anything
+// that starts there.
 //
 //-----------------------------------------------------------------------------
 
-Clipper::~Clipper()
+unsigned Clipper::FindEnd(const TArray<ClipRange> &list, angle_t angle)
 {
-	Clear();
-	while (ClipNode::freelist != NULL)
-	{
-		ClipNode * node = ClipNode::freelist;
-		ClipNode::freelist = node->next;
-		delete node;
-	}
-}
-
-//-----------------------------------------------------------------------------
-//
-// RemoveRange
-//
-//-----------------------------------------------------------------------------
+	unsigned lo = 0, hi = list.Size();
 
-void Clipper::RemoveRange(ClipNode * range)
-{
-	if (range == cliphead)
+	while (lo < hi)
 	{
-		cliphead = cliphead->next;
+		unsigned mid = (lo + hi) >> 1;
+		if (list[mid].end < angle) lo = mid + 1;
+		else hi = mid;
 	}
-	else
-	{
-		if (range->prev) range->prev->next = range->next;
-		if (range->next) range->next->prev = range->prev;
-	}
-	
-	range->Free();
+	return lo;
 }
 
 //-----------------------------------------------------------------------------
@@ -89,26 +74,9 @@ void Clipper::RemoveRange(ClipNode * range)
 
 void Clipper::Clear()
 {
-	ClipNode *node = cliphead;
-	ClipNode *temp;
-	
-	while (node != NULL)
-	{
-		temp = node;
-		node = node->next;
-		temp->Free();
-	}
-	node = silhouette;
-
-	while (node != NULL)
-	{
-		temp = node;
-		node = node->next;
-		temp->Free();
-	}
-	
-	cliphead = NULL;
-	silhouette = NULL;
+	if (Recording != NULL) Record(REC_CLEAR, 0, 0);
+	ranges.Clear();
+	silhouette.Clear();
 	anglecache++;
 }
 
@@ -120,17 +88,10 @@ void Clipper::Clear()
 
 void Clipper::SetSilhouette()
 {
-	ClipNode *node = cliphead;
-	ClipNode *last = NULL;
-
-	while (node != NULL)
+	if (Recording != NULL) Record(REC_SILHOUETTE, 0, 0);
+	if (silhouette.Size() == 0)
 	{
-		ClipNode *snode = ClipNode::NewRange(node->start, node->end);
-		if (silhouette == NULL) silhouette = snode;
-		snode->prev = last;
-		if (last != NULL) last->next = snode;
-		last = snode;
-		node = node->next;
+		silhouette = ranges;
 	}
 }
 
@@ -143,21 +104,29 @@ void Clipper::SetSilhouette()
 
 bool Clipper::IsRangeVisible(angle_t startAngle, angle_t endAngle)
 {
-	ClipNode *ci;
-	ci = cliphead;
-	
-	if (endAngle==0 && ci && ci->start==0) return false;
-	
-	while (ci != NULL && ci->start < endAngle)
+	bool visible = true;
+
+	if (endAngle==0)
 	{
-		if (startAngle >= ci->start && endAngle <= ci->end)
+		if (ranges.Size() > 0 && ranges[0].start==0) visible = false;
+	}
+	else
+	{
+		// Only ranges starting before both angles can cover the range and of those
+		// the last one reaches farthest.
+		angle_t limit = MIN(startAngle, endAngle - 1);
+		unsigned lo = 0, hi = ranges.Size();
+
+		while (lo < hi)
 		{
-			return false;
+			unsigned mid = (lo + hi) >> 1;
+			if (ranges[mid].start <= limit) lo = mid + 1;
+			else hi = mid;
 		}
-		ci = ci->next;
+		if (lo > 0 && ranges[lo-1].end >= endAngle) visible = false;
 	}
-	
-	return true;
+	if (Recording != NULL) Record(REC_CHECK, startAngle, endAngle, visible);
+	return visible;
 }
 
 //-----------------------------------------------------------------------------
@@ -168,100 +137,62 @@ bool Clipper::IsRangeVisible(angle_t startAngle, angle_t endAngle)
 
 void Clipper::AddClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node, *temp, *prevNode;
+	unsigned count = ranges.Size();
+	unsigned first = FindEnd(ranges, start);
+	unsigned i, j;
+
+	if (Recording != NULL) Record(REC_ADD, start, end);
 
-	if (cliphead)
+	//check to see if range contains any old ranges
+	for (i = j = first; i < count && ranges[i].start < end; i++)
 	{
-		//check to see if range contains any old ranges
-		node = cliphead;
-		while (node != NULL && node->start < end)
+		if (ranges[i].start >= start && ranges[i].end <= end)
 		{
-			if (node->start >= start && node->end <= end)
-			{
-				temp = node;
-				node = node->next;
-				RemoveRange(temp);
-			}
-			else if (node->start<=start && node->end>=end)
-			{
-				return;
-			}
-			else
-			{
-				node = node->next;
-			}
+			continue;
 		}
-		
-		//check to see if range overlaps a range (or possibly 2)
-		node = cliphead;
-		while (node != NULL && node->start <= end)
+		else if (ranges[i].start <= start && ranges[i].end >= end)
 		{
-			if (node->end >= start)
-			{
-				// we found the first overlapping node
-				if (node->start > start)
-				{
-					// the new range overlaps with this node's start point
-					node->start = start;
-				}
-
-				if (node->end < end) 
-				{
-					node->end = end;
-				}
-
-				ClipNode *node2 = node->next;
-				while (node2 && node2->start <= node->end)
-				{
-					if (node2->end > node->end) node->end = node2->end;
-					ClipNode *delnode = node2;
-					node2 = node2->next;
-					RemoveRange(delnode);
-				}
-				return;
-			}
-			node = node->next;		
-		}
-		
-		//just add range
-		node = cliphead;
-		prevNode = NULL;
-		temp = ClipNode::NewRange(start, end);
-		
-		while (node != NULL && node->start < end)
-		{
-			prevNode = node;
-			node = node->next;
-		}
-		
-		temp->next = node;
-		if (node == NULL)
-		{
-			temp->prev = prevNode;
-			if (prevNode) prevNode->next = temp;
-			if (!cliphead) cliphead = temp;
+			break;
 		}
-		else
+		ranges[j++] = ranges[i];
+	}
+	if (i < count && ranges[i].start < end)
+	{
+		// already covered completely.
+		ranges.Delete(j, i - j);
+		return;
+	}
+	ranges.Delete(j, i - j);
+	count = ranges.Size();
+
+	//check to see if range overlaps a range (or possibly 2)
+	i = FindEnd(ranges, start);
+	if (i < count && ranges[i].start <= end)
+	{
+		// we found the first overlapping range
+		ClipRange &range = ranges[i];
+
+		if (range.start > start) range.start = start;
+		if (range.end < end) range.end = end;
+
+		for (j = i + 1; j < count && ranges[j].start <= range.end; j++)
 		{
-			if (node == cliphead)
-			{
-				cliphead->prev = temp;
-				cliphead = temp;
-			}
-			else
-			{
-				temp->prev = prevNode;
-				prevNode->next = temp;
-				node->prev = temp;
-			}
+			if (ranges[j].end > range.end) range.end = ranges[j].end;
 		}
+		ranges.Delete(i + 1, j - i - 1);
+		return;
 	}
-	else
+
+	//just add range
+	unsigned lo = i, hi = count;
+	while (lo < hi)
 	{
-		temp = ClipNode::NewRange(start, end);
-		cliphead = temp;
-		return;
+		unsigned mid = (lo + hi) >> 1;
+		if (ranges[mid].start < end) lo = mid + 1;
+		else hi = mid;
 	}
+	ClipRange newrange = { start, end };
+	ranges.Insert(lo, newrange);
 }
 
 
@@ -273,26 +204,28 @@ void Clipper::AddClipRange(angle_t start, angle_t end)
 
 void Clipper::RemoveClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node;
+	if (Recording != NULL) Record(REC_REMOVE, start, end);
 
-	if (silhouette)
+	if (silhouette.Size() > 0)
 	{
-		node = silhouette;
-		while (node != NULL && node->end <= start)
+		unsigned count = silhouette.Size();
+		unsigned i = 0;
+
+		while (i < count && silhouette[i].end <= start)
 		{
-			node = node->next;
+			i++;
 		}
-		if (node != NULL && node->start <= start)
+		if (i < count && silhouette[i].start <= start)
 		{
-			if (node->end >= end) return;
-			start = node->end;
-			node = node->next;
+			if (silhouette[i].end >= end) return;
+			start = silhouette[i].end;
+			i++;
 		}
-		while (node != NULL && node->start < end)
+		while (i < count && silhouette[i].start < end)
 		{
-			DoRemoveClipRange(start, node->start);
-			start = node->end;
-			node = node->next;
+			DoRemoveClipRange(start, silhouette[i].start);
+			start = silhouette[i].end;
+			i++;
 		}
 		if (start >= end) return;
 	}
@@ -307,54 +240,201 @@ void Clipper::RemoveClipRange(angle_t start, angle_t end)
 
 void Clipper::DoRemoveClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node, *temp;
+	unsigned count = ranges.Size();
+	unsigned i, j;
 
-	if (cliphead)
+	//check to see if range contains any old ranges
+	for (i = j = FindEnd(ranges, start); i < count && ranges[i].start < end; i++)
 	{
-		//check to see if range contains any old ranges
-		node = cliphead;
-		while (node != NULL && node->start < end)
+		if (ranges[i].start < start || ranges[i].end > end)
 		{
-			if (node->start >= start && node->end <= end)
-			{
-				temp = node;
-				node = node->next;
-				RemoveRange(temp);
-			}
-			else
-			{
-				node = node->next;
-			}
+			ranges[j++] = ranges[i];
+		}
+	}
+	ranges.Delete(j, i - j);
+	count = ranges.Size();
+
+	//check to see if range overlaps a range (or possibly 2)
+	for (i = FindEnd(ranges, start); i < count && ranges[i].start <= end; i++)
+	{
+		ClipRange &range = ranges[i];
+
+		if (range.start >= start)
+		{
+			range.start = end;
+			break;
 		}
-		
-		//check to see if range overlaps a range (or possibly 2)
-		node = cliphead;
-		while (node != NULL)
+		else if (range.end <= end)
 		{
-			if (node->start >= start && node->start <= end)
-			{
-				node->start = end;
-				break;
-			}
-			else if (node->end >= start && node->end <= end)
-			{
-				node->end=start;
-			}
-			else if (node->start < start && node->end > end)
+			range.end = start;
+		}
+		else
+		{
+			ClipRange newrange = { end, range.end };
+			range.end = start;
+			ranges.Insert(i + 1, newrange);
+			break;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//
+// Benchmark support
+//
+//-----------------------------------------------------------------------------
+
+void Clipper::Record(int op, angle_t a, angle_t b, bool result)
+{
+	Recorded rec = { BYTE(op), BYTE(result), a, b };
+	Recording->Push(rec);
+}
+
+bool Clipper::Replay(const Recorded &rec)
+{
+	switch (rec.op)
+	{
+	case REC_CLEAR:
+		Clear();
+		break;
+
+	case REC_SILHOUETTE:
+		SetSilhouette();
+		break;
+
+	case REC_CHECK:
+		return IsRangeVisible(rec.a, rec.b);
+
+	case REC_ADD:
+		AddClipRange(rec.a, rec.b);
+		break;
+
+	case REC_REMOVE:
+		RemoveClipRange(rec.a, rec.b);
+		break;
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+//
+// gl_recordclipper writes all clipper operations of one frame to a file.
+// gl_benchclipper replays such a file and checks that the results
+// are still the same. This doesn't need a level to be loaded.
+//
+//-----------------------------------------------------------------------------
+
+static const char ClipperLogMagic[4] = { 'G', 'L', 'C', 'L' };
+static FString ClipperRecordFile;
+static bool ClipperRecordPending;
+static TArray<Clipper::Recorded> ClipperLog;
+
+CCMD(gl_recordclipper)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: gl_recordclipper <filename>\n");
+		return;
+	}
+	ClipperRecordFile = argv[1];
+	ClipperRecordPending = true;
+}
+
+void gl_ClipperBeginFrame()
+{
+	if (ClipperRecordPending)
+	{
+		ClipperRecordPending = false;
+		ClipperLog.Clear();
+		clipper.Recording = &ClipperLog;
+	}
+}
+
+void gl_ClipperEndFrame()
+{
+	if (clipper.Recording != NULL)
+	{
+		clipper.Recording = NULL;
+
+		FILE *f = fopen(ClipperRecordFile, "wb");
+		if (f == NULL)
+		{
+			Printf("Unable to create %s\n", ClipperRecordFile.GetChars());
+			return;
+		}
+		DWORD count = ClipperLog.Size();
+		fwrite(ClipperLogMagic, 1, 4, f);
+		fwrite(&count, sizeof(count), 1, f);
+		fwrite(&ClipperLog[0], sizeof(Clipper::Recorded), count, f);
+		fclose(f);
+		Printf("%u clipper operations written to %s\n", count, ClipperRecordFile.GetChars());
+		ClipperLog.Clear();
+	}
+}
+
+CCMD(gl_benchclipper)
+{
+	TArray<Clipper::Recorded> log;
+	char magic[4];
+	DWORD count = 0;
+
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: gl_benchclipper <filename> [repeats]\n");
+		return;
+	}
+	int repeats = argv.argc() > 2 ? MAX(1, atoi(argv[2])) : 100;
+
+	FILE *f = fopen(argv[1], "rb");
+	if (f == NULL)
+	{
+		Printf("Unable to open %s\n", argv[1]);
+		return;
+	}
+	if (fread(magic, 1, 4, f) != 4 || memcmp(magic, ClipperLogMagic, 4) || fread(&count, sizeof(count), 1, f) != 1)
+	{
+		Printf("%s is not a clipper recording\n", argv[1]);
+		fclose(f);
+		return;
+	}
+	log.Resize(count);
+	if (count > 0 && fread(&log[0], sizeof(Clipper::Recorded), count, f) != count)
+	{
+		Printf("%s is truncated\n", argv[1]);
+		fclose(f);
+		return;
+	}
+	fclose(f);
+
+	Clipper bench;
+	cycle_t timer;
+	int checks = 0, mismatches = 0;
+
+	timer.Reset();
+	timer.Clock();
+	for (int i = 0; i < repeats; i++)
+	{
+		bench.Clear();
+		for (unsigned j = 0; j < count; j++)
+		{
+			bool result = bench.Replay(log[j]);
+			if (log[j].op == Clipper::REC_CHECK && i == 0)
 			{
-				temp=ClipNode::NewRange(end, node->end);
-				node->end=start;
-				temp->next=node->next;
-				temp->prev=node;
-				node->next=temp;
-				if (temp->next) temp->next->prev=temp;
-				break;
+				checks++;
+				if (result != !!log[j].result) mismatches++;
 			}
-			node = node->next;
 		}
 	}
-}
+	timer.Unclock();
 
+	Printf("%u operations (%d checks) x %d: %.3f ms, %.1f ns per operation\n", count, checks, repeats,
+		timer.TimeMS(), count > 0 ? timer.TimeMS() * 1e6 / (double(count) * repeats) : 0.);
+	if (mismatches > 0)
+	{
+		Printf("%d checks returned a different result than recorded\n", mismatches);
+	}
+}
 
 //-----------------------------------------------------------------------------
 //
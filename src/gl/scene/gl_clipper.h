@@ -6,75 +6,61 @@
 #include "xs_Float.h"
 #include "r_utility.h"
 
-class ClipNode
+//-----------------------------------------------------------------------------
+//
+// The clipper keeps the occluded pseudo-angle ranges as a sorted array of
+// intervals. Neither their starts nor their ends ever decrease from one
+// entry to the next, so all lookups can use a binary search.
+//
+//-----------------------------------------------------------------------------
+
+struct ClipRange
 {
-	friend class Clipper;
-	friend class ClipNodesFreer;
-	
-	ClipNode *prev, *next;
 	angle_t start, end;
-	static ClipNode * freelist;
-
-	bool operator== (const ClipNode &other)
-	{
-		return other.start == start && other.end == end;
-	}
-
-	void Free()
-	{
-		next=freelist;
-		freelist=this;
-	}
-
-	static ClipNode * GetNew()
-	{
-		if (freelist)
-		{
-			ClipNode * p=freelist;
-			freelist=p->next;
-			return p;
-		}
-		else return new ClipNode;
-	}
-
-	static ClipNode * NewRange(angle_t start, angle_t end)
-	{
-		ClipNode * c=GetNew();
-
-		c->start=start;
-		c->end=end;
-		c->next=c->prev=NULL;
-		return c;
-	}
-
 };
 
-
 class Clipper
 {
-	ClipNode * clipnodes;
-	ClipNode * cliphead;
-	ClipNode * silhouette;	// will be preserved even when RemoveClipRange is called
+	TArray<ClipRange> ranges;
+	TArray<ClipRange> silhouette;	// will be preserved even when RemoveClipRange is called
 
 	static angle_t AngleToPseudo(angle_t ang);
+	static unsigned FindEnd(const TArray<ClipRange> &list, angle_t angle);
 	bool IsRangeVisible(angle_t startangle, angle_t endangle);
-	void RemoveRange(ClipNode * cn);
 	void AddClipRange(angle_t startangle, angle_t endangle);
 	void RemoveClipRange(angle_t startangle, angle_t endangle);
 	void DoRemoveClipRange(angle_t start, angle_t end);
+	void Record(int op, angle_t a, angle_t b, bool result = false);
 
 public:
 
 	static int anglecache;
 
+	enum
+	{
+		REC_CLEAR,
+		REC_SILHOUETTE,
+		REC_CHECK,
+		REC_ADD,
+		REC_REMOVE,
+	};
+
+	struct Recorded
+	{
+		BYTE op;
+		BYTE result;
+		angle_t a, b;
+	};
+
+	TArray<Recorded> *Recording;	// if set, all operations get logged here
+
 	Clipper()
 	{
-		clipnodes=cliphead=NULL;
+		Recording = NULL;
 	}
 
-	~Clipper();
-
 	void Clear();
+	bool Replay(const Recorded &rec);
 
 
 	void SetSilhouette();
@@ -136,6 +122,9 @@ public:
 
 extern Clipper clipper;
 
+void gl_ClipperBeginFrame();
+void gl_ClipperEndFrame();
+
 angle_t R_PointToPseudoAngle (fixed_t viewx, fixed_t viewy, fixed_t x, fixed_t y);
 
 inline angle_t R_PointToAnglePrecise (fixed_t viewx, fixed_t viewy, fixed_t x, fixed_t y)
@@ -52,6 +52,7 @@
 #include "gl/dynlights/gl_lightbuffer.h"
 #include "gl/renderer/gl_lightdata.h"
 #include "gl/renderer/gl_renderstate.h"
+#include "gl/renderer/gl_renderer.h"
 #include "gl/textures/gl_material.h"
 #include "gl/utility/gl_clock.h"
 #include "gl/utility/gl_templates.h"
@@ -60,6 +61,7 @@
 FDrawInfo * gl_drawinfo;
 
 CVAR(Bool, gl_sort_textures, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR(Bool, gl_sort_groups, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 //==========================================================================
 //
@@ -192,33 +194,252 @@ inline void SortNode::AddToRight(SortNode * child)
 
 //==========================================================================
 //
+// Sort groups
 //
+// Two translucent items whose horizontal view angle ranges do not overlap
+// are separated by a vertical plane through the eye and can't overlap on
+// screen, so their relative draw order is irrelevant. The draw list is
+// split into groups of items with overlapping angle ranges and each group
+// gets sorted on its own. This way the many sprites of a particle heavy
+// scene only get sorted against and split by the walls and planes they
+// can actually overlap.
+//
+//==========================================================================
+
+struct FSortExtent
+{
+	float lo, hi;
+	int itemindex;
+};
+
+static TArray<FSortExtent> SortExtents;
+static TArray<int> SortGroupIndex;
+static TArray<SortNode *> SortGroupHeads;
+static TArray<SortNode *> SortGroupTails;
+static float SortViewX, SortViewY;
+
+#define SORT_ANGLE_MARGIN (0.001f)
+
+//==========================================================================
+//
+// Angle of a point relative to the view direction. The discontinuity
+// is directly behind the viewer.
+//
+//==========================================================================
+
+static inline float SortAngle(float x, float y)
+{
+	float dx = x - SortViewX;
+	float dy = y - SortViewY;
+	const FVector2 &vv = GLRenderer->mViewVector;
+	return (float)atan2(dy*vv.X - dx*vv.Y, dx*vv.X + dy*vv.Y);
+}
+
+//==========================================================================
+//
+// Angle range of a set of points. Only valid if all points are within
+// a half plane whose border passes through the viewer.
+//
+//==========================================================================
+
+static bool SortAngleRange(float *lo, float *hi, float x, float y)
+{
+	float a = SortAngle(x, y);
+	if (a < *lo) *lo = a;
+	if (a > *hi) *hi = a;
+	return *hi - *lo < PI;
+}
+
+//==========================================================================
+//
+// Gets the horizontal view angle range an item covers.
+// Returns false if the item may cover the entire view.
+//
+//==========================================================================
+
+bool GLDrawList::GetSortExtent(int index, float &lo, float &hi)
+{
+	GLDrawItem * it = &drawitems[index];
+
+	lo = FLT_MAX;
+	hi = -FLT_MAX;
+	switch(it->rendertype)
+	{
+	case GLDIT_WALL:
+		{
+			GLWall * w = &walls[it->index];
+			SortAngleRange(&lo, &hi, w->glseg.x1, w->glseg.y1);
+			if (!SortAngleRange(&lo, &hi, w->glseg.x2, w->glseg.y2)) return false;
+		}
+		break;
+
+	case GLDIT_FLAT:
+		{
+			GLFlat * f = &flats[it->index];
+			float bbox[4] = { -FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX };	// top, bottom, left, right
+			int i;
+
+			// First make sure the viewer is outside the plane's bounding box.
+			// Then all of it is within one half plane.
+			if (f->sub != NULL)
+			{
+				for(i = 0; i < (int)f->sub->numlines; i++)
+				{
+					vertex_t * v = f->sub->firstline[i].v1;
+					float x = FIXED2FLOAT(v->x), y = FIXED2FLOAT(v->y);
+					bbox[BOXTOP] = MAX(bbox[BOXTOP], y);
+					bbox[BOXBOTTOM] = MIN(bbox[BOXBOTTOM], y);
+					bbox[BOXLEFT] = MIN(bbox[BOXLEFT], x);
+					bbox[BOXRIGHT] = MAX(bbox[BOXRIGHT], x);
+				}
+			}
+			else
+			{
+				for(i = 0; i < f->sector->linecount; i++)
+				{
+					line_t * l = f->sector->lines[i];
+					bbox[BOXTOP] = MAX(bbox[BOXTOP], FIXED2FLOAT(l->bbox[BOXTOP]));
+					bbox[BOXBOTTOM] = MIN(bbox[BOXBOTTOM], FIXED2FLOAT(l->bbox[BOXBOTTOM]));
+					bbox[BOXLEFT] = MIN(bbox[BOXLEFT], FIXED2FLOAT(l->bbox[BOXLEFT]));
+					bbox[BOXRIGHT] = MAX(bbox[BOXRIGHT], FIXED2FLOAT(l->bbox[BOXRIGHT]));
+				}
+			}
+			if (bbox[BOXLEFT] > bbox[BOXRIGHT]) return false;
+			if (SortViewX >= bbox[BOXLEFT] && SortViewX <= bbox[BOXRIGHT] &&
+				SortViewY >= bbox[BOXBOTTOM] && SortViewY <= bbox[BOXTOP]) return false;
+
+			SortAngleRange(&lo, &hi, bbox[BOXLEFT], bbox[BOXTOP]);
+			SortAngleRange(&lo, &hi, bbox[BOXRIGHT], bbox[BOXTOP]);
+			SortAngleRange(&lo, &hi, bbox[BOXLEFT], bbox[BOXBOTTOM]);
+			if (!SortAngleRange(&lo, &hi, bbox[BOXRIGHT], bbox[BOXBOTTOM])) return false;
+		}
+		break;
+
+	case GLDIT_SPRITE:
+		{
+			GLSprite * s = &sprites[it->index];
+
+			// The exact shape of models is unknown here.
+			if (s->modelframe != NULL) return false;
+
+			// Billboarded sprites may be tilted toward the viewer so use
+			// the circle that encloses the sprite in any orientation.
+			float cx = (s->x1 + s->x2) * 0.5f;
+			float cy = (s->y1 + s->y2) * 0.5f;
+			float hw = Dist2(s->x1, s->y1, s->x2, s->y2) * 0.5f;
+			float hh = (s->z1 - s->z2) * 0.5f;
+			float radius = sqrtf(hw*hw + hh*hh);
+			float dist = Dist2(cx, cy, SortViewX, SortViewY);
+
+			if (dist <= radius) return false;
+			float a = SortAngle(cx, cy);
+			float da = (float)asin(radius / dist);
+			lo = a - da;
+			hi = a + da;
+			if (lo < -PI || hi > PI) return false;
+		}
+		break;
+
+	case GLDIT_POLY:
+		return false;
+	}
+	lo -= SORT_ANGLE_MARGIN;
+	hi += SORT_ANGLE_MARGIN;
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static int __cdecl CompareSortExtents(const void * a, const void * b)
+{
+	float la = ((const FSortExtent *)a)->lo;
+	float lb = ((const FSortExtent *)b)->lo;
+	return la < lb ? -1 : la > lb ? 1 : 0;
+}
+
+//==========================================================================
+//
+// Assigns each draw item to a sort group and returns the group count.
+//
+//==========================================================================
+
+int GLDrawList::FindSortGroups()
+{
+	unsigned i;
+	int group;
+	float grouphi;
+
+	SortViewX = FIXED2FLOAT(viewx);
+	SortViewY = FIXED2FLOAT(viewy);
+
+	SortExtents.Resize(drawitems.Size());
+	for(i = 0; i < drawitems.Size(); i++)
+	{
+		FSortExtent &ext = SortExtents[i];
+		if (!GetSortExtent(i, ext.lo, ext.hi))
+		{
+			// This overlaps everything so there's nothing to split.
+			memset(&SortGroupIndex[0], 0, drawitems.Size() * sizeof(int));
+			return 1;
+		}
+		ext.itemindex = i;
+	}
+	qsort(&SortExtents[0], SortExtents.Size(), sizeof(FSortExtent), CompareSortExtents);
+
+	group = 0;
+	grouphi = SortExtents[0].hi;
+	for(i = 0; i < SortExtents.Size(); i++)
+	{
+		if (SortExtents[i].lo > grouphi) group++;
+		grouphi = MAX(grouphi, SortExtents[i].hi);
+		SortGroupIndex[SortExtents[i].itemindex] = group;
+	}
+	return group + 1;
+}
+
+//==========================================================================
+//
+// Creates an unsorted node chain for each sort group. Inside a group the
+// items keep their draw list order.
 //
 //==========================================================================
 void GLDrawList::MakeSortList()
 {
-	SortNode * p, * n, * c;
 	unsigned i;
+	int numgroups;
 
 	SortNodeStart=SortNodes.Size();
-	p=NULL;
-	n=SortNodes.GetNew();
+	SortGroupIndex.Resize(drawitems.Size());
+	if (gl_sort_groups && drawitems.Size() > 1)
+	{
+		numgroups = FindSortGroups();
+	}
+	else
+	{
+		memset(&SortGroupIndex[0], 0, drawitems.Size() * sizeof(int));
+		numgroups = 1;
+	}
+
+	SortGroupHeads.Resize(numgroups);
+	SortGroupTails.Resize(numgroups);
+	memset(&SortGroupHeads[0], 0, numgroups * sizeof(SortNode *));
+	memset(&SortGroupTails[0], 0, numgroups * sizeof(SortNode *));
+
 	for(i=0;i<drawitems.Size();i++)
 	{
+		int g = SortGroupIndex[i];
+		SortNode * n=SortNodes.GetNew();
+
 		n->itemindex=(int)i;
-		n->left=n->equal=n->right=NULL;
-		n->parent=p;
-		p=n;
-		if (i!=drawitems.Size()-1)
-		{
-			c=SortNodes.GetNew();
-			n->next=c;
-			n=c;
-		}
-		else
-		{
-			n->next=NULL;
-		}
+		n->left=n->equal=n->right=n->next=NULL;
+		n->parent=SortGroupTails[g];
+		if (SortGroupTails[g]) SortGroupTails[g]->next=n;
+		else SortGroupHeads[g]=n;
+		SortGroupTails[g]=n;
 	}
 }
 
@@ -764,8 +985,23 @@ void GLDrawList::DrawSorted()
 
 	if (!sorted)
 	{
+		SortNode * last=NULL;
+
 		MakeSortList();
-		sorted=DoSort(SortNodes[SortNodeStart]);
+		for(unsigned i=0;i<SortGroupHeads.Size();i++)
+		{
+			SortNode * group=DoSort(SortGroupHeads[i]);
+
+			// Append the group to the previous one's right-most node
+			// so that DoDrawSorted draws them one after another.
+			if (last==NULL) sorted=group;
+			else
+			{
+				while (last->right) last=last->right;
+				last->right=group;
+			}
+			last=group;
+		}
 	}
 	DoDrawSorted(sorted);
 }
@@ -964,6 +1200,60 @@ void FDrawInfo::EndDrawInfo()
 	di_list.Release(di);
 }
 
+//==========================================================================
+//
+// Lists the contents of all draw lists, either to the console or to
+// a file. Items are listed in the order they were added.
+//
+//==========================================================================
+
+void FDrawInfo::DumpDrawLists(const char *filename)
+{
+	FILE *f = NULL;
+
+	if (filename != NULL && *filename != 0)
+	{
+		f = fopen(filename, "w");
+		if (f == NULL)
+		{
+			Printf("Unable to open %s\n", filename);
+			return;
+		}
+	}
+
+	for(int i=0;i<GLDL_TYPES;i++)
+	{
+		GLDrawList &dl = drawlists[i];
+		FString out;
+		unsigned j;
+
+		out.Format("List %d: %d walls, %d flats, %d sprites\n", i, dl.walls.Size(), dl.flats.Size(), dl.sprites.Size());
+		for(j=0;j<dl.walls.Size();j++)
+		{
+			GLWall &w = dl.walls[j];
+			out.AppendFormat("  wall line %d side %d type %d tex %s light %d\n",
+				w.seg->linedef != NULL ? int(w.seg->linedef - lines) : -1,
+				w.seg->sidedef != NULL ? int(w.seg->sidedef - sides) : -1,
+				w.type, w.gltexture != NULL ? w.gltexture->tex->Name.GetChars() : "-", w.lightlevel);
+		}
+		for(j=0;j<dl.flats.Size();j++)
+		{
+			GLFlat &fl = dl.flats[j];
+			out.AppendFormat("  flat sector %d %s tex %s\n", fl.sector->sectornum, fl.ceiling ? "ceiling" : "floor",
+				fl.gltexture != NULL ? fl.gltexture->tex->Name.GetChars() : "-");
+		}
+		for(j=0;j<dl.sprites.Size();j++)
+		{
+			GLSprite &sp = dl.sprites[j];
+			out.AppendFormat("  sprite %s at (%.2f, %.2f, %.2f)\n", 
+				sp.actor != NULL ? sp.actor->GetClass()->TypeName.GetChars() : "particle", sp.x, sp.y, sp.z);
+		}
+		if (f != NULL) fputs(out.GetChars(), f);
+		else Printf("%s", out.GetChars());
+	}
+	if (f != NULL) fclose(f);
+}
+
 
 //==========================================================================
 //
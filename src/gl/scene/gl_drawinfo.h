@@ -122,6 +122,8 @@ public:
 
 
 	void MakeSortList();
+	bool GetSortExtent(int index, float &lo, float &hi);
+	int FindSortGroups();
 	SortNode * FindSortPlane(SortNode * head);
 	SortNode * FindSortWall(SortNode * head);
 	void SortPlaneIntoPlane(SortNode * head,SortNode * sort);
@@ -238,6 +240,7 @@ struct FDrawInfo
 	void AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node);
 
 	void StartScene();
+	void DumpDrawLists(const char *filename);
 	void SetupFloodStencil(wallseg * ws);
 	void ClearFloodStencil(wallseg * ws);
 	void DrawFloodedPlane(wallseg * ws, float planez, sector_t * sec, bool ceiling);
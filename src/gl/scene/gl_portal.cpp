@@ -45,6 +45,7 @@
 #include "c_dispatch.h"
 #include "doomstat.h"
 #include "a_sharedglobal.h"
+#include "threadpool.h"
 
 #include "gl/system/gl_interface.h"
 #include "gl/system/gl_framebuffer.h"
@@ -89,6 +90,7 @@ bool	 GLPortal::inskybox;
 
 UniqueList<GLSkyInfo> UniqueSkies;
 UniqueList<GLHorizonInfo> UniqueHorizons;
+FThreadLock UniqueListLock;
 UniqueList<secplane_t> UniquePlaneMirrors;
 
 
@@ -43,6 +43,7 @@
 #include "gl/utility/gl_templates.h"
 
 class ASkyViewpoint;
+class FThreadLock;
 
 struct GLHorizonInfo
 {
@@ -75,6 +76,7 @@ struct GLSkyInfo
 extern UniqueList<GLSkyInfo> UniqueSkies;
 extern UniqueList<GLHorizonInfo> UniqueHorizons;
 extern UniqueList<secplane_t> UniquePlaneMirrors;
+extern FThreadLock UniqueListLock;	// for walls processed on worker threads
 
 class GLPortal
 {
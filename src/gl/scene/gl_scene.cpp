@@ -55,6 +55,7 @@
 #include "r_utility.h"
 #include "a_hexenglobal.h"
 #include "p_local.h"
+#include "c_dispatch.h"
 #include "gl/gl_functions.h"
 
 #include "gl/system/gl_interface.h"
@@ -323,6 +324,23 @@ void FGLRenderer::SetupView(fixed_t viewx, fixed_t viewy, fixed_t viewz, angle_t
 	SetViewMatrix(viewx, viewy, viewz, mirror, planemirror);
 }
 
+//-----------------------------------------------------------------------------
+//
+// gl_dumpdrawlists
+//
+//-----------------------------------------------------------------------------
+
+static bool gl_dumpdrawlists;
+static FString DrawListDumpFile;
+
+// Writes the draw lists of the next frame's main view to the console or
+// a file, so that they can be compared between different settings.
+CCMD(gl_dumpdrawlists)
+{
+	DrawListDumpFile = argv.argc() > 1 ? argv[1] : "";
+	gl_dumpdrawlists = true;
+}
+
 //-----------------------------------------------------------------------------
 //
 // CreateScene
@@ -336,6 +354,7 @@ void FGLRenderer::CreateScene()
 	// reset the portal manager
 	GLPortal::StartFrame();
 	PO_LinkToSubsectors();
+	GLRenderer->mVBO->UpdateDirtyPlanes();
 
 	ProcessAll.Clock();
 
@@ -346,12 +365,21 @@ void FGLRenderer::CreateScene()
 	gl_RenderBSPNode (nodes + numnodes - 1);
 	Bsp.Unclock();
 
+	// Set up the walls the traversal has queued for the worker threads.
+	gl_ProcessWallJobs();
+
 	// And now the crappy hacks that have to be done to avoid rendering anomalies:
 
 	gl_drawinfo->HandleMissingTextures();	// Missing upper/lower textures
 	gl_drawinfo->HandleHackedSubsectors();	// open sector hacks for deep water
 	gl_drawinfo->ProcessSectorStacks();		// merge visplanes of sector stacks
 
+	if (gl_dumpdrawlists)
+	{
+		gl_dumpdrawlists = false;
+		gl_drawinfo->DumpDrawLists(DrawListDumpFile);
+	}
+
 	GLRenderer->mVBO->UnmapVBO ();
 	ProcessAll.Unclock();
 
@@ -872,6 +900,7 @@ void FGLRenderer::SetFixedColormap (player_t *player)
 sector_t * FGLRenderer::RenderViewpoint (AActor * camera, GL_IRECT * bounds, float fov, float ratio, float fovratio, bool mainview, bool toscreen)
 {       
 	sector_t * retval;
+	Flush();
 	R_SetupFrame (camera);
 	SetViewArea();
 
@@ -911,11 +940,13 @@ sector_t * FGLRenderer::RenderViewpoint (AActor * camera, GL_IRECT * bounds, flo
 	SetViewAngle(viewangle);
 	SetViewMatrix(viewx, viewy, viewz, false, false);
 
+	gl_ClipperBeginFrame();
 	clipper.Clear();
 	angle_t a1 = FrustumAngle();
 	clipper.SafeAddClipRangeRealAngles(viewangle+a1, viewangle-a1);
 
 	ProcessScene(toscreen);
+	gl_ClipperEndFrame();
 
 	gl_frameCount++;	// This counter must be increased right before the interpolations are restored.
 	interpolator.RestoreInterpolations ();
@@ -923,6 +954,87 @@ sector_t * FGLRenderer::RenderViewpoint (AActor * camera, GL_IRECT * bounds, flo
 }
 
 
+//-----------------------------------------------------------------------------
+//
+// gl_checksortgroups renders the next frames twice, with and without the
+// translucent sort groups, and compares the results. Start it while a
+// demo with lots of translucency plays back. Pixels may differ by a tiny
+// amount where a sprite gets split differently, so only differences
+// above SORTCHECK_TOLERANCE in a color channel count.
+//
+//-----------------------------------------------------------------------------
+
+EXTERN_CVAR(Bool, gl_sort_groups)
+
+enum { SORTCHECK_TOLERANCE = 2 };
+
+static int SortCheckFrames;
+static int SortCheckDone, SortCheckFailed, SortCheckMaxPixels;
+
+CCMD(gl_checksortgroups)
+{
+	SortCheckFrames = argv.argc() > 1 ? MAX(1, atoi(argv[1])) : 1;
+	SortCheckDone = SortCheckFailed = SortCheckMaxPixels = 0;
+}
+
+static BYTE *ReadSortCheckImage()
+{
+	BYTE *buffer = new BYTE[SCREENWIDTH * SCREENHEIGHT * 3];
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, (screen->GetTrueHeight() - SCREENHEIGHT) / 2, SCREENWIDTH, SCREENHEIGHT, GL_RGB, GL_UNSIGNED_BYTE, buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	return buffer;
+}
+
+static sector_t *RenderSortCheck(FGLRenderer *renderer, AActor *camera, float fov, float ratio, float fovratio)
+{
+	bool sortgroups = gl_sort_groups;
+	sector_t *viewsector = NULL;
+	BYTE *images[2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		// Start both passes from the same, empty picture.
+		gl_sort_groups = (i == 0);
+		glDisable(GL_SCISSOR_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		viewsector = renderer->RenderViewpoint(camera, NULL, fov, ratio, fovratio, true, true);
+		renderer->Flush();
+		images[i] = ReadSortCheckImage();
+	}
+	gl_sort_groups = sortgroups;
+
+	int size = SCREENWIDTH * SCREENHEIGHT * 3;
+	int pixels = 0;
+	for (int i = 0; i < size; i += 3)
+	{
+		if (abs(images[0][i] - images[1][i]) > SORTCHECK_TOLERANCE ||
+			abs(images[0][i+1] - images[1][i+1]) > SORTCHECK_TOLERANCE ||
+			abs(images[0][i+2] - images[1][i+2]) > SORTCHECK_TOLERANCE)
+		{
+			pixels++;
+		}
+	}
+	delete[] images[0];
+	delete[] images[1];
+
+	SortCheckDone++;
+	if (pixels > 0)
+	{
+		SortCheckFailed++;
+		SortCheckMaxPixels = MAX(SortCheckMaxPixels, pixels);
+		Printf("gl_checksortgroups: %d pixels differ at tic %d\n", pixels, gametic);
+	}
+	if (--SortCheckFrames == 0)
+	{
+		Printf("gl_checksortgroups: %d frames checked, %d differed (at most %d pixels)\n",
+			SortCheckDone, SortCheckFailed, SortCheckMaxPixels);
+	}
+	return viewsector;
+}
+
 //-----------------------------------------------------------------------------
 //
 // renders the view
@@ -985,7 +1097,15 @@ void FGLRenderer::RenderView (player_t* player)
 	TThinkerIterator<ADynamicLight> it(STAT_DLIGHT);
 	GLRenderer->mLightCount = ((it.Next()) != NULL);
 
-	sector_t * viewsector = RenderViewpoint(player->camera, NULL, FieldOfView * 360.0f / FINEANGLES, ratio, fovratio, true, true);
+	sector_t * viewsector;
+	if (SortCheckFrames > 0)
+	{
+		viewsector = RenderSortCheck(this, player->camera, FieldOfView * 360.0f / FINEANGLES, ratio, fovratio);
+	}
+	else
+	{
+		viewsector = RenderViewpoint(player->camera, NULL, FieldOfView * 360.0f / FINEANGLES, ratio, fovratio, true, true);
+	}
 	EndDrawScene(viewsector);
 
 	if (NULL != afterRenderView)
@@ -1121,7 +1241,12 @@ void gl_SerializeGlobals(FArchive &arc)
 void FGLInterface::EndSerialize(FArchive &arc)
 {
 	gl_RecreateAllAttachedLights();
-	if (arc.IsLoading()) gl_InitPortals();
+	if (arc.IsLoading())
+	{
+		gl_InitPortals();
+		// The loaded plane heights are most likely different from what the VBO contains.
+		for (int i = 0; i < numsectors; i++) sectors[i].SetPlanesDirty();
+	}
 }
 
 //===========================================================================
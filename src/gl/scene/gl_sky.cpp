@@ -45,6 +45,7 @@
 #include "r_state.h"
 #include "r_utility.h"
 #include "doomdata.h"
+#include "threadpool.h"
 #include "gl/gl_functions.h"
 
 #include "gl/data/gl_data.h"
@@ -151,7 +152,10 @@ void GLWall::SkyPlane(sector_t *sector, int plane, bool allowreflect)
 			else skyinfo.fadecolor=0;
 
 			type=RENDERWALL_SKY;
-			sky=UniqueSkies.Get(&skyinfo);
+			{
+				FThreadLockGuard lock(UniqueListLock);
+				sky=UniqueSkies.Get(&skyinfo);
+			}
 		}
 	}
 	else if (allowreflect && sector->GetReflect(plane) > 0)
@@ -20,6 +20,7 @@ struct GLDrawList;
 struct GLSkyInfo;
 struct FTexCoordInfo;
 struct FPortal;
+struct FWallOutput;
 
 
 enum WallTypes
@@ -105,6 +106,7 @@ public:
 
 	friend struct GLDrawList;
 	friend class GLPortal;
+	friend struct FWallOutput;
 
 	GLSeg glseg;
 	vertex_t * vertexes[2];				// required for polygon splitting
@@ -150,6 +152,7 @@ public:
 public:
 	seg_t * seg;			// this gives the easiest access to all other structs involved
 	subsector_t * sub;		// For polyobjects
+	FWallOutput * output;	// if set, results are collected here instead of being added to the draw lists
 private:
 
 	void CheckGlowing();
@@ -217,7 +220,7 @@ private:
 
 public:
 
-	void Process(seg_t *seg, sector_t *frontsector, sector_t *backsector);
+	void Process(seg_t *seg, sector_t *frontsector, sector_t *backsector, FWallOutput *output = NULL);
 	void ProcessLowerMiniseg(seg_t *seg, sector_t *frontsector, sector_t *backsector);
 	void Draw(int pass);
 
@@ -238,6 +241,46 @@ public:
 
 };
 
+//==========================================================================
+//
+// Walls processed on a worker thread may not touch the draw lists or the
+// portal manager. Instead everything is collected here and committed
+// on the main thread afterward, in the order it was produced.
+//
+//==========================================================================
+
+struct FWallOutput
+{
+	enum
+	{
+		PUTWALL,
+		UPPERMISSING,
+		LOWERMISSING,
+	};
+
+	struct Item
+	{
+		BYTE kind;
+		bool translucent;
+		unsigned int wallindex;
+		side_t * side;
+		subsector_t * sub;
+		fixed_t backheight;
+	};
+
+	TArray<Item> items;
+	TArray<GLWall> walls;
+
+	void AddWall(GLWall * wall, bool translucent);
+	void AddMissingTexture(int kind, side_t * side, subsector_t * sub, fixed_t backheight);
+	void Commit();
+	void Clear()
+	{
+		items.Clear();
+		walls.Clear();
+	}
+};
+
 //==========================================================================
 //
 // One flat plane in the draw list
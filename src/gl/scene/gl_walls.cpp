@@ -61,6 +61,7 @@
 #include "gl/utility/gl_geometric.h"
 #include "gl/utility/gl_templates.h"
 #include "gl/shaders/gl_shader.h"
+#include "threadpool.h"
 
 
 //==========================================================================
@@ -123,6 +124,19 @@ void GLWall::PutWall(bool translucent)
 		4,		//RENDERWALL_COLORLAYER        // color layer needs special handling
 	};
 	
+	if (output != NULL)
+	{
+		// Everything below may modify the draw lists or the portal manager
+		// so when running on a worker thread just record the wall.
+		if (type == RENDERWALL_HORIZON)
+		{
+			FThreadLockGuard lock(UniqueListLock);
+			horizon = UniqueHorizons.Get(horizon);
+		}
+		output->AddWall(this, translucent);
+		return;
+	}
+
 	if (gltexture && gltexture->GetTransparent() && passflag[type] == 2)
 	{
 		translucent = true;
@@ -1430,7 +1444,7 @@ void GLWall::DoFFloorBlocks(seg_t * seg,sector_t * frontsector,sector_t * backse
 // 
 //
 //==========================================================================
-void GLWall::Process(seg_t *seg, sector_t * frontsector, sector_t * backsector)
+void GLWall::Process(seg_t *seg, sector_t * frontsector, sector_t * backsector, FWallOutput *output)
 {
 	vertex_t * v1, *v2;
 	fixed_t fch1;
@@ -1450,6 +1464,7 @@ void GLWall::Process(seg_t *seg, sector_t * frontsector, sector_t * backsector)
 	// note: we always have a valid sidedef and linedef reference when getting here.
 
 	this->seg = seg;
+	this->output = output;
 
 	if ((seg->sidedef->Flags & WALLF_POLYOBJ) && seg->backsector)
 	{
@@ -1660,7 +1675,8 @@ void GLWall::Process(seg_t *seg, sector_t * frontsector, sector_t * backsector)
 					// skip processing if the back is a malformed subsector
 					if (seg->PartnerSeg != NULL && !(seg->PartnerSeg->Subsector->hacked & 4))
 					{
-						gl_drawinfo->AddUpperMissingTexture(seg->sidedef, sub, bch1a);
+						if (output != NULL) output->AddMissingTexture(FWallOutput::UPPERMISSING, seg->sidedef, sub, bch1a);
+						else gl_drawinfo->AddUpperMissingTexture(seg->sidedef, sub, bch1a);
 					}
 				}
 			}
@@ -1733,7 +1749,8 @@ void GLWall::Process(seg_t *seg, sector_t * frontsector, sector_t * backsector)
 				// skip processing if the back is a malformed subsector
 				if (seg->PartnerSeg != NULL && !(seg->PartnerSeg->Subsector->hacked & 4))
 				{
-					gl_drawinfo->AddLowerMissingTexture(seg->sidedef, sub, bfh1);
+					if (output != NULL) output->AddMissingTexture(FWallOutput::LOWERMISSING, seg->sidedef, sub, bfh1);
+					else gl_drawinfo->AddLowerMissingTexture(seg->sidedef, sub, bfh1);
 				}
 			}
 		}
@@ -1755,6 +1772,7 @@ void GLWall::ProcessLowerMiniseg(seg_t *seg, sector_t * frontsector, sector_t *
 	{
 		this->seg = seg;
 		this->sub = NULL;
+		this->output = NULL;
 
 		vertex_t * v1 = seg->v1;
 		vertex_t * v2 = seg->v2;
@@ -1797,3 +1815,55 @@ void GLWall::ProcessLowerMiniseg(seg_t *seg, sector_t * frontsector, sector_t *
 		}
 	}
 }
+
+//==========================================================================
+//
+// Deferred wall output
+//
+//==========================================================================
+
+void FWallOutput::AddWall(GLWall * wall, bool translucent)
+{
+	Item item;
+	item.kind = PUTWALL;
+	item.translucent = translucent;
+	item.wallindex = walls.Push(*wall);
+	items.Push(item);
+}
+
+void FWallOutput::AddMissingTexture(int kind, side_t * side, subsector_t * sub, fixed_t backheight)
+{
+	Item item;
+	item.kind = kind;
+	item.side = side;
+	item.sub = sub;
+	item.backheight = backheight;
+	items.Push(item);
+}
+
+void FWallOutput::Commit()
+{
+	for (unsigned i = 0; i < items.Size(); i++)
+	{
+		Item &item = items[i];
+
+		switch (item.kind)
+		{
+		case PUTWALL:
+		{
+			GLWall &wall = walls[item.wallindex];
+			wall.output = NULL;
+			wall.PutWall(item.translucent);
+			break;
+		}
+
+		case UPPERMISSING:
+			gl_drawinfo->AddUpperMissingTexture(item.side, item.sub, item.backheight);
+			break;
+
+		case LOWERMISSING:
+			gl_drawinfo->AddLowerMissingTexture(item.side, item.sub, item.backheight);
+			break;
+		}
+	}
+}
@@ -194,6 +194,9 @@ void OpenGLFrameBuffer::Update()
 
 	DrawRateStuff();
 	GLRenderer->Flush();
+	GLRenderer->m2DLastBatchCount = GLRenderer->m2DBatchCount;
+	GLRenderer->m2DLastQuadCount = GLRenderer->m2DQuadCount;
+	GLRenderer->m2DBatchCount = GLRenderer->m2DQuadCount = 0;
 
 	if (GetTrueHeight() != GetHeight())
 	{
@@ -386,6 +389,8 @@ FNativePalette *OpenGLFrameBuffer::CreatePalette(FRemapTable *remap)
 //==========================================================================
 bool OpenGLFrameBuffer::Begin2D(bool)
 {
+	if (GLRenderer != NULL)
+		GLRenderer->Flush();
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 	glMatrixMode(GL_PROJECTION);
@@ -421,14 +426,9 @@ bool OpenGLFrameBuffer::Begin2D(bool)
 //
 //==========================================================================
 
-void STACK_ARGS OpenGLFrameBuffer::DrawTextureV(FTexture *img, double x0, double y0, uint32 tag, va_list tags)
+void OpenGLFrameBuffer::DrawTextureParms(FTexture *img, DrawParms &parms)
 {
-	DrawParms parms;
-
-	if (ParseDrawTextureTags(img, x0, y0, tag, tags, &parms, true))
-	{
-		if (GLRenderer != NULL) GLRenderer->DrawTexture(img, parms);
-	}
+	if (GLRenderer != NULL) GLRenderer->DrawTexture(img, parms);
 }
 
 //==========================================================================
@@ -525,6 +525,7 @@ void OpenGLFrameBuffer::GetScreenshotBuffer(const BYTE *&buffer, int &pitch, ESS
 	int w = SCREENWIDTH;
 	int h = SCREENHEIGHT;
 
+	if (GLRenderer != NULL) GLRenderer->Flush();
 	ReleaseScreenshotBuffer();
 	ScreenshotBuffer = new BYTE[w * h * 3];
 
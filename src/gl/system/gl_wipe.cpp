@@ -144,6 +144,7 @@ bool OpenGLFrameBuffer::WipeStartScreen(int type)
 		return false;
 	}
 
+	if (GLRenderer != NULL) GLRenderer->Flush();
 	wipestartscreen = new FHardwareTexture(Width, Height, false, false, false, true);
 	wipestartscreen->CreateTexture(NULL, Width, Height, false, 0, CM_DEFAULT);
 	glFinish();
@@ -167,6 +168,7 @@ bool OpenGLFrameBuffer::WipeStartScreen(int type)
 
 void OpenGLFrameBuffer::WipeEndScreen()
 {
+	if (GLRenderer != NULL) GLRenderer->Flush();
 	wipeendscreen = new FHardwareTexture(Width, Height, false, false, false, true);
 	wipeendscreen->CreateTexture(NULL, Width, Height, false, 0, CM_DEFAULT);
 	glFlush();
@@ -34,22 +34,25 @@
 **
 */
 
-#ifdef __APPLE__
-#	include <AvailabilityMacros.h>
-#	if MAC_OS_X_VERSION_MAX_ALLOWED >= 1060
-#		define GZ_USE_LIBDISPATCH
-#	endif // MAC_OS_X_VERSION_MAX_ALLOWED >= 1060
-#endif // __APPLE__
-
-#ifdef GZ_USE_LIBDISPATCH
-#include <dispatch/dispatch.h>
-#endif // GZ_USE_LIBDISPATCH
+#include <zlib.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "gl/system/gl_system.h"
 #include "gl/system/gl_interface.h"
 #include "gl/renderer/gl_renderer.h"
 #include "gl/textures/gl_texture.h"
+#include "textures/bitmap.h"
 #include "c_cvars.h"
+#include "c_dispatch.h"
+#include "cmdlib.h"
+#include "doomerrors.h"
+#include "m_misc.h"
+#include "m_swap.h"
+#include "md5.h"
+#include "stats.h"
+#include "threadpool.h"
 #include "gl/hqnx/hqnx.h"
 #include "gl/xbr/xbrz.h"
 
@@ -74,6 +77,8 @@ CUSTOM_CVAR(Int, gl_texture_hqresize_targets, 7, CVAR_ARCHIVE | CVAR_GLOBALCONFI
 CVAR (Flag, gl_texture_hqresize_textures, gl_texture_hqresize_targets, 1);
 CVAR (Flag, gl_texture_hqresize_sprites, gl_texture_hqresize_targets, 2);
 CVAR (Flag, gl_texture_hqresize_fonts, gl_texture_hqresize_targets, 4);
+CVAR (Bool, gl_texture_hqresize_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR (Int, gl_texture_hqresize_cachesize, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// in MB, 0 means unlimited
 
 
 static void scale2x(uint32* const input, uint32* const output, const size_t width, const size_t height)
@@ -204,75 +209,413 @@ static void scaleNx(const size_t scale, const size_t width, const size_t height,
 	function(input, output, width, height);
 }
 
+//===========================================================================
+//
+// hqNx and xBRZ split the image into bands of rows which get scaled
+// on the shared worker threads. Each band only writes its own output
+// rows so the result is the same as scaling the whole image at once.
+//
+//===========================================================================
+
+CVAR(Bool, gl_texture_hqresize_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
+CUSTOM_CVAR(Int, gl_texture_hqresize_mt_width, 16, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 2)    self = 2;
+	if (self > 1024) self = 1024;
+}
+
+CUSTOM_CVAR(Int, gl_texture_hqresize_mt_height, 4, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 2)    self = 2;
+	if (self > 1024) self = 1024;
+}
+
+struct FScaleBands
+{
+	size_t scale;
+	int width;
+	int height;
+	int bandheight;
+	uint32 *input;
+	uint32 *output;
+	void (*hqfunction)(int *input, unsigned char *output, int width, int height, int pitch, int ystart, int yend);
+};
+
+static int GetNumBands(const size_t width, const size_t height)
+{
+	const size_t thresholdWidth  = gl_texture_hqresize_mt_width;
+	const size_t thresholdHeight = gl_texture_hqresize_mt_height;
+
+	if (!gl_texture_hqresize_multithread || ThreadPool.GetNumThreads() < 2 || ThreadPool.IsWorkerThread()
+		|| width <= thresholdWidth || height <= thresholdHeight)
+	{
+		return 1;
+	}
+	return int((height + thresholdHeight - 1) / thresholdHeight);
+}
+
+static void hqNxBand(void *userdata, int index)
+{
+	FScaleBands *bands = (FScaleBands *)userdata;
+	int ystart = index * bands->bandheight;
+	int yend = MIN(ystart + bands->bandheight, bands->height);
+
+	bands->hqfunction(reinterpret_cast<int*>(bands->input), reinterpret_cast<unsigned char*>(bands->output),
+		bands->width, bands->height, static_cast<int>(bands->width * bands->scale * BYTES_PER_PIXEL), ystart, yend);
+}
+
 static void hqNx(const size_t scale, const size_t width, const size_t height, uint32* const input, uint32* const output)
 {
-	static bool isInitialized = false;
+	static volatile bool isInitialized = false;
+	static FThreadLock InitLock;
 
+	// The lookup tables must be complete before any other thread can see the flag.
 	if (!isInitialized)
 	{
-		InitLUTs();
-		isInitialized = true;
+		FThreadLockGuard lock(InitLock);
+		if (!isInitialized)
+		{
+			InitLUTs();
+			WriteBarrier();
+			isInitialized = true;
+		}
+	}
+	else
+	{
+		ReadBarrier();
 	}
 
 	CImage image;
 	image.SetImage(reinterpret_cast<unsigned char*>(input), static_cast<int>(width), static_cast<int>(height), 32);
 	image.Convert32To17();
 
-	void (*function)(int* input, unsigned char* output, int width, int height, int pitch) = NULL;
+	FScaleBands bands;
 
 	switch (scale)
 	{
-		case  2: function = hq2x_32;     break;
-		case  3: function = hq3x_32;     break;
-		case  4: function = hq4x_32;     break;
+		case  2: bands.hqfunction = hq2x_32_rows;     break;
+		case  3: bands.hqfunction = hq3x_32_rows;     break;
+		case  4: bands.hqfunction = hq4x_32_rows;     break;
 		default: assert(!"Wrong scale"); return;
 	}
 
-	function(reinterpret_cast<int*>(image.m_pBitmap), reinterpret_cast<unsigned char*>(output),
-		static_cast<int>(width), static_cast<int>(height), static_cast<int>(width * scale * BYTES_PER_PIXEL));
+	bands.scale = scale;
+	bands.width = static_cast<int>(width);
+	bands.height = static_cast<int>(height);
+	bands.input = reinterpret_cast<uint32*>(image.m_pBitmap);
+	bands.output = output;
+
+	int numbands = GetNumBands(width, height);
+	bands.bandheight = (bands.height + numbands - 1) / numbands;
+	if (numbands > 1)
+	{
+		ThreadPool.ParallelFor(numbands, hqNxBand, &bands);
+	}
+	else
+	{
+		hqNxBand(&bands, 0);
+	}
 }
 
-#ifdef GZ_USE_LIBDISPATCH
-CVAR(Bool, gl_texture_hqresize_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+static void xbrzNxBand(void *userdata, int index)
+{
+	FScaleBands *bands = (FScaleBands *)userdata;
 
-CUSTOM_CVAR(Int, gl_texture_hqresize_mt_width, 16, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+	xbrz::scale(bands->scale, bands->input, bands->output, bands->width, bands->height, xbrz::ScalerCfg(),
+		index * bands->bandheight, (index + 1) * bands->bandheight);
+}
+
+static void xbrzNx(const size_t scale, const size_t width, const size_t height, uint32* const input, uint32* const output)
 {
-	if (self < 2)    self = 2;
-	if (self > 1024) self = 1024;
+	int numbands = GetNumBands(width, height);
+
+	if (numbands > 1)
+	{
+		FScaleBands bands;
+
+		bands.scale = scale;
+		bands.width = static_cast<int>(width);
+		bands.height = static_cast<int>(height);
+		bands.bandheight = int(gl_texture_hqresize_mt_height);
+		bands.input = input;
+		bands.output = output;
+		bands.hqfunction = NULL;
+		ThreadPool.ParallelFor(numbands, xbrzNxBand, &bands);
+	}
+	else
+	{
+		xbrz::scale(scale, input, output, static_cast<int>(width), static_cast<int>(height));
+	}
 }
 
-CUSTOM_CVAR(Int, gl_texture_hqresize_mt_height, 4, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+//===========================================================================
+//
+// Disk cache for the expensive scalers
+//
+// hqNx and xBRZ take long enough that recomputing them for every texture
+// each session noticeably adds to the load times. Their output only
+// depends on the input pixels, the scaler and the factor so it gets
+// stored compressed in the cache directory under the MD5 of those.
+//
+//===========================================================================
+
+static FThreadLock HQCacheLock;
+static int HQCacheHits, HQCacheMisses, HQCacheWrites;
+
+struct FHQCacheHeader
 {
-	if (self < 2)    self = 2;
-	if (self > 1024) self = 1024;
+	char Magic[4];		// "HQRZ"
+	DWORD Version;
+	DWORD Width;		// output size
+	DWORD Height;
+	DWORD CompressedSize;
+	BYTE Key[16];
+};
+
+enum { HQCACHE_VERSION = 1 };
+
+static void MakeHQCacheKey(BYTE key[16], const unsigned char *buffer, int width, int height, int type, int factor)
+{
+	MD5Context md5;
+	DWORD params[4] = { LittleLong(DWORD(width)), LittleLong(DWORD(height)), LittleLong(DWORD(type)), LittleLong(DWORD(factor)) };
+
+	md5.Update((const BYTE *)params, sizeof(params));
+	md5.Update(buffer, width * height * 4);
+	md5.Final(key);
 }
-#endif // GZ_USE_LIBDISPATCH
 
-static void xbrzNx(const size_t scale, const size_t width, const size_t height, uint32* const input, uint32* const output)
+static FString CreateHQCacheName(const BYTE key[16], bool create)
 {
-#ifdef GZ_USE_LIBDISPATCH
-	const size_t thresholdWidth  = gl_texture_hqresize_mt_width;
-	const size_t thresholdHeight = gl_texture_hqresize_mt_height;
+	FString path = M_GetCachePath(create);
+	path << "/hqresize";
+	if (create) CreatePath(path);
 
-	if (   NULL != dispatch_get_global_queue
-		&& NULL != dispatch_apply
-		&& gl_texture_hqresize_multithread
-		&& width  > thresholdWidth
-		&& height > thresholdHeight)
+	path << '/';
+	for (int i = 0; i < 16; i++)
 	{
-		const dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+		path.AppendFormat("%02x", key[i]);
+	}
+	path << ".hqc";
+	return path;
+}
 
-		dispatch_apply(height / thresholdHeight + 1, queue, ^(size_t sliceY)
+//===========================================================================
+//
+// Returns the cached output or NULL if there is none.
+//
+//===========================================================================
+
+static uint32 *ReadHQCache(const BYTE key[16], int outWidth, int outHeight)
+{
+	FHQCacheHeader header;
+	FString path = CreateHQCacheName(key, false);
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) return NULL;
+
+	uint32 *output = NULL;
+	BYTE *compressed = NULL;
+	bool bad = true;
+
+	fseek(f, 0, SEEK_END);
+	long filelen = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (fread(&header, sizeof(header), 1, f) == 1 &&
+		!memcmp(header.Magic, "HQRZ", 4) &&
+		LittleLong(header.Version) == HQCACHE_VERSION &&
+		(int)LittleLong(header.Width) == outWidth &&
+		(int)LittleLong(header.Height) == outHeight &&
+		!memcmp(header.Key, key, 16))
+	{
+		// Don't trust the stored size before allocating anything for it.
+		DWORD complen = LittleLong(header.CompressedSize);
+		if (complen <= compressBound(outWidth * outHeight * 4) && long(complen + sizeof(header)) <= filelen)
 		{
-			xbrz::scale(scale, input, output,
-				static_cast<int>(width), static_cast<int>(height), xbrz::ScalerCfg(),
-				sliceY * thresholdHeight, (sliceY + 1) * thresholdHeight);
-		});
+			compressed = new BYTE[complen];
+			if (fread(compressed, 1, complen, f) == complen)
+			{
+				uLongf outlen = outWidth * outHeight * 4;
+				output = new uint32[outWidth * outHeight];
+				if (uncompress((Bytef *)output, &outlen, compressed, complen) != Z_OK || outlen != uLongf(outWidth * outHeight * 4))
+				{
+					delete[] output;
+					output = NULL;
+				}
+				else
+				{
+					bad = false;
+				}
+			}
+			delete[] compressed;
+		}
 	}
-	else
-#endif // GZ_USE_LIBDISPATCH
+	fclose(f);
+
+	// A damaged entry would otherwise be read again every time.
+	if (bad)
 	{
-		xbrz::scale(scale, input, output, static_cast<int>(width), static_cast<int>(height));
+		FThreadLockGuard lock(HQCacheLock);
+		remove(path);
+	}
+	return output;
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+static void WriteHQCache(const BYTE key[16], const uint32 *output, int outWidth, int outHeight)
+{
+	uLongf srclen = outWidth * outHeight * 4;
+	uLongf outlen = compressBound(srclen);
+	BYTE *compressed = new BYTE[outlen];
+
+	if (compress(compressed, &outlen, (const Bytef *)output, srclen) == Z_OK)
+	{
+		FHQCacheHeader header;
+
+		memcpy(header.Magic, "HQRZ", 4);
+		header.Version = LittleLong(DWORD(HQCACHE_VERSION));
+		header.Width = LittleLong(DWORD(outWidth));
+		header.Height = LittleLong(DWORD(outHeight));
+		header.CompressedSize = LittleLong(DWORD(outlen));
+		memcpy(header.Key, key, 16);
+
+		// Textures with identical contents may get scaled on two threads at once.
+		FThreadLockGuard lock(HQCacheLock);
+		FString path = CreateHQCacheName(key, true);
+		FILE *f = fopen(path, "wb");
+		if (f != NULL)
+		{
+			bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(compressed, outlen, 1, f) == 1;
+			fclose(f);
+			if (!ok)
+			{
+				remove(path);
+			}
+			else
+			{
+				HQCacheWrites++;
+			}
+		}
+	}
+	delete[] compressed;
+}
+
+ADD_STAT(hqresize)
+{
+	FString out;
+	int total = HQCacheHits + HQCacheMisses;
+	out.Format("hq cache: %d hits, %d misses (%d%%), %d written",
+		HQCacheHits, HQCacheMisses, total > 0? HQCacheHits * 100 / total : 0, HQCacheWrites);
+	return out;
+}
+
+//===========================================================================
+//
+// Keeps the cache below gl_texture_hqresize_cachesize by deleting the
+// files that were written the longest time ago. This is done once at
+// startup so the cache cannot grow without bounds over many sessions.
+//
+//===========================================================================
+
+struct FHQCacheFile
+{
+	FString Filename;
+	time_t Time;
+	long Size;
+};
+
+static int SortHQCacheFiles(const void *a, const void *b)
+{
+	const FHQCacheFile *fa = (const FHQCacheFile *)a;
+	const FHQCacheFile *fb = (const FHQCacheFile *)b;
+
+	if (fa->Time != fb->Time) return fa->Time < fb->Time ? -1 : 1;
+	return 0;
+}
+
+void gl_PruneHQResizeCache()
+{
+	if (gl_texture_hqresize_cachesize <= 0) return;
+
+	TArray<FFileList> list;
+	FString path = M_GetCachePath(false);
+	path += "/hqresize/";
+	if (!DirEntryExists(path)) return;
+
+	try
+	{
+		ScanDirectory(list, path);
+	}
+	catch (CRecoverableError &)
+	{
+		return;
+	}
+
+	TArray<FHQCacheFile> files;
+	double total = 0;
+
+	for (unsigned i = 0; i < list.Size(); i++)
+	{
+		struct stat info;
+
+		if (!list[i].isDirectory && stat(list[i].Filename, &info) == 0)
+		{
+			FHQCacheFile *file = &files[files.Reserve(1)];
+			file->Filename = list[i].Filename;
+			file->Time = info.st_mtime;
+			file->Size = info.st_size;
+			total += info.st_size;
+		}
+	}
+
+	double limit = gl_texture_hqresize_cachesize * 1048576.;
+	if (total <= limit) return;
+
+	qsort(&files[0], files.Size(), sizeof(FHQCacheFile), SortHQCacheFiles);
+	for (unsigned i = 0; i < files.Size() && total > limit; i++)
+	{
+		if (remove(files[i].Filename) == 0)
+		{
+			total -= files[i].Size;
+		}
+	}
+}
+
+//===========================================================================
+//
+//
+//
+//===========================================================================
+
+CCMD(clearhqresizecache)
+{
+	TArray<FFileList> list;
+	FString path = M_GetCachePath(false);
+	path += "/hqresize/";
+
+	try
+	{
+		ScanDirectory(list, path);
+	}
+	catch (CRecoverableError &err)
+	{
+		Printf("%s", err.GetMessage());
+		return;
+	}
+
+	FThreadLockGuard lock(HQCacheLock);
+	for (unsigned i = 0; i < list.Size(); i++)
+	{
+		if (!list[i].isDirectory)
+		{
+			remove(list[i].Filename);
+		}
 	}
 }
 
@@ -355,12 +698,31 @@ unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, u
 			const Scaler& scaler = SCALERS[type];
 			const size_t scale = scaler.factor;
 
-			uint32* const output = new uint32[scale * inWidth * scale * inHeight];
-			scaler.function(scale, inWidth, inHeight, reinterpret_cast<uint32*>(inputBuffer), output);
-
 			outWidth  = static_cast<int>(scaler.factor * inWidth );
 			outHeight = static_cast<int>(scaler.factor * inHeight);
 
+			// ScaleNx is faster than reading the result back from disk.
+			bool usecache = gl_texture_hqresize_cache && type >= 4;
+			uint32* output = NULL;
+			BYTE key[16];
+
+			if (usecache)
+			{
+				MakeHQCacheKey(key, inputBuffer, inWidth, inHeight, type, int(scale));
+				output = ReadHQCache(key, outWidth, outHeight);
+
+				FThreadLockGuard lock(HQCacheLock);
+				if (output != NULL) HQCacheHits++;
+				else HQCacheMisses++;
+			}
+
+			if (output == NULL)
+			{
+				output = new uint32[scale * inWidth * scale * inHeight];
+				scaler.function(scale, inWidth, inHeight, reinterpret_cast<uint32*>(inputBuffer), output);
+				if (usecache) WriteHQCache(key, output, outWidth, outHeight);
+			}
+
 			delete[] inputBuffer;
 
 			return reinterpret_cast<unsigned char*>(output);
@@ -369,3 +731,88 @@ unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, u
 
 	return inputBuffer;
 }
+
+//===========================================================================
+//
+// Upscales a set of the loaded textures with every scaler and prints the
+// throughput of each. bench_hqresize [number of textures] [serial]
+//
+//===========================================================================
+
+CCMD(bench_hqresize)
+{
+	static const char *names[] = { NULL, "scale2x", "scale3x", "scale4x", "hq2x", "hq3x", "hq4x", "xbrz2x", "xbrz3x", "xbrz4x", "xbrz5x" };
+	static const size_t factors[] = { 0, 2, 3, 4, 2, 3, 4, 2, 3, 4, 5 };
+	static const ScaleFunction functions[] = { NULL, scaleNx, scaleNx, scaleNx, hqNx, hqNx, hqNx, xbrzNx, xbrzNx, xbrzNx, xbrzNx };
+
+	int count = argv.argc() > 1 ? atoi(argv[1]) : 64;
+	bool serial = argv.argc() > 2 && !stricmp(argv[2], "serial");
+	TArray<FBitmap *> bitmaps;
+	size_t pixels = 0;
+
+	for (int i = 1; i < TexMan.NumTextures() && (int)bitmaps.Size() < count; i++)
+	{
+		FTexture *tex = TexMan.ByIndex(i);
+		int w = tex->GetWidth();
+		int h = tex->GetHeight();
+
+		if (tex->UseType == FTexture::TEX_Null || tex->bHasCanvas || w < 8 || h < 8 || 
+			w > gl_texture_hqresize_maxinputsize || h > gl_texture_hqresize_maxinputsize)
+		{
+			continue;
+		}
+
+		FBitmap *bmp = new FBitmap;
+		if (bmp->Create(w, h))
+		{
+			memset(bmp->GetPixels(), 0, w * h * 4);
+			tex->CopyTrueColorPixels(bmp, 0, 0);
+			bitmaps.Push(bmp);
+			pixels += w * h;
+		}
+		else
+		{
+			delete bmp;
+		}
+	}
+
+	if (bitmaps.Size() == 0)
+	{
+		Printf("No textures to scale\n");
+		return;
+	}
+
+	bool multithread = gl_texture_hqresize_multithread;
+	if (serial) gl_texture_hqresize_multithread = false;
+
+	Printf("Scaling %u textures with %u pixels on %d thread(s)\n", bitmaps.Size(), (unsigned)pixels,
+		serial ? 1 : ThreadPool.GetNumThreads());
+
+	for (unsigned type = 1; type < countof(factors); type++)
+	{
+		cycle_t clock;
+		clock.Reset();
+
+		for (unsigned i = 0; i < bitmaps.Size(); i++)
+		{
+			int w = bitmaps[i]->GetWidth();
+			int h = bitmaps[i]->GetHeight();
+			uint32 *output = new uint32[factors[type] * w * factors[type] * h];
+
+			clock.Clock();
+			functions[type](factors[type], w, h, reinterpret_cast<uint32*>(bitmaps[i]->GetPixels()), output);
+			clock.Unclock();
+			delete[] output;
+		}
+
+		double ms = clock.TimeMS();
+		Printf("%-8s %9.2f ms  %8.2f Mpixels/s\n", names[type], ms, ms > 0 ? pixels / ms / 1000. : 0.);
+	}
+
+	gl_texture_hqresize_multithread = multithread;
+
+	for (unsigned i = 0; i < bitmaps.Size(); i++)
+	{
+		delete bitmaps[i];
+	}
+}
@@ -47,6 +47,7 @@
 #include "templates.h"
 #include "sc_man.h"
 #include "colormatcher.h"
+#include "threadpool.h"
 
 //#include "gl/gl_intern.h"
 
@@ -595,6 +596,7 @@ FGLTexture * FMaterial::ValidateSysTexture(FTexture * tex, bool expand)
 //
 //===========================================================================
 TArray<FMaterial *> FMaterial::mMaterials;
+static FThreadLock MaterialLock;
 int FMaterial::mMaxBound;
 
 FMaterial::FMaterial(FTexture * tx, bool forceexpand)
@@ -665,7 +667,6 @@ FMaterial::FMaterial(FTexture * tx, bool forceexpand)
 	mTextureLayers.ShrinkToFit();
 	mMaxBound = -1;
 	mMaterials.Push(this);
-	tx->gl_info.Material = this;
 	if (tx->bHasCanvas) tx->gl_info.mIsTransparent = 0;
 	tex = tx;
 
@@ -1047,7 +1048,21 @@ FMaterial * FMaterial::ValidateTexture(FTexture * tex)
 		FMaterial *gltex = tex->gl_info.Material;
 		if (gltex == NULL) 
 		{
-			gltex = new FMaterial(tex, false);
+			// Walls may get processed on worker threads, so creation has to be locked.
+			// The material is only published once it is fully constructed so that
+			// the unlocked check above never sees a half initialized one.
+			FThreadLockGuard lock(MaterialLock);
+			gltex = tex->gl_info.Material;
+			if (gltex == NULL)
+			{
+				gltex = new FMaterial(tex, false);
+				WriteBarrier();
+				tex->gl_info.Material = gltex;
+			}
+		}
+		else
+		{
+			ReadBarrier();
 		}
 		return gltex;
 	}
@@ -1059,6 +1074,32 @@ FMaterial * FMaterial::ValidateTexture(FTextureID no, bool translate)
 	return ValidateTexture(translate? TexMan(no) : TexMan[no]);
 }
 
+//==========================================================================
+//
+// Finds out whether the texture has translucent pixels. This requires
+// creating the texture buffer once.
+//
+//==========================================================================
+
+void FMaterial::CheckTransparent() const
+{
+	FThreadLockGuard lock(MaterialLock);
+
+	if (mBaseLayer->bIsTransparent == -1) 
+	{
+		if (!mBaseLayer->tex->bHasCanvas)
+		{
+			int w, h;
+			unsigned char *buffer = CreateTexBuffer(CM_DEFAULT, 0, w, h);
+			delete [] buffer;
+		}
+		else
+		{
+			mBaseLayer->bIsTransparent = 0;
+		}
+	}
+}
+
 
 //==========================================================================
 //
@@ -228,21 +228,10 @@ public:
 
 	bool GetTransparent() const
 	{
-		if (mBaseLayer->bIsTransparent == -1) 
-		{
-			if (!mBaseLayer->tex->bHasCanvas)
-			{
-				int w, h;
-				unsigned char *buffer = CreateTexBuffer(CM_DEFAULT, 0, w, h);
-				delete [] buffer;
-			}
-			else
-			{
-				mBaseLayer->bIsTransparent = 0;
-			}
-		}
+		if (mBaseLayer->bIsTransparent == -1) CheckTransparent();
 		return !!mBaseLayer->bIsTransparent;
 	}
+	void CheckTransparent() const;
 
 	static void DeleteAll();
 	static void FlushAll();
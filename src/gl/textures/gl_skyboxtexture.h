@@ -22,6 +22,11 @@ public:
 	bool UseBasePalette();
 	void Unload ();
 	void PrecacheGL();
+	bool GetBuildSources(TArray<FTexture *> &sources)
+	{
+		for (int i = 0; i < 6; i++) if (faces[i] != NULL) sources.Push(faces[i]);
+		return true;
+	}
 
 	void SetSize()
 	{
@@ -60,6 +60,10 @@ enum
 	SPR_NOCHANGE,	// Do not change sprite (frame change is okay)
 };
 
+// Set by the decorate_profile cvar (thingdef_profile.cpp)
+extern bool ActionProfiling;
+void P_ActionProfileSummary();
+
 struct FState
 {
 	FState		*NextState;
@@ -141,7 +145,14 @@ struct FState
 	{
 		if (ActionFunc != NULL)
 		{
-			ActionFunc(self, stateowner, this, ParameterIndex-1, statecall);
+			if (ActionProfiling)
+			{
+				CallProfiledAction(self, stateowner, statecall);
+			}
+			else
+			{
+				ActionFunc(self, stateowner, this, ParameterIndex-1, statecall);
+			}
 			return true;
 		}
 		else
@@ -149,6 +160,7 @@ struct FState
 			return false;
 		}
 	}
+	void CallProfiledAction(AActor *self, AActor *stateowner, StateCallData *statecall);
 	static const PClass *StaticFindStateOwner (const FState *state);
 	static const PClass *StaticFindStateOwner (const FState *state, const FActorInfo *info);
 	static FRandom pr_statetics;
@@ -35,6 +35,10 @@
 #include <string.h>
 #include "name.h"
 #include "c_dispatch.h"
+#include "i_system.h"
+#include "threadpool.h"
+#include "stats.h"
+#include "templates.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -43,9 +47,14 @@
 // that is just large enough to hold it.
 #define BLOCK_SIZE			4096
 
-// How many entries to grow the NameArray by when it needs to grow.
+// How many entries to grow the NameArray by when it needs to grow. After
+// that the array doubles each time, which bounds the memory kept around
+// in the retired copies to the size of the current array.
 #define NAME_GROW_AMOUNT	256
 
+// Memory ordering for the lock-free lookups. Writers publish a new entry
+// with WriteBarrier and readers use ReadBarrier (see threadpool.h).
+
 // TYPES -------------------------------------------------------------------
 
 // Name text is stored in a linked list of NameBlock structures. This
@@ -89,37 +98,11 @@ static const char *PredefinedNames[] =
 
 int FName::NameManager::FindName (const char *text, bool noCreate)
 {
-	if (!Inited)
-	{
-		InitBuckets ();
-	}
-
 	if (text == NULL)
 	{
 		return 0;
 	}
-
-	unsigned int hash = MakeKey (text);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
-
-	// See if the name already exists.
-	while (scanner >= 0)
-	{
-		if (NameArray[scanner].Hash == hash && stricmp (NameArray[scanner].Text, text) == 0)
-		{
-			return scanner;
-		}
-		scanner = NameArray[scanner].NextHash;
-	}
-
-	// If we get here, then the name does not exist.
-	if (noCreate)
-	{
-		return 0;
-	}
-
-	return AddName (text, hash, bucket);
+	return FindName (text, strlen (text), noCreate);
 }
 
 //==========================================================================
@@ -145,16 +128,19 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 	unsigned int bucket = hash % HASH_SIZE;
 	int scanner = Buckets[bucket];
 
+	ReadBarrier ();
+	NameEntry *names = NameArray;
+
 	// See if the name already exists.
 	while (scanner >= 0)
 	{
-		if (NameArray[scanner].Hash == hash &&
-			strnicmp (NameArray[scanner].Text, text, textLen) == 0 &&
-			NameArray[scanner].Text[textLen] == '\0')
+		if (names[scanner].Hash == hash &&
+			strnicmp (names[scanner].Text, text, textLen) == 0 &&
+			names[scanner].Text[textLen] == '\0')
 		{
 			return scanner;
 		}
-		scanner = NameArray[scanner].NextHash;
+		scanner = names[scanner].NextHash;
 	}
 
 	// If we get here, then the name does not exist.
@@ -163,7 +149,7 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 		return 0;
 	}
 
-	return AddName (text, hash, bucket);
+	return AddName (text, textLen, hash, bucket);
 }
 
 //==========================================================================
@@ -171,13 +157,19 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 // FName :: NameManager :: InitBuckets
 //
 // Sets up the hash table and inserts all the default names into the table.
+// This happens during static initialization, before any other threads
+// exist.
 //
 //==========================================================================
 
 void FName::NameManager::InitBuckets ()
 {
 	Inited = true;
-	memset (Buckets, -1, sizeof(Buckets));
+	InsertLock = new FThreadLock;
+	for (int i = 0; i < HASH_SIZE; ++i)
+	{
+		Buckets[i] = -1;
+	}
 
 	// Register built-in names. 'None' must be name 0.
 	for (size_t i = 0; i < countof(PredefinedNames); ++i)
@@ -190,44 +182,79 @@ void FName::NameManager::InitBuckets ()
 //
 // FName :: NameManager :: AddName
 //
-// Adds a new name to the name table.
+// Adds a new name to the name table. Another thread may have added the
+// same name since the caller looked for it, so the bucket is searched
+// again once the lock is held. A single lock is enough here: names are
+// rarely added once the game has started, while the lookups that happen
+// all the time do not need it.
 //
 //==========================================================================
 
-int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned int bucket)
+int FName::NameManager::AddName (const char *text, size_t len, unsigned int hash, unsigned int bucket)
 {
 	char *textstore;
-	NameBlock *block = Blocks;
-	size_t len = strlen (text) + 1;
+	NameBlock *block;
+	int scanner;
+
+	FThreadLockGuard lock (*InsertLock);
+
+	for (scanner = Buckets[bucket]; scanner >= 0; scanner = NameArray[scanner].NextHash)
+	{
+		if (NameArray[scanner].Hash == hash &&
+			strnicmp (NameArray[scanner].Text, text, len) == 0 &&
+			NameArray[scanner].Text[len] == '\0')
+		{
+			return scanner;
+		}
+	}
 
 	// Get a block large enough for the name. Only the first block in the
 	// list is ever considered for name storage.
-	if (block == NULL || block->NextAlloc + len >= BLOCK_SIZE)
+	block = Blocks;
+	if (block == NULL || block->NextAlloc + len + 1 >= BLOCK_SIZE)
 	{
-		block = AddBlock (len);
+		block = AddBlock (len + 1);
 	}
 
 	// Copy the string into the block.
 	textstore = (char *)block + block->NextAlloc;
-	strcpy (textstore, text);
-	block->NextAlloc += len;
+	memcpy (textstore, text, len);
+	textstore[len] = '\0';
+	block->NextAlloc += len + 1;
 
-	// Add an entry for the name to the NameArray
+	// Add an entry for the name to the NameArray. Readers may still be
+	// using the old array, so it is copied instead of reallocated.
 	if (NumNames >= MaxNames)
 	{
 		// If no names have been defined yet, make the first allocation
 		// large enough to hold all the predefined names.
-		MaxNames += MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : NAME_GROW_AMOUNT;
+		int newmax = MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : MaxNames * 2;
+		NameEntry *newarray = (NameEntry *)M_Malloc (newmax * sizeof(NameEntry));
 
-		NameArray = (NameEntry *)M_Realloc (NameArray, MaxNames * sizeof(NameEntry));
+		if (NameArray != NULL)
+		{
+			memcpy (newarray, NameArray, NumNames * sizeof(NameEntry));
+			if (NumRetired == MAX_RETIRED)
+			{
+				I_FatalError ("Too many names");
+			}
+			Retired[NumRetired++] = NameArray;
+		}
+		WriteBarrier ();
+		NameArray = newarray;
+		MaxNames = newmax;
 	}
 
-	NameArray[NumNames].Text = textstore;
-	NameArray[NumNames].Hash = hash;
-	NameArray[NumNames].NextHash = Buckets[bucket];
-	Buckets[bucket] = NumNames;
+	int index = NumNames;
+	NameArray[index].Text = textstore;
+	NameArray[index].Hash = hash;
+	NameArray[index].NextHash = Buckets[bucket];
 
-	return NumNames++;
+	// The entry must be complete before anybody can find it.
+	WriteBarrier ();
+	Buckets[bucket] = index;
+	NumNames = index + 1;
+	return index;
 }
 
 //==========================================================================
@@ -279,6 +306,88 @@ FName::NameManager::~NameManager()
 		M_Free (NameArray);
 		NameArray = NULL;
 	}
+	for (int i = 0; i < NumRetired; ++i)
+	{
+		M_Free (Retired[i]);
+	}
+	NumRetired = 0;
 	NumNames = MaxNames = 0;
-	memset (Buckets, -1, sizeof(Buckets));
+	for (int i = 0; i < HASH_SIZE; ++i)
+	{
+		Buckets[i] = -1;
+	}
+	delete InsertLock;
+	InsertLock = NULL;
+	// Start over if anything still looks up a name after this.
+	Inited = false;
+}
+
+//==========================================================================
+//
+// CCMD bench_names
+//
+// Interns the same set of new names from all worker threads at once,
+// each thread in a different order, and checks that every thread got
+// the same index for each name.
+//
+//==========================================================================
+
+struct FNameBenchData
+{
+	int Count;
+	int Run;
+	int NumJobs;
+	TArray<int> Indices;	// Count entries per job
+};
+
+static void NameBenchJob(void *userdata, int job)
+{
+	FNameBenchData *data = (FNameBenchData *)userdata;
+	int *indices = &data->Indices[job * data->Count];
+	char name[64];
+
+	for (int i = 0; i < data->Count; ++i)
+	{
+		// Let the jobs start at different places so that they race each
+		// other for the same names.
+		int n = (i + job * data->Count / data->NumJobs) % data->Count;
+		mysnprintf (name, countof(name), "bench_%d_%d", data->Run, n);
+		indices[n] = FName(name);
+	}
+}
+
+CCMD (bench_names)
+{
+	static int run;
+	FNameBenchData data;
+	cycle_t timer;
+
+	data.Count = argv.argc() > 1 ? atoi (argv[1]) : 10000;
+	data.NumJobs = ThreadPool.GetNumThreads() * 4;
+	data.Run = run++;
+	if (data.Count < 1) data.Count = 1;
+	data.Indices.Resize (data.Count * data.NumJobs);
+
+	int before = FName::GetNumNames();
+	timer.Reset();
+	timer.Clock();
+	ThreadPool.ParallelFor (data.NumJobs, NameBenchJob, &data);
+	timer.Unclock();
+
+	int errors = 0;
+	for (int job = 1; job < data.NumJobs; ++job)
+	{
+		for (int i = 0; i < data.Count; ++i)
+		{
+			if (data.Indices[job * data.Count + i] != data.Indices[i])
+			{
+				errors++;
+			}
+		}
+	}
+	int added = FName::GetNumNames() - before;
+	double lookups = (double)data.Count * data.NumJobs;
+	Printf ("%d threads: %.0f lookups, %d names added in %.2f ms, %.0f lookups/s, %d mismatches\n",
+		ThreadPool.GetNumThreads(), lookups, added, timer.TimeMS(),
+		lookups * 1000. / MAX(timer.TimeMS(), 0.001), errors);
 }
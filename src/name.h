@@ -69,6 +69,7 @@ public:
 	int SetName (const char *text, bool noCreate=false) { return Index = NameData.FindName (text, noCreate); }
 
 	bool IsValidName() const { return (unsigned)Index < (unsigned)NameData.NumNames; }
+	static int GetNumNames() { return NameData.NumNames; }
 
 	// Note that the comparison operators compare the names' indices, not
 	// their text, so they cannot be used to do a lexicographical sort.
@@ -96,6 +97,10 @@ protected:
 		int NextHash;
 	};
 
+	// Names may be looked up and added from several threads at once.
+	// Lookups take no lock: entries never change once they are in a
+	// hash chain, and when NameArray grows the old copy is kept around
+	// for readers that still use it. Adding a name takes InsertLock.
 	struct NameManager
 	{
 		// No constructor because we can't ensure that it actually gets
@@ -103,17 +108,21 @@ protected:
 		// means this struct must only exist in the program's BSS section.
 		~NameManager();
 
-		enum { HASH_SIZE = 1024 };
+		enum { HASH_SIZE = 1024, MAX_RETIRED = 32 };
 		struct NameBlock;
 
 		NameBlock *Blocks;
-		NameEntry *NameArray;
-		int NumNames, MaxNames;
-		int Buckets[HASH_SIZE];
+		NameEntry *volatile NameArray;
+		volatile int NumNames;
+		int MaxNames;
+		volatile int Buckets[HASH_SIZE];
+		NameEntry *Retired[MAX_RETIRED];
+		int NumRetired;
+		class FThreadLock *InsertLock;	// created by InitBuckets
 
 		int FindName (const char *text, bool noCreate);
 		int FindName (const char *text, size_t textlen, bool noCreate);
-		int AddName (const char *text, unsigned int hash, unsigned int bucket);
+		int AddName (const char *text, size_t textlen, unsigned int hash, unsigned int bucket);
 		NameBlock *AddBlock (size_t len);
 		void InitBuckets ();
 		static bool Inited;
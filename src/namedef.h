@@ -326,6 +326,7 @@ xx(Arg4)
 xx(Arg0Str)
 xx(Arg1Str)
 xx(Id)
+xx(Moreids)
 xx(V1)
 xx(V2)
 
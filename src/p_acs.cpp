@@ -74,7 +74,9 @@
 #include "po_man.h"
 #include "actorptrselect.h"
 #include "farchive.h"
+#include "stats.h"
 #include "decallib.h"
+#include "m_argv.h"
 
 #include "g_shared/a_pickups.h"
 
@@ -163,6 +165,15 @@ struct FBehavior::ArrayInfo
 };
 
 TArray<FBehavior *> FBehavior::StaticModules;
+
+// Results of StaticFindScript. Must be flushed whenever a module's
+// script directory is created or destroyed.
+struct FScriptCacheEntry
+{
+	const ScriptPtr *Script;
+	FBehavior *Module;
+};
+static TMap<int, FScriptCacheEntry> ScriptCache;
 TArray<FString> ACS_StringBuilderStack;
 
 #define STRINGBUILDER_START(Builder) if (Builder.IsNotEmpty() || ACS_StringBuilderStack.Size()) { ACS_StringBuilderStack.Push(Builder); Builder = ""; }
@@ -248,8 +259,8 @@ ACSStringPool GlobalACSStrings;
 
 ACSStringPool::ACSStringPool()
 {
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	FirstFreeEntry = 0;
+	Rehash(MIN_BUCKETS);
+	NumLookups = NumHits = 0;
 }
 
 //============================================================================
@@ -263,8 +274,53 @@ ACSStringPool::ACSStringPool()
 void ACSStringPool::Clear()
 {
 	Pool.Clear();
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	FirstFreeEntry = 0;
+	FreeEntries.Clear();
+	Rehash(MIN_BUCKETS);
+}
+
+//============================================================================
+//
+// ACSStringPool :: Rehash
+//
+// Rebuilds the hash chains for a new number of buckets.
+//
+//============================================================================
+
+void ACSStringPool::Rehash(unsigned int numbuckets)
+{
+	PoolBuckets.Resize(numbuckets);
+	memset(&PoolBuckets[0], 0xFF, numbuckets * sizeof(unsigned int));
+	for (unsigned int i = 0; i < Pool.Size(); ++i)
+	{
+		PoolEntry *entry = &Pool[i];
+		if (entry->Next != FREE_ENTRY)
+		{
+			unsigned int h = entry->Hash & (numbuckets - 1);
+			entry->Next = PoolBuckets[h];
+			PoolBuckets[h] = i;
+		}
+	}
+}
+
+//============================================================================
+//
+// ACSStringPool :: RebuildFreeList
+//
+// Collects all free entries. They are stored in descending order so that
+// the lowest ones get reused first.
+//
+//============================================================================
+
+void ACSStringPool::RebuildFreeList()
+{
+	FreeEntries.Clear();
+	for (unsigned int i = Pool.Size(); i-- > 0; )
+	{
+		if (Pool[i].Next == FREE_ENTRY)
+		{
+			FreeEntries.Push(i);
+		}
+	}
 }
 
 //============================================================================
@@ -280,26 +336,24 @@ int ACSStringPool::AddString(const char *str, const SDWORD *stack, int stackdept
 {
 	size_t len = strlen(str);
 	unsigned int h = SuperFastHash(str, len);
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, len, h, bucketnum);
+	int i = FindString(str, len, h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
 	FString fstr(str);
-	return InsertString(fstr, h, bucketnum, stack, stackdepth);
+	return InsertString(fstr, h, stack, stackdepth);
 }
 
 int ACSStringPool::AddString(FString &str, const SDWORD *stack, int stackdepth)
 {
 	unsigned int h = SuperFastHash(str.GetChars(), str.Len());
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, str.Len(), h, bucketnum);
+	int i = FindString(str, str.Len(), h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
-	return InsertString(str, h, bucketnum, stack, stackdepth);
+	return InsertString(str, h, stack, stackdepth);
 }
 
 //============================================================================
@@ -502,36 +556,35 @@ void ACSStringPool::PurgeStrings()
 {
 	// Clear the hash buckets. We'll rebuild them as we decide what strings
 	// to keep and which to toss.
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	size_t usedcount = 0, freedcount = 0;
-	for (unsigned int i = 0; i < Pool.Size(); ++i)
+	unsigned int mask = PoolBuckets.Size() - 1;
+	memset(&PoolBuckets[0], 0xFF, PoolBuckets.Size() * sizeof(unsigned int));
+	FreeEntries.Clear();
+	for (unsigned int i = Pool.Size(); i-- > 0; )
 	{
 		PoolEntry *entry = &Pool[i];
 		if (entry->Next != FREE_ENTRY)
 		{
 			if (entry->LockCount == 0)
 			{
-				freedcount++;
 				// Mark this entry as free.
 				entry->Next = FREE_ENTRY;
-				if (i < FirstFreeEntry)
-				{
-					FirstFreeEntry = i;
-				}
 				// And free the string.
 				entry->Str = "";
 			}
 			else
 			{
-				usedcount++;
 				// Rehash this entry.
-				unsigned int h = entry->Hash % NUM_BUCKETS;
+				unsigned int h = entry->Hash & mask;
 				entry->Next = PoolBuckets[h];
 				PoolBuckets[h] = i;
 				// Remove MarkString's mark.
 				entry->LockCount &= 0x7FFFFFFF;
 			}
 		}
+		if (entry->Next == FREE_ENTRY)
+		{
+			FreeEntries.Push(i);
+		}
 	}
 }
 
@@ -544,9 +597,10 @@ void ACSStringPool::PurgeStrings()
 //
 //============================================================================
 
-int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::FindString(const char *str, size_t len, unsigned int h)
 {
-	unsigned int i = PoolBuckets[bucketnum];
+	unsigned int i = PoolBuckets[h & (PoolBuckets.Size() - 1)];
+	NumLookups++;
 	while (i != NO_ENTRY)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -554,6 +608,7 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 		if (entry->Hash == h && entry->Str.Len() == len &&
 			memcmp(entry->Str.GetChars(), str, len) == 0)
 		{
+			NumHits++;
 			return i;
 		}
 		i = entry->Next;
@@ -569,27 +624,41 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 //
 //============================================================================
 
-int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucketnum, const SDWORD *stack, int stackdepth)
+int ACSStringPool::InsertString(FString &str, unsigned int h, const SDWORD *stack, int stackdepth)
 {
-	unsigned int index = FirstFreeEntry;
-	if (index >= MIN_GC_SIZE && index == Pool.Max())
+	unsigned int index;
+
+	if (FreeEntries.Size() == 0 && Pool.Size() >= MIN_GC_SIZE && Pool.Size() == Pool.Max())
 	{ // We will need to grow the array. Try a garbage collection first.
 		P_CollectACSGlobalStrings(stack, stackdepth);
-		index = FirstFreeEntry;
-	}
-	if (FirstFreeEntry >= STRPOOL_LIBRARYID_OR)
-	{ // If we go any higher, we'll collide with the library ID marker.
-		return -1;
+
+		// If most of the pool is still in use it will be full again in no
+		// time. Make room for more strings now, or scripts that keep a lot
+		// of strings alive will trigger a collection every few strings.
+		if (FreeEntries.Size() < Pool.Size() / 4)
+		{
+			Pool.Grow(Pool.Size());
+		}
 	}
-	if (index == Pool.Size())
-	{ // There were no free entries; make a new one.
-		Pool.Reserve(1);
-		FirstFreeEntry++;
+	if (FreeEntries.Size() > 0)
+	{
+		FreeEntries.Pop(index);
 	}
 	else
-	{ // Scan for the next free entry
-		FindFirstFreeEntry(FirstFreeEntry + 1);
+	{
+		index = Pool.Size();
+		if (index >= STRPOOL_LIBRARYID_OR)
+		{ // If we go any higher, we'll collide with the library ID marker.
+			return -1;
+		}
+		Pool.Reserve(1);
+		if (Pool.Size() > PoolBuckets.Size() * 2)
+		{
+			Pool[index].Next = FREE_ENTRY;	// keep Rehash away from the new entry
+			Rehash(PoolBuckets.Size() * 2);
+		}
 	}
+	unsigned int bucketnum = h & (PoolBuckets.Size() - 1);
 	PoolEntry *entry = &Pool[index];
 	entry->Str = str;
 	entry->Hash = h;
@@ -599,23 +668,6 @@ int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucke
 	return index | STRPOOL_LIBRARYID_OR;
 }
 
-//============================================================================
-//
-// ACSStringPool :: FindFirstFreeEntry
-//
-// Finds the first free entry, starting at base.
-//
-//============================================================================
-
-void ACSStringPool::FindFirstFreeEntry(unsigned base)
-{
-	while (base < Pool.Size() && Pool[base].Next != FREE_ENTRY)
-	{
-		base++;
-	}
-	FirstFreeEntry = base;
-}
-
 //============================================================================
 //
 // ACSStringPool :: ReadStrings
@@ -633,7 +685,7 @@ void ACSStringPool::ReadStrings(PNGHandle *png, DWORD id)
 	{
 		FPNGChunkArchive arc(png->File->GetFile(), id, len);
 		int32 i, j, poolsize;
-		unsigned int h, bucketnum;
+		unsigned int h;
 		char *str = NULL;
 
 		arc << poolsize;
@@ -651,20 +703,30 @@ void ACSStringPool::ReadStrings(PNGHandle *png, DWORD id)
 			}
 			arc << str;
 			h = SuperFastHash(str, strlen(str));
-			bucketnum = h % NUM_BUCKETS;
 			Pool[i].Str = str;
 			Pool[i].Hash = h;
 			Pool[i].LockCount = arc.ReadCount();
-			Pool[i].Next = PoolBuckets[bucketnum];
-			PoolBuckets[bucketnum] = i;
+			Pool[i].Next = 0;
 			i++;
 			j = arc.ReadCount();
 		}
+		// Anything after the last string is free, too.
+		for (; i < poolsize; ++i)
+		{
+			Pool[i].Next = FREE_ENTRY;
+			Pool[i].LockCount = 0;
+		}
 		if (str != NULL)
 		{
 			delete[] str;
 		}
-		FindFirstFreeEntry(0);
+		unsigned int numbuckets = MIN_BUCKETS;
+		while (numbuckets * 2 < Pool.Size())
+		{
+			numbuckets <<= 1;
+		}
+		Rehash(numbuckets);
+		RebuildFreeList();
 	}
 }
 
@@ -717,7 +779,22 @@ void ACSStringPool::Dump() const
 			Printf("%4u. (%2d) \"%s\"\n", i, Pool[i].LockCount, Pool[i].Str.GetChars());
 		}
 	}
-	Printf("First free %u\n", FirstFreeEntry);
+	Printf("%u free entries\n", FreeEntries.Size());
+}
+
+//============================================================================
+//
+// ACSStringPool :: GetStats
+//
+//============================================================================
+
+FString ACSStringPool::GetStats() const
+{
+	FString out;
+	out.Format("%u strings, %u free, %u buckets, %.1f%% hits",
+		Pool.Size() - FreeEntries.Size(), FreeEntries.Size(), PoolBuckets.Size(),
+		NumLookups == 0 ? 0. : NumHits * 100. / NumLookups);
+	return out;
 }
 
 //============================================================================
@@ -758,8 +835,14 @@ void P_MarkGlobalVarStrings()
 //
 //============================================================================
 
+static cycle_t ACSStringCollectTime;
+static unsigned int ACSStringCollections;
+static double ACSStringCollectTotal;
+
 void P_CollectACSGlobalStrings(const SDWORD *stack, int stackdepth)
 {
+	ACSStringCollectTime.Reset();
+	ACSStringCollectTime.Clock();
 	if (stack != NULL && stackdepth != 0)
 	{
 		GlobalACSStrings.MarkStringArray(stack, stackdepth);
@@ -768,6 +851,17 @@ void P_CollectACSGlobalStrings(const SDWORD *stack, int stackdepth)
 	P_MarkWorldVarStrings();
 	P_MarkGlobalVarStrings();
 	GlobalACSStrings.PurgeStrings();
+	ACSStringCollectTime.Unclock();
+	ACSStringCollections++;
+	ACSStringCollectTotal += ACSStringCollectTime.TimeMS();
+}
+
+ADD_STAT(acsstrings)
+{
+	FString out = GlobalACSStrings.GetStats();
+	out.AppendFormat("\n%u collections, last %.3f ms, total %.2f ms",
+		ACSStringCollections, ACSStringCollectTime.TimeMS(), ACSStringCollectTotal);
+	return out;
 }
 
 #ifdef _DEBUG
@@ -1470,6 +1564,7 @@ void FBehavior::StaticUnloadModules ()
 		delete StaticModules[i];
 	}
 	StaticModules.Clear ();
+	ScriptCache.Clear ();
 }
 
 FBehavior *FBehavior::StaticGetModule (int lib)
@@ -2178,6 +2273,7 @@ FBehavior::FBehavior (int lumpnum, FileReader * fr, int len)
 
 FBehavior::~FBehavior ()
 {
+	ScriptCache.Clear ();
 	if (Scripts != NULL)
 	{
 		delete[] Scripts;
@@ -2232,6 +2328,7 @@ void FBehavior::LoadScriptsDirectory ()
 	} scripts;
 	int i, max;
 
+	ScriptCache.Clear ();
 	NumScripts = 0;
 	Scripts = NULL;
 
@@ -2567,12 +2664,26 @@ const ScriptPtr *FBehavior::FindScript (int script) const
 
 const ScriptPtr *FBehavior::StaticFindScript (int script, FBehavior *&module)
 {
+	FScriptCacheEntry *cached = ScriptCache.CheckKey (script);
+	if (cached != NULL)
+	{
+		if (cached->Script != NULL)
+		{
+			module = cached->Module;
+		}
+		return cached->Script;
+	}
+
+	FScriptCacheEntry &entry = ScriptCache[script];
+	entry.Script = NULL;
+	entry.Module = NULL;
 	for (DWORD i = 0; i < StaticModules.Size(); ++i)
 	{
 		const ScriptPtr *code = StaticModules[i]->FindScript (script);
 		if (code != NULL)
 		{
-			module = StaticModules[i];
+			entry.Script = code;
+			entry.Module = module = StaticModules[i];
 			return code;
 		}
 	}
@@ -5909,6 +6020,79 @@ inline int getshort (int *&pc)
 	return res;
 }
 
+// Returns the opcode at pc without moving past it. Only opcodes below 240
+// are of interest to the callers, so extended opcodes are not decoded.
+inline int peekpcd (int *pc, ACSFormat fmt, int &len)
+{
+	if (fmt == ACS_LittleEnhanced)
+	{
+		len = 1;
+		return *(BYTE *)pc;
+	}
+	len = 4;
+	return LittleLong(*pc);
+}
+
+//==========================================================================
+//
+// Opcode pair profiling
+//
+// Running with -acsprofile counts how often each opcode is directly
+// followed by each other opcode, which is what decides which sequences
+// are worth fusing in RunScript. The fused paths are disabled while
+// profiling so that every instruction shows up in the counts.
+//
+//==========================================================================
+
+static DWORD *ACSPairCounts;
+static int ACSPairProfiling = -1;
+
+static bool ACS_PairProfiling()
+{
+	if (ACSPairProfiling < 0)
+	{
+		ACSPairProfiling = Args->CheckParm("-acsprofile") != 0;
+		if (ACSPairProfiling)
+		{
+			ACSPairCounts = new DWORD[DLevelScript::PCODE_COMMAND_COUNT * DLevelScript::PCODE_COMMAND_COUNT];
+			memset(ACSPairCounts, 0, sizeof(DWORD) * DLevelScript::PCODE_COMMAND_COUNT * DLevelScript::PCODE_COMMAND_COUNT);
+		}
+	}
+	return !!ACSPairProfiling;
+}
+
+//==========================================================================
+//
+// Execution time profiling
+//
+// With acs_profiletime on, RunScript times each script run as well as
+// every opcode it dispatches. Reading the clock twice per instruction is
+// far from free, so this is off unless someone is hunting for hot scripts.
+// Opcode fusion is disabled meanwhile so that each opcode gets its own time.
+//
+//==========================================================================
+
+CVAR(Bool, acs_profiletime, false, 0)
+
+struct FOpcodeProfile
+{
+	cycle_t Time;
+	unsigned long long Count;
+};
+static FOpcodeProfile *ACSOpcodeProfile;
+
+static void ClearOpcodeProfile()
+{
+	if (ACSOpcodeProfile != NULL)
+	{
+		for (int i = 0; i < DLevelScript::PCODE_COMMAND_COUNT; ++i)
+		{
+			ACSOpcodeProfile[i].Time.Reset();
+			ACSOpcodeProfile[i].Count = 0;
+		}
+	}
+}
+
 static bool CharArrayParms(int &capacity, int &offset, int &a, int *Stack, int &sp, bool ranged)
 {
 	if (ranged)
@@ -6017,6 +6201,25 @@ int DLevelScript::RunScript ()
 	const char *lookup;
 	int optstart = -1;
 	int temp;
+	int oplen;
+	FOpcodeProfile *opprof = NULL;
+	FOpcodeProfile *curop = NULL;
+	cycle_t runtime;
+
+	runtime.Reset();
+	if (acs_profiletime)
+	{
+		if (ACSOpcodeProfile == NULL)
+		{
+			ACSOpcodeProfile = new FOpcodeProfile[PCODE_COMMAND_COUNT];
+			ClearOpcodeProfile();
+		}
+		opprof = ACSOpcodeProfile;
+		runtime.Clock();
+	}
+	const bool fuse = opprof == NULL && !ACS_PairProfiling();
+	DWORD *paircounts = ACSPairCounts;
+	int lastpcd = -1;
 
 	while (state == SCRIPT_Running)
 	{
@@ -6040,6 +6243,30 @@ int DLevelScript::RunScript ()
 			pcd = NEXTWORD;
 		}
 
+		if (paircounts != NULL && (unsigned)pcd < PCODE_COMMAND_COUNT)
+		{
+			if (lastpcd >= 0)
+			{
+				paircounts[lastpcd * PCODE_COMMAND_COUNT + pcd]++;
+			}
+			lastpcd = pcd;
+		}
+
+		if (opprof != NULL)
+		{
+			// Everything up to the next dispatch is billed to this opcode.
+			if (curop != NULL)
+			{
+				curop->Time.Unclock();
+			}
+			curop = (unsigned)pcd < PCODE_COMMAND_COUNT ? &opprof[pcd] : NULL;
+			if (curop != NULL)
+			{
+				curop->Count++;
+				curop->Time.Clock();
+			}
+		}
+
 		switch (pcd)
 		{
 		default:
@@ -6364,12 +6591,33 @@ int DLevelScript::RunScript ()
 			break;
 
 		case PCD_ADD:
-			STACK(2) = STACK(2) + STACK(1);
-			sp--;
-			break;
+			temp = STACK(2) + STACK(1);
+			goto fuseassign;
 
 		case PCD_SUBTRACT:
-			STACK(2) = STACK(2) - STACK(1);
+			temp = STACK(2) - STACK(1);
+		fuseassign:
+			// x = x + y compiles to an add that is immediately stored.
+			if (fuse)
+			{
+				int op = peekpcd(pc, fmt, oplen);
+				if (op == PCD_ASSIGNSCRIPTVAR || op == PCD_ASSIGNMAPVAR)
+				{
+					runaway++;
+					pc = (int *)((BYTE *)pc + oplen);
+					if (op == PCD_ASSIGNSCRIPTVAR)
+					{
+						locals[NEXTBYTE] = temp;
+					}
+					else
+					{
+						*(activeBehavior->MapVars[NEXTBYTE]) = temp;
+					}
+					sp -= 2;
+					break;
+				}
+			}
+			STACK(2) = temp;
 			sp--;
 			break;
 
@@ -6403,32 +6651,47 @@ int DLevelScript::RunScript ()
 			break;
 
 		case PCD_EQ:
-			STACK(2) = (STACK(2) == STACK(1));
-			sp--;
-			break;
+			temp = (STACK(2) == STACK(1));
+			goto fusebranch;
 
 		case PCD_NE:
-			STACK(2) = (STACK(2) != STACK(1));
-			sp--;
-			break;
+			temp = (STACK(2) != STACK(1));
+			goto fusebranch;
 
 		case PCD_LT:
-			STACK(2) = (STACK(2) < STACK(1));
-			sp--;
-			break;
+			temp = (STACK(2) < STACK(1));
+			goto fusebranch;
 
 		case PCD_GT:
-			STACK(2) = (STACK(2) > STACK(1));
-			sp--;
-			break;
+			temp = (STACK(2) > STACK(1));
+			goto fusebranch;
 
 		case PCD_LE:
-			STACK(2) = (STACK(2) <= STACK(1));
-			sp--;
-			break;
+			temp = (STACK(2) <= STACK(1));
+			goto fusebranch;
 
 		case PCD_GE:
-			STACK(2) = (STACK(2) >= STACK(1));
+			temp = (STACK(2) >= STACK(1));
+		fusebranch:
+			// Comparisons are nearly always followed by a conditional jump,
+			// so take the jump here instead of dispatching it separately.
+			// It still counts as two instructions for the runaway check.
+			if (fuse)
+			{
+				int op = peekpcd(pc, fmt, oplen);
+				if (op == PCD_IFGOTO || op == PCD_IFNOTGOTO)
+				{
+					runaway++;
+					pc = (int *)((BYTE *)pc + oplen);
+					if ((temp != 0) == (op == PCD_IFGOTO))
+						pc = activeBehavior->Ofs2PC (LittleLong(*pc));
+					else
+						pc++;
+					sp -= 2;
+					break;
+				}
+			}
+			STACK(2) = temp;
 			sp--;
 			break;
 
@@ -9319,9 +9582,18 @@ scriptwait:
  		}
  	}
 
+	if (opprof != NULL)
+	{
+		if (curop != NULL)
+		{
+			curop->Time.Unclock();
+		}
+		runtime.Unclock();
+	}
+
 	if (runaway != 0 && InModuleScriptNumber >= 0)
 	{
-		activeBehavior->GetScriptPtr(InModuleScriptNumber)->ProfileData.AddRun(runaway);
+		activeBehavior->GetScriptPtr(InModuleScriptNumber)->ProfileData.AddRun(runaway, runtime.TimeMS());
 	}
 
 	if (state == SCRIPT_DivideBy0)
@@ -9668,12 +9940,19 @@ void ACSProfileInfo::Reset()
 	NumRuns = 0;
 	MinInstrPerRun = UINT_MAX;
 	MaxInstrPerRun = 0;
+	TotalMS = 0;
+	MaxMSPerRun = 0;
 }
 
-void ACSProfileInfo::AddRun(unsigned int num_instr)
+void ACSProfileInfo::AddRun(unsigned int num_instr, double ms)
 {
 	TotalInstr += num_instr;
 	NumRuns++;
+	TotalMS += ms;
+	if (ms > MaxMSPerRun)
+	{
+		MaxMSPerRun = ms;
+	}
 	if (num_instr < MinInstrPerRun)
 	{
 		MinInstrPerRun = num_instr;
@@ -9772,6 +10051,46 @@ static int STACK_ARGS sort_by_runs(const void *a_, const void *b_)
 	return b->ProfileData->NumRuns - a->ProfileData->NumRuns;
 }
 
+static int STACK_ARGS sort_by_time(const void *a_, const void *b_)
+{
+	const ProfileCollector *a = (const ProfileCollector *)a_;
+	const ProfileCollector *b = (const ProfileCollector *)b_;
+
+	double a_ms = a->ProfileData->TotalMS, b_ms = b->ProfileData->TotalMS;
+	return a_ms < b_ms ? 1 : a_ms > b_ms ? -1 : 0;
+}
+
+//==========================================================================
+//
+// GetProfileName
+//
+// Returns the name of a script or function for the profile listings.
+//
+//==========================================================================
+
+static FString GetProfileName(ProfileCollector *prof, bool functions)
+{
+	FString name;
+
+	if (functions)
+	{
+		DWORD *fnames = (DWORD *)prof->Module->FindChunk(MAKE_ID('F','N','A','M'));
+		if (fnames != NULL && prof->Index >= 0 && prof->Index < (int)LittleLong(fnames[2]))
+		{
+			name = (char *)(fnames + 2) + LittleLong(fnames[3+prof->Index]);
+		}
+		else
+		{
+			name.Format("Function %d", prof->Index);
+		}
+	}
+	else
+	{
+		name = ScriptPresentation(prof->Module->GetScriptPtr(prof->Index)->Number).GetChars() + 7;
+	}
+	return name;
+}
+
 static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 	int (STACK_ARGS *sorter)(const void *, const void *), bool functions)
 {
@@ -9785,6 +10104,7 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 	unsigned int limit;
 	char modname[13];
 	char scriptname[21];
+	char msbuf[16];
 
 	qsort(&profiles[0], profiles.Size(), sizeof(ProfileCollector), sorter);
 
@@ -9799,8 +10119,8 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 		limit = UINT_MAX;
 	}
 
-	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max\n", typelabels[functions]);
-	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- -------\n");
+	Printf(TEXTCOLOR_YELLOW "Module       %-20s      Total    Runs     Avg     Min     Max    Time ms\n", typelabels[functions]);
+	Printf(TEXTCOLOR_YELLOW "------------ -------------------- ---------- ------- ------- ------- ------- ----------\n");
 	for (unsigned int i = 0; i < limit && i < profiles.Size(); ++i)
 	{
 		ProfileCollector *prof = &profiles[i];
@@ -9813,35 +10133,135 @@ static void ShowProfileData(TArray<ProfileCollector> &profiles, long ilimit,
 		mysnprintf(modname, sizeof(modname), "%s", prof->Module->GetModuleName());
 
 		// Script/function name
+		mysnprintf(scriptname, sizeof(scriptname), "%s", GetProfileName(prof, functions).GetChars());
+
+		// Functions are not timed on their own; their time is part of the calling script's.
 		if (functions)
 		{
-			DWORD *fnames = (DWORD *)prof->Module->FindChunk(MAKE_ID('F','N','A','M'));
-			if (prof->Index >= 0 && prof->Index < (int)LittleLong(fnames[2]))
-			{
-				mysnprintf(scriptname, sizeof(scriptname), "%s",
-					(char *)(fnames + 2) + LittleLong(fnames[3+prof->Index]));
-			}
-			else
-			{
-				mysnprintf(scriptname, sizeof(scriptname), "Function %d", prof->Index);
-			}
+			mysnprintf(msbuf, sizeof(msbuf), "%10s", "-");
 		}
 		else
 		{
-			mysnprintf(scriptname, sizeof(scriptname), "%s",
-				ScriptPresentation(prof->Module->GetScriptPtr(prof->Index)->Number).GetChars() + 7);
+			mysnprintf(msbuf, sizeof(msbuf), "%10.3f", prof->ProfileData->TotalMS);
 		}
-		Printf("%-12s %-20s%11llu%8u%8u%8u%8u\n",
+		Printf("%-12s %-20s%11llu%8u%8u%8u%8u %s\n",
 			modname, scriptname,
 			prof->ProfileData->TotalInstr,
 			prof->ProfileData->NumRuns,
 			unsigned(prof->ProfileData->TotalInstr / prof->ProfileData->NumRuns),
 			prof->ProfileData->MinInstrPerRun,
-			prof->ProfileData->MaxInstrPerRun
+			prof->ProfileData->MaxInstrPerRun,
+			msbuf
 			);
 	}
 }
 
+static int STACK_ARGS sort_opcodes(const void *a_, const void *b_)
+{
+	int a = *(const int *)a_;
+	int b = *(const int *)b_;
+	double a_ms = ACSOpcodeProfile[a].Time.TimeMS();
+	double b_ms = ACSOpcodeProfile[b].Time.TimeMS();
+
+	return a_ms < b_ms ? 1 : a_ms > b_ms ? -1 : 0;
+}
+
+static void ShowOpcodeProfile(long ilimit)
+{
+	if (ACSOpcodeProfile == NULL)
+	{
+		Printf("No opcode timings. Set acs_profiletime to collect them.\n");
+		return;
+	}
+
+	TArray<int> opcodes;
+	double total = 0;
+
+	for (int i = 0; i < DLevelScript::PCODE_COMMAND_COUNT; ++i)
+	{
+		if (ACSOpcodeProfile[i].Count != 0)
+		{
+			opcodes.Push(i);
+			total += ACSOpcodeProfile[i].Time.TimeMS();
+		}
+	}
+	if (opcodes.Size() == 0)
+	{
+		return;
+	}
+	qsort(&opcodes[0], opcodes.Size(), sizeof(int), sort_opcodes);
+
+	unsigned int limit = ilimit > 0 ? (unsigned int)ilimit : UINT_MAX;
+	Printf(TEXTCOLOR_ORANGE "Opcodes by time:\n");
+	Printf(TEXTCOLOR_YELLOW "Opcode        Count    Time ms  ns/instr      %%\n");
+	Printf(TEXTCOLOR_YELLOW "------ ------------ ---------- --------- ------\n");
+	for (unsigned int i = 0; i < limit && i < opcodes.Size(); ++i)
+	{
+		FOpcodeProfile *op = &ACSOpcodeProfile[opcodes[i]];
+		double ms = op->Time.TimeMS();
+		Printf("%6d %12llu %10.3f %9.1f %6.2f\n", opcodes[i], op->Count, ms,
+			ms * 1e6 / op->Count, total > 0 ? ms * 100 / total : 0.);
+	}
+}
+
+//==========================================================================
+//
+// DumpProfileCSV
+//
+// Writes everything the profiler knows to a CSV file for sorting and
+// comparing in a spreadsheet.
+//
+//==========================================================================
+
+static void WriteProfileCSV(FILE *f, TArray<ProfileCollector> &profiles, bool functions)
+{
+	for (unsigned int i = 0; i < profiles.Size(); ++i)
+	{
+		ProfileCollector *prof = &profiles[i];
+		if (prof->ProfileData->NumRuns == 0)
+		{
+			continue;
+		}
+		FString name = GetProfileName(prof, functions);
+		name.Substitute("\"", "\"\"");
+		fprintf(f, "%s,\"%s\",\"%s\",%llu,%u,%u,%u,%.4f,%.4f\n",
+			functions ? "function" : "script",
+			prof->Module->GetModuleName(), name.GetChars(),
+			prof->ProfileData->TotalInstr,
+			prof->ProfileData->NumRuns,
+			prof->ProfileData->MinInstrPerRun,
+			prof->ProfileData->MaxInstrPerRun,
+			prof->ProfileData->TotalMS,
+			prof->ProfileData->MaxMSPerRun);
+	}
+}
+
+static void DumpProfileCSV(const char *filename, TArray<ProfileCollector> &scripts, TArray<ProfileCollector> &functions)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL)
+	{
+		Printf("Could not open %s for writing\n", filename);
+		return;
+	}
+	fprintf(f, "type,module,name,instructions,runs,min,max,ms,maxms\n");
+	WriteProfileCSV(f, scripts, false);
+	WriteProfileCSV(f, functions, true);
+	if (ACSOpcodeProfile != NULL)
+	{
+		for (int i = 0; i < DLevelScript::PCODE_COMMAND_COUNT; ++i)
+		{
+			if (ACSOpcodeProfile[i].Count != 0)
+			{
+				fprintf(f, "opcode,,%d,%llu,,,,%.4f,\n", i, ACSOpcodeProfile[i].Count,
+					ACSOpcodeProfile[i].Time.TimeMS());
+			}
+		}
+	}
+	fclose(f);
+	Printf("Wrote ACS profile to %s\n", filename);
+}
+
 CCMD(acsprofile)
 {
 	static int (STACK_ARGS *sort_funcs[])(const void*, const void *) =
@@ -9850,10 +10270,11 @@ CCMD(acsprofile)
 		sort_by_min,
 		sort_by_max,
 		sort_by_avg,
-		sort_by_runs
+		sort_by_runs,
+		sort_by_time
 	};
-	static const char *sort_names[] = { "total", "min", "max", "avg", "runs" };
-	static const BYTE sort_match_len[] = {   1,     2,     2,     1,      1 };
+	static const char *sort_names[] = { "total", "min", "max", "avg", "runs", "time" };
+	static const BYTE sort_match_len[] = {   1,     2,     2,     1,      1,      2 };
 
 	TArray<ProfileCollector> ScriptProfiles, FuncProfiles;
 	long limit = 10;
@@ -9871,6 +10292,24 @@ CCMD(acsprofile)
 		{
 			ClearProfiles(ScriptProfiles);
 			ClearProfiles(FuncProfiles);
+			ClearOpcodeProfile();
+			return;
+		}
+		// `acsprofile csv <file>` writes all collected data to a file.
+		if (stricmp(argv[1], "csv") == 0)
+		{
+			if (argv.argc() < 3)
+			{
+				Printf("Usage: acsprofile csv <filename>\n");
+				return;
+			}
+			DumpProfileCSV(argv[2], ScriptProfiles, FuncProfiles);
+			return;
+		}
+		// `acsprofile opcodes` lists the time spent in each opcode.
+		if (stricmp(argv[1], "opcodes") == 0)
+		{
+			ShowOpcodeProfile(argv.argc() > 2 ? strtol(argv[2], NULL, 0) : 10);
 			return;
 		}
 		for (int i = 1; i < argv.argc(); ++i)
@@ -9903,7 +10342,9 @@ CCMD(acsprofile)
 			{
 				Printf("Unknown option '%s'\n", argv[i]);
 				Printf("acsprofile clear : Reset profiling information\n");
-				Printf("acsprofile [total|min|max|avg|runs] [<limit>]\n");
+				Printf("acsprofile [total|min|max|avg|runs|time] [<limit>]\n");
+				Printf("acsprofile opcodes [<limit>] : Show time per opcode\n");
+				Printf("acsprofile csv <filename> : Write profile to a file\n");
 				return;
 			}
 		}
@@ -9912,3 +10353,67 @@ CCMD(acsprofile)
 	ShowProfileData(ScriptProfiles, limit, sorter, false);
 	ShowProfileData(FuncProfiles, limit, sorter, true);
 }
+
+
+struct FOpcodePair
+{
+	WORD First, Second;
+	DWORD Count;
+};
+
+static int STACK_ARGS sort_pairs(const void *a_, const void *b_)
+{
+	const FOpcodePair *a = (const FOpcodePair *)a_;
+	const FOpcodePair *b = (const FOpcodePair *)b_;
+
+	return a->Count < b->Count ? 1 : a->Count > b->Count ? -1 : 0;
+}
+
+//==========================================================================
+//
+// CCMD acspairs
+//
+// Lists the most frequently executed opcode pairs. Needs -acsprofile.
+//
+//==========================================================================
+
+CCMD(acspairs)
+{
+	if (!ACS_PairProfiling())
+	{
+		Printf("Opcode pairs are only counted when running with -acsprofile\n");
+		return;
+	}
+	if (argv.argc() > 1 && stricmp(argv[1], "clear") == 0)
+	{
+		memset(ACSPairCounts, 0, sizeof(DWORD) * DLevelScript::PCODE_COMMAND_COUNT * DLevelScript::PCODE_COMMAND_COUNT);
+		return;
+	}
+
+	unsigned int limit = argv.argc() > 1 ? (unsigned int)strtoul(argv[1], NULL, 0) : 20;
+	TArray<FOpcodePair> pairs;
+	QWORD total = 0;
+
+	for (int i = 0; i < DLevelScript::PCODE_COMMAND_COUNT * DLevelScript::PCODE_COMMAND_COUNT; ++i)
+	{
+		if (ACSPairCounts[i] != 0)
+		{
+			FOpcodePair pair = { WORD(i / DLevelScript::PCODE_COMMAND_COUNT), WORD(i % DLevelScript::PCODE_COMMAND_COUNT), ACSPairCounts[i] };
+			pairs.Push(pair);
+			total += ACSPairCounts[i];
+		}
+	}
+	if (pairs.Size() == 0)
+	{
+		return;
+	}
+	qsort(&pairs[0], pairs.Size(), sizeof(FOpcodePair), sort_pairs);
+
+	Printf(TEXTCOLOR_YELLOW "First Second      Count      %%\n");
+	Printf(TEXTCOLOR_YELLOW "----- ------ ---------- ------\n");
+	for (unsigned int i = 0; i < limit && i < pairs.Size(); ++i)
+	{
+		Printf("%5d %6d %10u %6.2f\n", pairs[i].First, pairs[i].Second, pairs[i].Count,
+			pairs[i].Count * 100. / total);
+	}
+}
@@ -96,13 +96,15 @@ public:
 	void Dump() const;
 	void ReadStrings(PNGHandle *png, DWORD id);
 	void WriteStrings(FILE *file, DWORD id) const;
+	FString GetStats() const;
 
 private:
-	int FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum);
-	int InsertString(FString &str, unsigned int h, unsigned int bucketnum, const SDWORD *stack, int stackdepth);
-	void FindFirstFreeEntry(unsigned int base);
+	int FindString(const char *str, size_t len, unsigned int h);
+	int InsertString(FString &str, unsigned int h, const SDWORD *stack, int stackdepth);
+	void Rehash(unsigned int numbuckets);
+	void RebuildFreeList();
 
-	enum { NUM_BUCKETS = 251 };
+	enum { MIN_BUCKETS = 256 };			// Bucket count is a power of 2 and grows with the pool
 	enum { FREE_ENTRY = 0xFFFFFFFE };	// Stored in PoolEntry's Next field
 	enum { NO_ENTRY = 0xFFFFFFFF };
 	enum { MIN_GC_SIZE = 100 };			// Don't auto-collect until there are this many strings
@@ -114,8 +116,9 @@ private:
 		unsigned int LockCount;
 	};
 	TArray<PoolEntry> Pool;
-	unsigned int PoolBuckets[NUM_BUCKETS];
-	unsigned int FirstFreeEntry;
+	TArray<unsigned int> PoolBuckets;
+	TArray<unsigned int> FreeEntries;	// Free slots, lowest index last
+	unsigned int NumLookups, NumHits;
 };
 extern ACSStringPool GlobalACSStrings;
 
@@ -131,9 +134,11 @@ struct ACSProfileInfo
 	unsigned int NumRuns;
 	unsigned int MinInstrPerRun;
 	unsigned int MaxInstrPerRun;
+	double TotalMS;					// Only collected with acs_profiletime
+	double MaxMSPerRun;
 
 	ACSProfileInfo();
-	void AddRun(unsigned int num_instr);
+	void AddRun(unsigned int num_instr, double ms = 0);
 	void Reset();
 };
 
@@ -66,6 +66,7 @@
 #include "farchive.h"
 #include "r_data/colormaps.h"
 #include "r_renderer.h"
+#include "memarena.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -2714,7 +2715,92 @@ void P_NightmareRespawn (AActor *mobj)
 }
 
 
-AActor *AActor::TIDHash[128];
+//==========================================================================
+//
+// TID chains
+//
+// Every TID in use has its own chain of actors, so looking up a TID never
+// has to skip actors with other TIDs. The chains are found through a hash
+// table that grows with the number of TIDs. Since actors point back at the
+// chain head through iprev, the heads are never moved, and they are only
+// freed by FreeTIDChains once the level's actors are gone. That also keeps
+// it safe for ClearTIDHashes to merely empty them while the previous
+// level's actors still exist.
+//
+//==========================================================================
+
+struct FTIDChain
+{
+	AActor *First;
+	FTIDChain *HashNext;
+	int TID;
+};
+
+static FMemArena TIDChainArena;
+static TArray<FTIDChain *> TIDBuckets;
+static unsigned NumTIDChains;
+
+static inline unsigned TIDHashIndex (int tid)
+{
+	return (unsigned)tid & (TIDBuckets.Size() - 1);
+}
+
+static void ResizeTIDBuckets (unsigned size)
+{
+	TArray<FTIDChain *> old;
+	unsigned i;
+
+	old.Resize (TIDBuckets.Size());
+	for (i = 0; i < TIDBuckets.Size(); ++i)
+	{
+		old[i] = TIDBuckets[i];
+	}
+	TIDBuckets.Resize (size);
+	memset (&TIDBuckets[0], 0, size * sizeof(FTIDChain *));
+	for (i = 0; i < old.Size(); ++i)
+	{
+		FTIDChain *chain, *next;
+		for (chain = old[i]; chain != NULL; chain = next)
+		{
+			unsigned hash = TIDHashIndex (chain->TID);
+			next = chain->HashNext;
+			chain->HashNext = TIDBuckets[hash];
+			TIDBuckets[hash] = chain;
+		}
+	}
+}
+
+AActor **AActor::FindTIDChain (int tid, bool create)
+{
+	FTIDChain *chain;
+
+	if (TIDBuckets.Size() != 0)
+	{
+		for (chain = TIDBuckets[TIDHashIndex (tid)]; chain != NULL; chain = chain->HashNext)
+		{
+			if (chain->TID == tid)
+			{
+				return &chain->First;
+			}
+		}
+	}
+	if (!create)
+	{
+		return NULL;
+	}
+	if (NumTIDChains >= TIDBuckets.Size())
+	{
+		ResizeTIDBuckets (MAX(256u, TIDBuckets.Size() * 2));
+	}
+	unsigned hash = TIDHashIndex (tid);
+	chain = (FTIDChain *)TIDChainArena.Alloc (sizeof(FTIDChain));
+	chain->First = NULL;
+	chain->TID = tid;
+	chain->HashNext = TIDBuckets[hash];
+	TIDBuckets[hash] = chain;
+	NumTIDChains++;
+	return &chain->First;
+}
 
 //
 // P_ClearTidHashes
@@ -2724,7 +2810,39 @@ AActor *AActor::TIDHash[128];
 
 void AActor::ClearTIDHashes ()
 {
-	memset(TIDHash, 0, sizeof(TIDHash));
+	for (unsigned i = 0; i < TIDBuckets.Size(); ++i)
+	{
+		for (FTIDChain *chain = TIDBuckets[i]; chain != NULL; chain = chain->HashNext)
+		{
+			chain->First = NULL;
+		}
+	}
+}
+
+//
+// FreeTIDChains
+//
+// Releases the chain heads. Must only be called after all thinkers have
+// been destroyed. Travelling actors survive that, and an inventory item
+// may still be in a chain if a script gave it a TID, so they are taken
+// out of their chains first. They keep their TIDs, just like the pawns.
+//
+
+void AActor::FreeTIDChains ()
+{
+	TThinkerIterator<AActor> it (STAT_TRAVELLING);
+	AActor *mo;
+
+	while ((mo = it.Next ()) != NULL)
+	{
+		mo->iprev = NULL;
+		mo->inext = NULL;
+	}
+
+	TIDBuckets.Clear ();
+	TIDBuckets.ShrinkToFit ();
+	NumTIDChains = 0;
+	TIDChainArena.FreeAllBlocks ();
 }
 
 //
@@ -2743,11 +2861,11 @@ void AActor::AddToHash ()
 	}
 	else
 	{
-		int hash = TIDHASH (tid);
+		AActor **chain = FindTIDChain (tid, true);
 
-		inext = TIDHash[hash];
-		iprev = &TIDHash[hash];
-		TIDHash[hash] = this;
+		inext = *chain;
+		iprev = chain;
+		*chain = this;
 		if (inext)
 		{
 			inext->iprev = &inext;
@@ -2786,7 +2904,8 @@ void AActor::RemoveFromHash ()
 
 bool P_IsTIDUsed(int tid)
 {
-	AActor *probe = AActor::TIDHash[tid & 127];
+	AActor **chain = AActor::FindTIDChain (tid, false);
+	AActor *probe = chain != NULL ? *chain : NULL;
 	while (probe != NULL)
 	{
 		if (probe->tid == tid)
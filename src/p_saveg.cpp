@@ -52,6 +52,7 @@
 #include "farchive.h"
 #include "p_lnspec.h"
 #include "p_acs.h"
+#include "p_tags.h"
 
 static void CopyPlayer (player_t *dst, player_t *src, const char *name);
 static void ReadOnePlayer (FArchive &arc, bool skipload);
@@ -454,6 +455,12 @@ void P_SerializeWorld (FArchive &arc)
 	{
 		arc << zn->Environment;
 	}
+
+	// Tags may have been changed since the level was set up
+	if (arc.IsLoading())
+	{
+		P_InitTagLists();
+	}
 }
 
 void extsector_t::Serialize(FArchive &arc)
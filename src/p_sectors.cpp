@@ -31,6 +31,9 @@
 #include "r_utility.h"
 #include "r_data/colormaps.h"
 
+// Sectors whose plane heights changed since the renderer last looked at them.
+TArray<sector_t *> DirtyPlaneSectors;
+
 
 // [RH]
 // P_NextSpecialSector()
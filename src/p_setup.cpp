@@ -70,6 +70,7 @@
 #include "r_data/colormaps.h"
 
 #include "fragglescript/t_fs.h"
+#include "p_tags.h"
 
 #define MISSING_TEXTURE_WARN_LIMIT		20
 
@@ -96,7 +97,6 @@ CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, genglnodes, false, CVAR_SERVERINFO);
 CVAR (Bool, showloadtimes, false, 0);
 
-static void P_InitTagLists ();
 static void P_Shutdown ();
 
 bool P_IsBuildMap(MapData *map);
@@ -3224,6 +3224,8 @@ static void P_GroupLines (bool buildmap)
 		{
 			Printf (" time %d:%9.4f ms\n", i, times[i].TimeMS());
 		}
+		Printf (" tag index: %u sector and %u line entries\n",
+			SectorTags.NumEntries(), LineIDs.NumEntries());
 	}
 }
 
@@ -3304,32 +3306,6 @@ void P_LoadBehavior (MapData * map)
 	}
 }
 
-// Hash the sector tags across the sectors and linedefs.
-static void P_InitTagLists ()
-{
-	int i;
-
-	for (i=numsectors; --i>=0; )		// Initially make all slots empty.
-		sectors[i].firsttag = -1;
-	for (i=numsectors; --i>=0; )		// Proceed from last to first sector
-	{									// so that lower sectors appear first
-		int j = (unsigned) sectors[i].tag % (unsigned) numsectors;	// Hash func
-		sectors[i].nexttag = sectors[j].firsttag;	// Prepend sector to chain
-		sectors[j].firsttag = i;
-	}
-
-	// killough 4/17/98: same thing, only for linedefs
-
-	for (i=numlines; --i>=0; )			// Initially make all slots empty.
-		lines[i].firstid = -1;
-	for (i=numlines; --i>=0; )        // Proceed from last to first linedef
-	{									// so that lower linedefs appear first
-		int j = (unsigned) lines[i].id % (unsigned) numlines;	// Hash func
-		lines[i].nextid = lines[j].firstid;	// Prepend linedef to chain
-		lines[j].firstid = i;
-	}
-}
-
 void P_GetPolySpots (MapData * map, TArray<FNodeBuilder::FPolyStart> &spots, TArray<FNodeBuilder::FPolyStart> &anchors)
 {
 	if (map->HasBehavior)
@@ -3380,11 +3356,13 @@ void P_FreeLevelData ()
 	FPolyObj::ClearAllSubsectorLinks(); // can't be done as part of the polyobj deletion process.
 	SN_StopAllSequences ();
 	DThinker::DestroyAllThinkers ();
+	AActor::FreeTIDChains ();
 	level.total_monsters = level.total_items = level.total_secrets =
 		level.killed_monsters = level.found_items = level.found_secrets =
 		wminfo.maxfrags = 0;
 		
 	FBehavior::StaticUnloadModules ();
+	P_ClearTagLists ();
 	if (vertexes != NULL)
 	{
 		delete[] vertexes;
@@ -3409,6 +3387,7 @@ void P_FreeLevelData ()
 		sectors = NULL;
 	}
 	numsectors = 0;
+	DirtyPlaneSectors.Clear();
 	if (gamenodes != NULL && gamenodes != nodes)
 	{
 		delete[] gamenodes;
@@ -3990,6 +3969,8 @@ void P_SetupLevel (const char *lumpname, int position)
 
 		// Spawn 3d floors - must be done before spawning things so it can't be done in P_SpawnSpecials
 		P_Spawn3DFloors();
+		// Hexen format 3D floor lines may have been given a new line ID.
+		P_InitTagLists();
 
 		times[14].Clock();
 		P_SpawnThings(position);
@@ -69,6 +69,7 @@
 #include "c_console.h"
 
 #include "r_data/r_interpolate.h"
+#include "p_tags.h"
 
 static FRandom pr_playerinspecialsector ("PlayerInSpecialSector");
 void P_SetupPortals();
@@ -193,26 +194,19 @@ bool CheckIfExitIsGood (AActor *self, level_info_t *info)
 //
 
 // Find the next sector with a specified tag.
-// Rewritten by Lee Killough to use chained hashing to improve speed
+// The lookup is done by the tag index in p_tags.cpp, which also knows
+// about the additional tags UDMF maps can assign with 'moreids'.
 
 int P_FindSectorFromTag (int tag, int start)
 {
-	start = start >= 0 ? sectors[start].nexttag :
-		sectors[(unsigned) tag % (unsigned) numsectors].firsttag;
-	while (start >= 0 && sectors[start].tag != tag)
-		start = sectors[start].nexttag;
-	return start;
+	return SectorTags.FindNext(tag, start);
 }
 
 // killough 4/16/98: Same thing, only for linedefs
 
 int P_FindLineFromID (int id, int start)
 {
-	start = start >= 0 ? lines[start].nextid :
-		lines[(unsigned) id % (unsigned) numlines].firstid;
-	while (start >= 0 && lines[start].id != id)
-		start = lines[start].nextid;
-	return start;
+	return LineIDs.FindNext(id, start);
 }
 
 
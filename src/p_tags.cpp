@@ -0,0 +1,249 @@
+/*
+** p_tags.cpp
+** Tag and line ID lookup for sectors and lines
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <stdlib.h>
+
+#include "doomtype.h"
+#include "p_tags.h"
+#include "r_defs.h"
+#include "r_state.h"
+
+FTagIndex SectorTags;
+FTagIndex LineIDs;
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FTagIndex::FTagIndex()
+{
+	LastPos = 0;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FTagIndex::Reset()
+{
+	Items.Clear();
+	ExtraTags.Clear();
+	TagStart.Clear();
+	LastPos = 0;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FTagIndex::AddExtraTag(int target, int tag)
+{
+	FTagItem item = { tag, target };
+	ExtraTags.Push(item);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FTagIndex::BeginBuild()
+{
+	Items.Clear();
+	TagStart.Clear();
+	LastPos = 0;
+}
+
+void FTagIndex::Add(int tag, int target)
+{
+	FTagItem item = { tag, target };
+	Items.Push(item);
+}
+
+//==========================================================================
+//
+// Sorts the entries, drops duplicates (a 'moreids' entry repeating the
+// primary tag) and records where each tag's run begins.
+//
+//==========================================================================
+
+int FTagIndex::SortItems(const void *a, const void *b)
+{
+	const FTagItem *ia = (const FTagItem *)a;
+	const FTagItem *ib = (const FTagItem *)b;
+
+	if (ia->Tag != ib->Tag) return ia->Tag < ib->Tag ? -1 : 1;
+	if (ia->Target != ib->Target) return ia->Target < ib->Target ? -1 : 1;
+	return 0;
+}
+
+void FTagIndex::EndBuild()
+{
+	unsigned i, j;
+
+	for (i = 0; i < ExtraTags.Size(); ++i)
+	{
+		Items.Push(ExtraTags[i]);
+	}
+	if (Items.Size() == 0)
+	{
+		return;
+	}
+	qsort(&Items[0], Items.Size(), sizeof(FTagItem), SortItems);
+
+	for (i = j = 1; i < Items.Size(); ++i)
+	{
+		if (Items[i].Tag != Items[j-1].Tag || Items[i].Target != Items[j-1].Target)
+		{
+			Items[j++] = Items[i];
+		}
+	}
+	Items.Resize(j);
+	Items.ShrinkToFit();
+
+	for (i = 0; i < Items.Size(); ++i)
+	{
+		if (i == 0 || Items[i].Tag != Items[i-1].Tag)
+		{
+			TagStart[Items[i].Tag] = i;
+		}
+	}
+}
+
+//==========================================================================
+//
+// Position of the first entry that is not less than (tag, target)
+//
+//==========================================================================
+
+unsigned FTagIndex::LowerBound(int tag, int target) const
+{
+	unsigned lo = 0, hi = Items.Size();
+
+	while (lo < hi)
+	{
+		unsigned mid = (lo + hi) / 2;
+		const FTagItem &item = Items[mid];
+
+		if (item.Tag < tag || (item.Tag == tag && item.Target < target))
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//==========================================================================
+//
+// Searches nearly always step through one tag's run from its start, so
+// the position of the last result is remembered and the next call only
+// has to look at the entry after it. Anything else falls back to a
+// binary search.
+//
+//==========================================================================
+
+int FTagIndex::FindNext(int tag, int start)
+{
+	unsigned pos;
+
+	if (start < 0)
+	{
+		unsigned *first = TagStart.CheckKey(tag);
+		if (first == NULL)
+		{
+			return -1;
+		}
+		pos = *first;
+	}
+	else if (LastPos < Items.Size() && Items[LastPos].Tag == tag && Items[LastPos].Target == start)
+	{
+		pos = LastPos + 1;
+	}
+	else
+	{
+		pos = LowerBound(tag, start + 1);
+	}
+
+	if (pos < Items.Size() && Items[pos].Tag == tag)
+	{
+		LastPos = pos;
+		return Items[pos].Target;
+	}
+	return -1;
+}
+
+//==========================================================================
+//
+// P_InitTagLists
+//
+// Builds the indices from the current sector tags and line IDs. This
+// must be called again whenever one of them is changed.
+//
+//==========================================================================
+
+void P_InitTagLists()
+{
+	int i;
+
+	SectorTags.BeginBuild();
+	for (i = 0; i < numsectors; ++i)
+	{
+		SectorTags.Add(sectors[i].tag, i);
+	}
+	SectorTags.EndBuild();
+
+	LineIDs.BeginBuild();
+	for (i = 0; i < numlines; ++i)
+	{
+		LineIDs.Add(lines[i].id, i);
+	}
+	LineIDs.EndBuild();
+}
+
+void P_ClearTagLists()
+{
+	SectorTags.Reset();
+	LineIDs.Reset();
+}
@@ -0,0 +1,96 @@
+/*
+** p_tags.h
+** Tag and line ID lookup for sectors and lines
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Every sector and line is entered under its primary tag (sector_t::tag
+** and line_t::id) plus any additional ones a UDMF map gave it with
+** 'moreids'. The entries are kept sorted by tag and then by object index,
+** so all objects sharing a tag form one contiguous run that can be walked
+** in the same ascending order the old hash chains used.
+**
+** The index is not updated by itself. Anything that changes a sector's
+** tag or a line's id after P_InitTagLists has run must call it again,
+** or the lookups will keep returning the objects under their old tags.
+**
+*/
+
+#ifndef __P_TAGS_H
+#define __P_TAGS_H
+
+#include "tarray.h"
+
+class FTagIndex
+{
+public:
+	FTagIndex();
+
+	// Forgets everything, including the additional tags. Used when a
+	// level is unloaded.
+	void Reset();
+
+	// Additional tags survive rebuilds until the next Reset.
+	void AddExtraTag(int target, int tag);
+
+	void BeginBuild();
+	void Add(int tag, int target);
+	void EndBuild();
+
+	// Returns the first object with the tag whose index is greater than
+	// start, or -1 if there is none. Pass start = -1 to begin a search.
+	int FindNext(int tag, int start);
+
+	unsigned NumEntries() const { return Items.Size(); }
+	unsigned NumTags() const { return TagStart.CountUsed(); }
+	unsigned NumExtraTags() const { return ExtraTags.Size(); }
+
+private:
+	struct FTagItem
+	{
+		int Tag;
+		int Target;
+	};
+
+	static int SortItems(const void *a, const void *b);
+	unsigned LowerBound(int tag, int target) const;
+
+	TArray<FTagItem> Items;
+	TArray<FTagItem> ExtraTags;
+	TMap<int, unsigned> TagStart;
+	unsigned LastPos;
+};
+
+extern FTagIndex SectorTags;
+extern FTagIndex LineIDs;
+
+void P_InitTagLists();
+void P_ClearTagLists();
+
+#endif
@@ -46,6 +46,7 @@
 #include "r_state.h"
 #include "r_data/colormaps.h"
 #include "w_wad.h"
+#include "p_tags.h"
 
 //===========================================================================
 //
@@ -393,6 +394,10 @@ class UDMFParser : public UDMFParserBase
 	TArray<vertex_t> ParsedVertices;
 	TArray<vertexdata_t> ParsedVertexDatas;
 
+	// Additional tags from 'moreids', stored as (parse index, tag) pairs
+	TArray<int> LineMoreIds;
+	TArray<int> SectorMoreIds;
+
 	FDynamicColormap	*fogMap, *normMap;
 	FMissingTextureTracker &missingTex;
 
@@ -764,6 +769,38 @@ public:
 		}
 	}
 
+	//===========================================================================
+	//
+	// Parses the space separated list of additional IDs in 'moreids'
+	//
+	//===========================================================================
+
+	void ParseMoreIds(TArray<int> &list, int index, const char *key)
+	{
+		const char *str = CheckString(key);
+		char *end;
+
+		for (;;)
+		{
+			long id = strtol(str, &end, 0);
+			if (end == str)
+			{
+				break;
+			}
+			list.Push(index);
+			list.Push(int(id));
+			str = end;
+		}
+		while (*end == ' ' || *end == '\t')
+		{
+			end++;
+		}
+		if (*end != 0)
+		{
+			sc.ScriptMessage("Integer list expected for key '%s'", key);
+		}
+	}
+
 	//===========================================================================
 	//
 	// Parse a linedef block
@@ -815,6 +852,11 @@ public:
 				ld->id = CheckInt(key);
 				continue;
 
+			case NAME_Moreids:
+				CHECK_N(Zd | Zdt)
+				ParseMoreIds(LineMoreIds, index, key);
+				continue;
+
 			case NAME_Sidefront:
 				ld->sidedef[0] = (side_t*)(intptr_t)(1 + CheckInt(key));
 				continue;
@@ -1318,6 +1360,11 @@ public:
 				sec->tag = (short)CheckInt(key);
 				continue;
 
+			case NAME_Moreids:
+				CHECK_N(Zd | Zdt)
+				ParseMoreIds(SectorMoreIds, index, key);
+				continue;
+
 			default:
 				break;
 			}
@@ -1878,6 +1925,25 @@ public:
 
 		// Create the real linedefs and decompress the sidedefs
 		ProcessLineDefs();
+
+		// Hand the additional tags to the tag index
+		for (unsigned i = 0; i < SectorMoreIds.Size(); i += 2)
+		{
+			SectorTags.AddExtraTag(SectorMoreIds[i], (short)SectorMoreIds[i+1]);
+		}
+		// Zero-length lines have been removed, so the indices need to be
+		// translated through linemap, which is sorted just like the list.
+		for (unsigned i = 0, line = 0; i < LineMoreIds.Size(); i += 2)
+		{
+			while (line < linemap.Size() && linemap[line] < LineMoreIds[i])
+			{
+				line++;
+			}
+			if (line < linemap.Size() && linemap[line] == LineMoreIds[i])
+			{
+				LineIDs.AddExtraTag(line, LineMoreIds[i+1]);
+			}
+		}
 	}
 };
 
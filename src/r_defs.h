@@ -355,6 +355,7 @@ struct subsector_t;
 struct sector_t;
 struct side_t;
 extern bool gl_plane_reflection_i;
+extern TArray<sector_t *> DirtyPlaneSectors;
 struct FPortal;
 
 // Ceiling/floor flags
@@ -659,6 +660,17 @@ struct sector_t
 	{
 		planes[pos].TexZ += val;
 		SetAllVerticesDirty();
+		SetPlanesDirty();
+	}
+
+	// Queues the sector for the renderer to pick up its new plane heights.
+	void SetPlanesDirty()
+	{
+		if (!planesdirty)
+		{
+			planesdirty = true;
+			DirtyPlaneSectors.Push(this);
+		}
 	}
 
 	static inline short ClampLight(int level)
@@ -707,8 +719,6 @@ struct sector_t
 	short		lightlevel;
 	short		seqType;		// this sector's sound sequence
 
-	int			nexttag,firsttag;	// killough 1/30/98: improves searches for tags.
-
 	int			sky;
 	FNameNoInit	SeqName;		// Sound sequence name. Setting seqType non-negative will override this.
 
@@ -796,6 +806,7 @@ struct sector_t
 	int				vboindex[4];	// VBO indices of the 4 planes this sector uses during rendering
 	fixed_t			vboheight[2];	// Last calculated height for the 2 planes of this actual sector
 	int				vbocount[2];	// Total count of vertices belonging to this sector's planes
+	bool			planesdirty;	// sector is in DirtyPlaneSectors
 
 	float GetReflect(int pos) { return gl_plane_reflection_i? reflect[pos] : 0; }
 	bool VBOHeightcheck(int pos) const { return vboheight[pos] == GetPlaneTexZ(pos); }
@@ -981,7 +992,6 @@ struct line_t
 	fixed_t		Alpha;		// <--- translucency (0=invisibile, FRACUNIT=opaque)
 	int			id;			// <--- same as tag or set with Line_SetIdentification
 	int			args[5];	// <--- hexen-style arguments (expanded to ZDoom's full width)
-	int			firstid, nextid;
 	side_t		*sidedef[2];
 	//DWORD		sidenum[2];	// sidenum[1] will be NO_SIDE if one sided
 	fixed_t		bbox[4];	// bounding box, for the extent of the LineDef.
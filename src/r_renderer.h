@@ -30,6 +30,10 @@ struct FRenderer
 	// precache one texture
 	virtual void PrecacheTexture(FTexture *tex, int cache) = 0;
 
+	// True if caching a texture with PrecacheTexture only builds its pixel data,
+	// so that different textures can be precached on worker threads at once.
+	virtual bool CanPrecacheThreaded() const { return false; }
+
 	// render 3D view
 	virtual void RenderView(player_t *player) = 0;
 
@@ -10,6 +10,7 @@ struct FSoftwareRenderer : public FRenderer
 
 	// precache one texture
 	virtual void PrecacheTexture(FTexture *tex, int cache);
+	virtual bool CanPrecacheThreaded() const { return true; }
 
 	// render 3D view
 	virtual void RenderView(player_t *player);
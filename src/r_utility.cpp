@@ -94,6 +94,11 @@ CUSTOM_CVAR(Float, r_quakeintensity, 1.0f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 	if (self < 0.f) self = 0.f;
 	else if (self > 1.f) self = 1.f;
 }
+// Time in ms that may be spent on rendering camera textures per frame. 0 means no limit.
+CUSTOM_CVAR(Float, r_camerabudget, 4.f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0.f) self = 0.f;
+}
 
 DCanvas			*RenderTarget;		// [RH] canvas to render to
 
@@ -145,6 +150,10 @@ int 			validcount = 1; 	// increment every time a check is made
 int				FieldOfView = 2048;		// Fineangles in the SCREENWIDTH wide window
 
 FCanvasTextureInfo *FCanvasTextureInfo::List;
+int FCanvasTextureInfo::UpdateCount;
+
+static int CamerasPending, CamerasRendered;
+static cycle_t CameraTime;
 
 
 // CODE --------------------------------------------------------------------
@@ -1084,6 +1093,7 @@ void FCanvasTextureInfo::Add (AActor *viewpoint, FTextureID picnum, int fov)
 	probe->Texture = texture;
 	probe->PicNum = picnum;
 	probe->FOV = fov;
+	probe->LastUpdate = 0;
 	probe->Next = List;
 	texture->bFirstUpdate = true;
 	List = probe;
@@ -1093,31 +1103,81 @@ void FCanvasTextureInfo::Add (AActor *viewpoint, FTextureID picnum, int fov)
 //
 // FCanvasTextureInfo :: UpdateAll
 //
-// Updates all canvas textures that were visible in the last frame.
+// Updates the canvas textures that were visible in the last frame.
+// If r_camerabudget is set, rendering stops once the budget is used
+// up and the remaining cameras have to wait for a later frame. The
+// cameras that have waited longest go first so that all of them get
+// their turn. Cameras that have never been rendered and the first one
+// in line are always updated.
 //
 //==========================================================================
 
+static int STACK_ARGS CompareCameraAge (const void *a, const void *b)
+{
+	const FCanvasTextureInfo *p1 = *(const FCanvasTextureInfo **)a;
+	const FCanvasTextureInfo *p2 = *(const FCanvasTextureInfo **)b;
+
+	if (p1->Texture->bFirstUpdate != p2->Texture->bFirstUpdate)
+	{
+		return p1->Texture->bFirstUpdate ? -1 : 1;
+	}
+	return p1->LastUpdate - p2->LastUpdate;
+}
+
 void FCanvasTextureInfo::UpdateAll ()
 {
+	static TArray<FCanvasTextureInfo *> pending;
 	FCanvasTextureInfo *probe;
+	unsigned i;
 
 	// curse Doom's overuse of global variables in the renderer.
 	// These get clobbered by rendering to a camera texture but they need to be preserved so the final rendering can be done with the correct palette.
 	unsigned char *savecolormap = fixedcolormap;
 	FSpecialColormap *savecm = realfixedcolormap;
 
+	UpdateCount++;
+	pending.Clear();
 	for (probe = List; probe != NULL; probe = probe->Next)
 	{
 		if (probe->Viewpoint != NULL && probe->Texture->bNeedsUpdate)
 		{
-			Renderer->RenderTextureView(probe->Texture, probe->Viewpoint, probe->FOV);
+			pending.Push(probe);
 		}
 	}
+	if (pending.Size() > 1)
+	{
+		qsort(&pending[0], pending.Size(), sizeof(pending[0]), CompareCameraAge);
+	}
+
+	CamerasPending = pending.Size();
+	CamerasRendered = 0;
+	CameraTime.Reset();
+	for (i = 0; i < pending.Size(); i++)
+	{
+		probe = pending[i];
+		if (i > 0 && r_camerabudget > 0 && !probe->Texture->bFirstUpdate &&
+			CameraTime.TimeMS() >= r_camerabudget)
+		{
+			continue;
+		}
+		CameraTime.Clock();
+		Renderer->RenderTextureView(probe->Texture, probe->Viewpoint, probe->FOV);
+		CameraTime.Unclock();
+		probe->LastUpdate = UpdateCount;
+		CamerasRendered++;
+	}
 
 	fixedcolormap = savecolormap;
 	realfixedcolormap = savecm;
 }
 
+ADD_STAT(cameras)
+{
+	FString out;
+	out.Format("%d of %d cameras rendered, %04.2f ms", CamerasRendered, CamerasPending, CameraTime.TimeMS());
+	return out;
+}
+
 //==========================================================================
 //
 // FCanvasTextureInfo :: EmptyList
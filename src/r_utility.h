@@ -89,6 +89,7 @@ struct FCanvasTextureInfo
 	FCanvasTexture *Texture;
 	FTextureID PicNum;
 	int FOV;
+	int LastUpdate;		// value of UpdateCount when this was last rendered
 
 	static void Add (AActor *viewpoint, FTextureID picnum, int fov);
 	static void UpdateAll ();
@@ -98,6 +99,7 @@ struct FCanvasTextureInfo
 
 private:
 	static FCanvasTextureInfo *List;
+	static int UpdateCount;
 };
 
 
@@ -253,6 +253,7 @@ static const char *SICommandStrings[] =
 	"$attenuation",
 	NULL
 };
+static FKeywordTable SICommands(SICommandStrings);
 
 static TArray<FRandomSoundList> S_rnd;
 static FMusicVolume *MusicVolumes;
@@ -991,7 +992,7 @@ static void S_AddSNDINFO (int lump)
 
 		if (sc.String[0] == '$')
 		{ // Got a command
-			switch (sc.MatchString (SICommandStrings))
+			switch (sc.MatchString (SICommands))
 			{
 			case SI_Ambient: {
 				// $ambient <num> <logical name> [point [atten] | surround | [world]]
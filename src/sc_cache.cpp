@@ -0,0 +1,344 @@
+/*
+** sc_cache.cpp
+** Caches the tokens FScanner finds in a script
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <string.h>
+#include <stdio.h>
+#include <zlib.h>
+
+#include "doomtype.h"
+#include "sc_man.h"
+#include "sc_cache.h"
+#include "c_cvars.h"
+#include "cmdlib.h"
+#include "m_misc.h"
+#include "m_swap.h"
+#include "md5.h"
+
+EXTERN_CVAR(Int, script_scanner_version)
+
+enum { SCANCACHE_VERSION = 2 };
+
+struct FScanCacheHeader
+{
+	char Magic[4];		// "SCTC"
+	DWORD Version;
+	DWORD ScriptLength;
+	DWORD NumEntries;
+	DWORD StringSize;
+	DWORD CompressedSize;
+	BYTE MD5[16];
+};
+
+//==========================================================================
+//
+// FScanCache Constructor
+//
+// The cache file is named after where the script comes from, so a
+// changed script replaces its old cache instead of adding another one.
+// Its contents are only used if the MD5 of the script text matches.
+//
+//==========================================================================
+
+FScanCache::FScanCache(const char *location, const char *text, unsigned len)
+{
+	MD5Context md5;
+	DWORD version = LittleLong(DWORD(script_scanner_version));
+
+	md5.Update((const BYTE *)location, (unsigned)strlen(location));
+	md5.Final(NameKey);
+
+	md5.Init();
+	md5.Update((const BYTE *)&version, sizeof(version));
+	md5.Update((const BYTE *)text, len);
+	md5.Final(TextKey);
+
+	ScriptLength = len;
+	Dirty = false;
+	if (!Load())
+	{
+		Entries.Clear();
+		Strings.Clear();
+		Index.Clear();
+	}
+}
+
+//==========================================================================
+//
+// FScanCache Destructor
+//
+//==========================================================================
+
+FScanCache::~FScanCache()
+{
+	if (Dirty)
+	{
+		Save();
+	}
+}
+
+//==========================================================================
+//
+// The scan result depends on the position and on the scanner's modes.
+//
+//==========================================================================
+
+DWORD FScanCache::MakeKey(FScanner *sc, const char *pos, bool tokens) const
+{
+	return (DWORD(pos - sc->ScriptBuffer.GetChars()) << 3) |
+		(tokens ? 1 : 0) | (sc->CMode ? 2 : 0) | (sc->Escape ? 4 : 0);
+}
+
+//==========================================================================
+//
+// Sets the scanner up as if it had just scanned from its current
+// position. Returns false if that scan has not been seen before.
+//
+//==========================================================================
+
+bool FScanCache::Replay(FScanner *sc, bool tokens)
+{
+	unsigned *entry = Index.CheckKey(MakeKey(sc, sc->ScriptPtr, tokens));
+
+	if (entry == NULL)
+	{
+		return false;
+	}
+
+	const FEntry &e = Entries[*entry];
+	const char *str = &Strings[e.StringOfs];
+
+	sc->ScriptPtr = sc->ScriptBuffer.GetChars() + e.End;
+	sc->RawToken = sc->ScriptPtr - e.RawLen;
+	sc->RawTokenLen = e.RawLen;
+	sc->Line += e.Lines;
+	sc->Crossed = e.Lines > 0;
+	if (tokens)
+	{
+		sc->TokenType = e.TokenType;
+	}
+	// The parsers are allowed to modify String, so it is always copied.
+	sc->StringLen = e.StringLen;
+	if (e.StringLen < FScanner::MAX_STRING_SIZE)
+	{
+		memcpy(sc->StringBuffer, str, e.StringLen + 1);
+		sc->String = sc->StringBuffer;
+	}
+	else
+	{
+		sc->BigStringBuffer = FString(str, e.StringLen);
+		sc->String = sc->BigStringBuffer.LockBuffer();
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Adds the result of a successful scan
+//
+//==========================================================================
+
+void FScanCache::Record(FScanner *sc, bool tokens, const char *start, int startline)
+{
+	FEntry e;
+
+	e.Key = MakeKey(sc, start, tokens);
+	e.End = DWORD(sc->ScriptPtr - sc->ScriptBuffer.GetChars());
+	e.Lines = DWORD(sc->Line - startline);
+	e.TokenType = tokens ? DWORD(sc->TokenType) : 0;
+	e.StringOfs = Strings.Size();
+	e.StringLen = DWORD(sc->StringLen);
+	e.RawLen = DWORD(sc->RawTokenLen);
+
+	Strings.Resize(e.StringOfs + e.StringLen + 1);
+	memcpy(&Strings[e.StringOfs], sc->String, e.StringLen);
+	Strings[e.StringOfs + e.StringLen] = 0;
+
+	Index[e.Key] = Entries.Push(e);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString FScanCache::GetFileName(bool create) const
+{
+	FString path = M_GetCachePath(create);
+	path << "/scripts";
+	if (create) CreatePath(path);
+
+	path << '/';
+	for (int i = 0; i < 16; i++)
+	{
+		path.AppendFormat("%02x", NameKey[i]);
+	}
+	path << ".stc";
+	return path;
+}
+
+//==========================================================================
+//
+// The entries are stored as little endian DWORDs, followed by the
+// null-terminated strings. Everything is checked against the script so
+// a damaged file cannot make the scanner read outside of it.
+//
+//==========================================================================
+
+bool FScanCache::Load()
+{
+	FScanCacheHeader header;
+	FString path = GetFileName(false);
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) return false;
+
+	bool ok = false;
+	if (fread(&header, sizeof(header), 1, f) == 1 &&
+		!memcmp(header.Magic, "SCTC", 4) &&
+		LittleLong(header.Version) == SCANCACHE_VERSION &&
+		LittleLong(header.ScriptLength) == ScriptLength &&
+		!memcmp(header.MD5, TextKey, 16) &&
+		LittleLong(header.NumEntries) <= ScriptLength * 8 &&
+		LittleLong(header.StringSize) < 0x10000000)
+	{
+		DWORD numentries = LittleLong(header.NumEntries);
+		DWORD stringsize = LittleLong(header.StringSize);
+		DWORD complen = LittleLong(header.CompressedSize);
+		uLongf datalen = numentries * sizeof(FEntry) + stringsize;
+		BYTE *compressed = new BYTE[complen];
+		BYTE *data = new BYTE[datalen];
+
+		if (fread(compressed, 1, complen, f) == complen &&
+			uncompress(data, &datalen, compressed, complen) == Z_OK &&
+			datalen == numentries * sizeof(FEntry) + stringsize)
+		{
+			const DWORD *in = (const DWORD *)data;
+
+			Entries.Resize(numentries);
+			Strings.Resize(stringsize);
+			if (stringsize > 0)
+			{
+				memcpy(&Strings[0], data + numentries * sizeof(FEntry), stringsize);
+			}
+			ok = true;
+			for (unsigned i = 0; i < numentries && ok; i++, in += 7)
+			{
+				FEntry &e = Entries[i];
+
+				e.Key = LittleLong(in[0]);
+				e.End = LittleLong(in[1]);
+				e.Lines = LittleLong(in[2]);
+				e.TokenType = LittleLong(in[3]);
+				e.StringOfs = LittleLong(in[4]);
+				e.StringLen = LittleLong(in[5]);
+				e.RawLen = LittleLong(in[6]);
+
+				if ((e.Key >> 3) >= ScriptLength || e.End > ScriptLength || e.RawLen > e.End ||
+					e.StringOfs >= stringsize || e.StringLen >= stringsize - e.StringOfs ||
+					Strings[e.StringOfs + e.StringLen] != 0)
+				{
+					ok = false;
+				}
+				else
+				{
+					Index[e.Key] = i;
+				}
+			}
+		}
+		delete[] data;
+		delete[] compressed;
+	}
+	fclose(f);
+	return ok;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FScanCache::Save()
+{
+	unsigned entrysize = Entries.Size() * sizeof(FEntry);
+	unsigned count = entrysize + Strings.Size();
+	BYTE *data = new BYTE[count];
+	DWORD *out = (DWORD *)data;
+
+	for (unsigned i = 0; i < Entries.Size(); i++, out += 7)
+	{
+		const FEntry &e = Entries[i];
+
+		out[0] = LittleLong(e.Key);
+		out[1] = LittleLong(e.End);
+		out[2] = LittleLong(e.Lines);
+		out[3] = LittleLong(e.TokenType);
+		out[4] = LittleLong(e.StringOfs);
+		out[5] = LittleLong(e.StringLen);
+		out[6] = LittleLong(e.RawLen);
+	}
+	if (Strings.Size() > 0)
+	{
+		memcpy(data + entrysize, &Strings[0], Strings.Size());
+	}
+
+	uLongf outlen = compressBound(count);
+	BYTE *compressed = new BYTE[outlen];
+
+	if (compress(compressed, &outlen, data, count) == Z_OK)
+	{
+		FScanCacheHeader header;
+
+		memcpy(header.Magic, "SCTC", 4);
+		header.Version = LittleLong(DWORD(SCANCACHE_VERSION));
+		header.ScriptLength = LittleLong(ScriptLength);
+		header.NumEntries = LittleLong(Entries.Size());
+		header.StringSize = LittleLong(Strings.Size());
+		header.CompressedSize = LittleLong(DWORD(outlen));
+		memcpy(header.MD5, TextKey, 16);
+
+		FString path = GetFileName(true);
+		FILE *f = fopen(path, "wb");
+		if (f != NULL)
+		{
+			bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(compressed, outlen, 1, f) == 1;
+			fclose(f);
+			if (!ok) remove(path);
+		}
+	}
+	delete[] compressed;
+	delete[] data;
+	Dirty = false;
+}
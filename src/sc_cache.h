@@ -0,0 +1,85 @@
+/*
+** sc_cache.h
+** Caches the tokens FScanner finds in a script
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** A token cache remembers the result of every scan the scanner does in
+** one script, keyed by where the scan started and how the scanner was
+** set up, and stores it on disk with the MD5 of the script text. The
+** next time the same text is opened the results are replayed instead of
+** scanned again. Scans that are not in the cache are done normally and
+** added to it.
+**
+*/
+
+#ifndef __SC_CACHE_H
+#define __SC_CACHE_H
+
+#include "tarray.h"
+#include "zstring.h"
+
+class FScanner;
+
+class FScanCache
+{
+public:
+	FScanCache(const char *location, const char *text, unsigned len);
+	~FScanCache();
+
+	bool Replay(FScanner *sc, bool tokens);
+	void Record(FScanner *sc, bool tokens, const char *start, int startline);
+
+private:
+	struct FEntry
+	{
+		DWORD Key;			// Start offset << 3 | mode bits
+		DWORD End;			// Offset after the scan
+		DWORD Lines;		// Number of lines crossed
+		DWORD TokenType;
+		DWORD StringOfs;	// Into the string pool
+		DWORD StringLen;
+		DWORD RawLen;		// The raw token ends at End
+	};
+
+	DWORD MakeKey(FScanner *sc, const char *pos, bool tokens) const;
+	FString GetFileName(bool create) const;
+	bool Load();
+	void Save();
+
+	BYTE NameKey[16];
+	BYTE TextKey[16];
+	DWORD ScriptLength;
+	TArray<FEntry> Entries;
+	TArray<char> Strings;		// Each string is null-terminated
+	TMap<DWORD, unsigned> Index;
+	bool Dirty;
+};
+
+#endif
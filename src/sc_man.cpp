@@ -23,6 +23,9 @@
 #include "templates.h"
 #include "doomstat.h"
 #include "v_text.h"
+#include "sc_cache.h"
+#include "c_dispatch.h"
+#include "stats.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -43,6 +46,9 @@ CVAR(Int, script_scanner_version, 0, CVAR_NOSET);
 // 1 - scanner with signed character type (before ZDoom r4179 and GZDoom r1537)
 // 2 - scanner with unsigned character type (starting from revisions above)
 
+// Off by default until it has been shown to beat scanning the text directly.
+CVAR(Bool, sc_cachetokens, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
 // CODE --------------------------------------------------------------------
@@ -56,6 +62,7 @@ CVAR(Int, script_scanner_version, 0, CVAR_NOSET);
 FScanner::FScanner()
 {
 	ScriptOpen = false;
+	Cache = NULL;
 }
 
 //==========================================================================
@@ -66,7 +73,7 @@ FScanner::FScanner()
 
 FScanner::~FScanner()
 {
-	// Humm... Nothing to do in here.
+	delete Cache;
 }
 
 //==========================================================================
@@ -78,6 +85,7 @@ FScanner::~FScanner()
 FScanner::FScanner(const FScanner &other)
 {
 	ScriptOpen = false;
+	Cache = NULL;
 	*this = other;
 }
 
@@ -90,6 +98,7 @@ FScanner::FScanner(const FScanner &other)
 FScanner::FScanner(int lumpnum)
 {
 	ScriptOpen = false;
+	Cache = NULL;
 	OpenLumpNum(lumpnum);
 }
 
@@ -111,7 +120,9 @@ FScanner &FScanner::operator=(const FScanner &other)
 		return *this;
 	}
 
-	// Copy protected members
+	// Copy protected members. The token cache stays with the original.
+	delete Cache;
+	Cache = NULL;
 	ScriptOpen = true;
 	ScriptName = other.ScriptName;
 	ScriptBuffer = other.ScriptBuffer;
@@ -148,6 +159,8 @@ FScanner &FScanner::operator=(const FScanner &other)
 	Line = other.Line;
 	End = other.End;
 	Crossed = other.Crossed;
+	RawToken = other.RawToken;
+	RawTokenLen = other.RawTokenLen;
 
 	return *this;
 }
@@ -269,6 +282,8 @@ void FScanner::PrepareScript ()
 	Escape = true;
 	StringBuffer[0] = '\0';
 	BigStringBuffer = "";
+	RawToken = ScriptPtr;
+	RawTokenLen = 0;
 }
 
 //==========================================================================
@@ -279,11 +294,38 @@ void FScanner::PrepareScript ()
 
 void FScanner::Close ()
 {
+	delete Cache;
+	Cache = NULL;
 	ScriptOpen = false;
 	ScriptBuffer = "";
 	BigStringBuffer = "";
 	StringBuffer[0] = '\0';
 	String = StringBuffer;
+	RawToken = NULL;
+	RawTokenLen = 0;
+}
+
+//==========================================================================
+//
+// FScanner :: UseTokenCache
+//
+// Makes the scanner use a token cache for the script it has just opened.
+// Only meant for big scripts that get parsed on every launch; the cache
+// cannot pay for its file access on small ones.
+//
+//==========================================================================
+
+void FScanner::UseTokenCache()
+{
+	CheckOpen();
+	delete Cache;
+	Cache = NULL;
+	if (sc_cachetokens && LumpNum >= 0)
+	{
+		FString location = Wads.GetWadFullName(Wads.GetLumpFile(LumpNum));
+		location << ':' << Wads.GetLumpFullName(LumpNum);
+		Cache = new FScanCache(location, ScriptBuffer.GetChars(), ScriptBuffer.Len());
+	}
 }
 
 //==========================================================================
@@ -416,10 +458,20 @@ bool FScanner::ScanString (bool tokens)
 	LastGotPtr = ScriptPtr;
 	LastGotLine = Line;
 
+	if (Cache != NULL && Cache->Replay(this, tokens))
+	{
+		LastGotToken = tokens;
+		return true;
+	}
+
 	return_val = 1 == script_scanner_version
 		? ScanWithSignedCType(tokens)
 		: ScanWithUnsignedCType(tokens);
 
+	if (Cache != NULL && return_val)
+	{
+		Cache->Record(this, tokens, LastGotPtr, LastGotLine);
+	}
 	LastGotToken = tokens;
 	return return_val;
 }
@@ -836,6 +888,37 @@ int FScanner::MustMatchString (const char * const *strings, size_t stride)
 	return i;
 }
 
+//==========================================================================
+//
+// FScanner :: MatchString
+//
+// Same as above with a hashed keyword list.
+//
+//==========================================================================
+
+int FScanner::MatchString (const FKeywordTable &keywords)
+{
+	return keywords.Find (String);
+}
+
+//==========================================================================
+//
+// FScanner :: MustMatchString
+//
+//==========================================================================
+
+int FScanner::MustMatchString (const FKeywordTable &keywords)
+{
+	int i;
+
+	i = keywords.Find (String);
+	if (i == -1)
+	{
+		ScriptError (NULL);
+	}
+	return i;
+}
+
 //==========================================================================
 //
 // FScanner :: Compare
@@ -1066,4 +1149,223 @@ void STACK_ARGS FScriptPosition::Message (int severity, const char *message, ...
 		color, type, FileName.GetChars(), ScriptLine, color, composed.GetChars());
 }
 
+//==========================================================================
+//
+// FKeywordTable
+//
+//==========================================================================
+
+FKeywordTable::FKeywordTable(const char * const *strings, size_t stride)
+{
+	assert(stride % sizeof(const char*) == 0);
+	Strings = strings;
+	Stride = stride / sizeof(const char*);
+	Slots = NULL;
+	Mask = 0;
+}
 
+FKeywordTable::~FKeywordTable()
+{
+	if (Slots != NULL)
+	{
+		delete[] Slots;
+	}
+}
+
+void FKeywordTable::Build() const
+{
+	unsigned int count = 0;
+	unsigned int size = 16;
+
+	while (GetKeyword(count) != NULL)
+	{
+		count++;
+	}
+	while (size < count * 2)
+	{
+		size <<= 1;
+	}
+	Slots = new FSlot[size];
+	memset(Slots, 0, sizeof(FSlot) * size);
+	Mask = size - 1;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const char *keyword = GetKeyword(i);
+		unsigned int hash = MakeKey(keyword);
+		unsigned int slot;
+
+		for (slot = hash & Mask; Slots[slot].Index != 0; slot = (slot + 1) & Mask)
+		{
+			if (Slots[slot].Hash == hash && stricmp(keyword, GetKeyword(Slots[slot].Index - 1)) == 0)
+			{
+				break;
+			}
+		}
+		// For duplicates the first one wins, like in a linear search.
+		if (Slots[slot].Index == 0)
+		{
+			Slots[slot].Hash = hash;
+			Slots[slot].Index = i + 1;
+		}
+	}
+}
+
+int FKeywordTable::Find(const char *text) const
+{
+	if (Slots == NULL)
+	{
+		Build();
+	}
+
+	unsigned int hash = MakeKey(text);
+
+	for (unsigned int slot = hash & Mask; Slots[slot].Index != 0; slot = (slot + 1) & Mask)
+	{
+		if (Slots[slot].Hash == hash && stricmp(text, GetKeyword(Slots[slot].Index - 1)) == 0)
+		{
+			return Slots[slot].Index - 1;
+		}
+	}
+	return -1;
+}
+
+//==========================================================================
+//
+// CCMD bench_scanner
+//
+// Scans all text lumps of the loaded files the way the parsers would and
+// reports the time it took. Extra lump names can be passed as arguments.
+// The most common words are then matched against each token by a plain
+// and a hashed keyword search.
+//
+//==========================================================================
+
+typedef TMap<FString, int>::Pair WordCount;
+
+static int SortWordCounts(const void *a, const void *b)
+{
+	const WordCount *wa = *(const WordCount *const *)a;
+	const WordCount *wb = *(const WordCount *const *)b;
+
+	// most common first
+	if (wa->Value != wb->Value) return wa->Value > wb->Value ? -1 : 1;
+	return 0;
+}
+
+CCMD (bench_scanner)
+{
+	static const char *const textlumps[] =
+	{
+		"MAPINFO", "ZMAPINFO", "DECORATE", "SNDINFO", "SNDSEQ", "TEXTURES",
+		"GLDEFS", "ANIMDEFS", "DECALDEF", "LANGUAGE", "TERRAIN", "LOCKDEFS",
+		"SBARINFO", "MENUDEF", "FONTDEFS", "KEYCONF", "TEAMINFO", "GAMEINFO",
+		NULL
+	};
+	TArray<int> lumps;
+	cycle_t strings, tokens;
+	int numstrings = 0, numtokens = 0;
+	size_t bytes = 0;
+
+	for (int i = 0; i < Wads.GetNumLumps(); i++)
+	{
+		bool match = false;
+		for (int j = 0; textlumps[j] != NULL && !match; j++)
+		{
+			match = Wads.CheckLumpName(i, textlumps[j]);
+		}
+		for (int j = 1; j < argv.argc() && !match; j++)
+		{
+			match = Wads.CheckLumpName(i, argv[j]);
+		}
+		if (match)
+		{
+			lumps.Push(i);
+			bytes += Wads.LumpLength(i);
+		}
+	}
+
+	// Count words while scanning so that the keyword test has realistic input.
+	TMap<FString, int> counts;
+	strings.Reset();
+	tokens.Reset();
+	for (unsigned i = 0; i < lumps.Size(); i++)
+	{
+		FScanner sc(lumps[i]);
+
+		strings.Clock();
+		while (sc.GetString())
+		{
+			numstrings++;
+		}
+		strings.Unclock();
+
+		sc.Close();
+		sc.OpenLumpNum(lumps[i]);
+		sc.SetCMode(true);
+		tokens.Clock();
+		while (sc.GetToken())
+		{
+			numtokens++;
+			if (sc.TokenType == TK_Identifier)
+			{
+				FString word(sc.String);
+				word.ToLower();
+				counts[word]++;
+			}
+		}
+		tokens.Unclock();
+	}
+	Printf ("%u lumps, %u bytes\n", lumps.Size(), (unsigned)bytes);
+	Printf ("GetString: %d strings in %.2f ms\n", numstrings, strings.TimeMS());
+	Printf ("GetToken:  %d tokens in %.2f ms\n", numtokens, tokens.TimeMS());
+
+	// Use the 200 most common identifiers as keywords and match all
+	// identifiers against them.
+	TArray<WordCount *> words;
+	TMap<FString, int>::Iterator it(counts);
+	WordCount *pair;
+	while (it.NextPair(pair))
+	{
+		words.Push(pair);
+	}
+	if (words.Size() == 0)
+	{
+		return;
+	}
+	qsort(&words[0], words.Size(), sizeof(WordCount *), SortWordCounts);
+
+	TArray<const char *> keywords;
+	for (unsigned i = 0; i < words.Size() && i < 200; i++)
+	{
+		keywords.Push(words[i]->Key.GetChars());
+	}
+	keywords.Push(NULL);
+
+	FKeywordTable table(&keywords[0]);
+	cycle_t linear, hashed;
+	int found1 = 0, found2 = 0;
+
+	linear.Reset();
+	hashed.Reset();
+	for (unsigned i = 0; i < lumps.Size(); i++)
+	{
+		FScanner sc(lumps[i]);
+		sc.SetCMode(true);
+		while (sc.GetToken())
+		{
+			if (sc.TokenType != TK_Identifier)
+			{
+				continue;
+			}
+			linear.Clock();
+			if (sc.MatchString(&keywords[0]) >= 0) found1++;
+			linear.Unclock();
+			hashed.Clock();
+			if (sc.MatchString(table) >= 0) found2++;
+			hashed.Unclock();
+		}
+	}
+	Printf ("%u keywords: linear %.2f ms (%d found), hashed %.2f ms (%d found)\n",
+		keywords.Size() - 1, linear.TimeMS(), found1, hashed.TimeMS(), found2);
+}
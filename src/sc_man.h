@@ -1,6 +1,9 @@
 #ifndef __SC_MAN_H__
 #define __SC_MAN_H__
 
+class FScanCache;
+class FKeywordTable;
+
 class FScanner
 {
 public:
@@ -23,6 +26,7 @@ public:
 	void OpenMem(const char *name, const char *buffer, int size);
 	void OpenLumpNum(int lump);
 	void Close();
+	void UseTokenCache();
 
 	void SetCMode(bool cmode);
 	void SetEscape(bool esc);
@@ -56,6 +60,8 @@ public:
 	bool Compare(const char *text);
 	int MatchString(const char * const *strings, size_t stride = sizeof(char*));
 	int MustMatchString(const char * const *strings, size_t stride = sizeof(char*));
+	int MatchString(const FKeywordTable &keywords);
+	int MustMatchString(const FKeywordTable &keywords);
 	int GetMessageLine();
 
 	void ScriptError(const char *message, ...);
@@ -76,6 +82,12 @@ public:
 	int LumpNum;
 	FString ScriptName;
 
+	// The last token as it appears in the script buffer, with any quotes
+	// and escape sequences. It is not null-terminated and stays valid
+	// until the script is closed.
+	const char *RawToken;
+	int RawTokenLen;
+
 protected:
 	void PrepareScript();
 	void CheckOpen();
@@ -97,12 +109,55 @@ protected:
 	int LastGotLine;
 	bool CMode;
 	bool Escape;
+	FScanCache *Cache;
+
+	friend class FScanCache;
 
 private:
 	bool ScanWithSignedCType(const bool tokens);
 	bool ScanWithUnsignedCType(const bool tokens);
 };
 
+//==========================================================================
+//
+// A keyword list for FScanner::MatchString that is hashed on first use,
+// so matching a token costs one hash lookup instead of a string compare
+// per keyword. The list has the same layout MatchString takes and must
+// outlive the table, so define tables next to static keyword arrays.
+//
+//==========================================================================
+
+class FKeywordTable
+{
+public:
+	FKeywordTable(const char * const *strings, size_t stride = sizeof(char*));
+	~FKeywordTable();
+
+	// Returns the index of the first keyword matching text, or -1.
+	int Find(const char *text) const;
+
+private:
+	struct FSlot
+	{
+		unsigned int Hash;
+		int Index;		// Keyword index + 1; 0 for an empty slot
+	};
+
+	const char *GetKeyword(int index) const
+	{
+		return Strings[index * Stride];
+	}
+	void Build() const;
+
+	const char * const *Strings;
+	size_t Stride;
+	mutable FSlot *Slots;
+	mutable unsigned int Mask;
+
+	FKeywordTable(const FKeywordTable &);
+	FKeywordTable &operator=(const FKeywordTable &);
+};
+
 enum
 {
 	TK_SequenceStart = 256,
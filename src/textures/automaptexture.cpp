@@ -122,6 +122,7 @@ void FAutomapTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -145,6 +146,7 @@ void FAutomapTexture::MakeTexture ()
 			Pixels[x*Height+y] = indata[x+320*y];
 		}
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
 //==========================================================================
@@ -155,10 +157,11 @@ void FAutomapTexture::MakeTexture ()
 
 const BYTE *FAutomapTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -170,10 +173,11 @@ const BYTE *FAutomapTexture::GetPixels ()
 
 const BYTE *FAutomapTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		column %= Width;
@@ -60,7 +60,7 @@ public:
 
 protected:
 	const BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 };
 
 
@@ -142,9 +142,9 @@ const BYTE *FBuildTexture::GetColumn (unsigned int column, const Span **spans_ou
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
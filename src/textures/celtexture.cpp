@@ -175,7 +175,7 @@ public:
 
 private:
 	BYTE*  m_pixels;
-	Span** m_spans;
+	SpanTable *m_spans;
 
 	void MakeTexture();
 
@@ -233,16 +233,18 @@ void FCELTexture::Unload()
 		delete[] m_pixels;
 		m_pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
 
 const BYTE* FCELTexture::GetColumn(unsigned int column, const Span** spans)
 {
-	if (m_pixels == NULL)
+	if (m_pixels == NULL && !UnpackPixels(m_pixels))
 	{
 		MakeTexture();
 	}
+	Touch();
 
 	if (DWORD(column) >= DWORD(Width))
 	{
@@ -260,10 +262,10 @@ const BYTE* FCELTexture::GetColumn(unsigned int column, const Span** spans)
 	{
 		if (NULL == m_spans)
 		{
-			m_spans = CreateSpans(m_pixels);
+			m_spans = CreateSpans();
 		}
 
-		*spans = m_spans[column];
+		*spans = m_spans->GetColumn(column, m_pixels + column * Height);
 	}
 
 	return m_pixels + column * Height;
@@ -273,10 +275,11 @@ const BYTE* FCELTexture::GetColumn(unsigned int column, const Span** spans)
 
 const BYTE* FCELTexture::GetPixels()
 {
-	if (NULL == m_pixels)
+	if (m_pixels == NULL && !UnpackPixels(m_pixels))
 	{
 		MakeTexture();
 	}
+	Touch();
 
 	return m_pixels;
 }
@@ -306,6 +309,7 @@ void FCELTexture::MakeTexture()
 	FlipNonSquareBlockRemap(m_pixels, oldPixels, Width, Height, Width, palette);
 
 	delete[] oldPixels;
+	CachePixels(m_pixels, Width*Height);
 }
 
 //===========================================================================
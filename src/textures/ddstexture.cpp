@@ -164,7 +164,7 @@ public:
 protected:
 
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 
 	DWORD Format;
 
@@ -401,6 +401,7 @@ void FDDSTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -435,10 +436,11 @@ FTextureFormat FDDSTexture::GetFormat()
 
 const BYTE *FDDSTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -454,9 +456,9 @@ const BYTE *FDDSTexture::GetColumn (unsigned int column, const Span **spans_out)
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -469,10 +471,11 @@ const BYTE *FDDSTexture::GetColumn (unsigned int column, const Span **spans_out)
 
 const BYTE *FDDSTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -506,6 +509,7 @@ void FDDSTexture::MakeTexture ()
 	{
 		DecompressDXT5 (lump, Format == ID_DXT4);
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
 //==========================================================================
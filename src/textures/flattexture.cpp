@@ -138,6 +138,7 @@ void FFlatTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -148,10 +149,11 @@ void FFlatTexture::Unload ()
 
 const BYTE *FFlatTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -178,10 +180,11 @@ const BYTE *FFlatTexture::GetColumn (unsigned int column, const Span **spans_out
 
 const BYTE *FFlatTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -201,5 +204,6 @@ void FFlatTexture::MakeTexture ()
 		memset (Pixels + numread, 0xBB, Width*Height - numread);
 	}
 	FlipSquareBlockRemap (Pixels, Width, Height, GPalette.Remap);
+	CachePixels(Pixels, Width*Height);
 }
 
@@ -71,7 +71,7 @@ public:
 protected:
 
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 
 	void MakeTexture ();
 };
@@ -142,6 +142,7 @@ void FIMGZTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -152,10 +153,11 @@ void FIMGZTexture::Unload ()
 
 const BYTE *FIMGZTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -171,9 +173,9 @@ const BYTE *FIMGZTexture::GetColumn (unsigned int column, const Span **spans_out
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -186,10 +188,11 @@ const BYTE *FIMGZTexture::GetColumn (unsigned int column, const Span **spans_out
 
 const BYTE *FIMGZTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -278,5 +281,6 @@ void FIMGZTexture::MakeTexture ()
 			dest_p -= dest_rew;
 		}
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
@@ -300,6 +300,7 @@ void FJPEGTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -321,10 +322,11 @@ FTextureFormat FJPEGTexture::GetFormat()
 
 const BYTE *FJPEGTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -351,10 +353,11 @@ const BYTE *FJPEGTexture::GetColumn (unsigned int column, const Span **spans_out
 
 const BYTE *FJPEGTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -455,6 +458,7 @@ void FJPEGTexture::MakeTexture ()
 	{
 		delete[] buff;
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
 
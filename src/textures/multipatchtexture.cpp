@@ -166,10 +166,11 @@ public:
 	int GetSourceLump() { return DefinitionLump; }
 	FTexture *GetRedirect(bool wantwarped);
 	FTexture *GetRawTexture();
+	bool GetBuildSources(TArray<FTexture *> &sources);
 
 protected:
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 	int DefinitionLump;
 
 	struct TexPart
@@ -362,6 +363,7 @@ void FMultiPatchTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -376,10 +378,11 @@ const BYTE *FMultiPatchTexture::GetPixels ()
 	{
 		return Parts->Texture->GetPixels ();
 	}
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -395,10 +398,11 @@ const BYTE *FMultiPatchTexture::GetColumn (unsigned int column, const Span **spa
 	{
 		return Parts->Texture->GetColumn (column, spans_out);
 	}
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -414,9 +418,9 @@ const BYTE *FMultiPatchTexture::GetColumn (unsigned int column, const Span **spa
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -542,6 +546,7 @@ void FMultiPatchTexture::MakeTexture ()
 		}
 		delete [] buffer;
 	}
+	CachePixels(Pixels, numpix);
 }
 
 //===========================================================================
@@ -798,6 +803,21 @@ FTexture *FMultiPatchTexture::GetRawTexture()
 	return NumParts == 1 ? Parts->Texture : this;
 }
 
+//===========================================================================
+//
+// FMultiPatchTexture :: GetBuildSources
+//
+//===========================================================================
+
+bool FMultiPatchTexture::GetBuildSources(TArray<FTexture *> &sources)
+{
+	for (int i = 0; i < NumParts; ++i)
+	{
+		sources.Push(Parts[i].Texture);
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // FMultiPatchTexture :: TexPart :: TexPart
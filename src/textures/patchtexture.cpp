@@ -67,7 +67,7 @@ public:
 
 protected:
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 	bool hackflag;
 
 
@@ -184,6 +184,7 @@ void FPatchTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -194,10 +195,11 @@ void FPatchTexture::Unload ()
 
 const BYTE *FPatchTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -209,10 +211,11 @@ const BYTE *FPatchTexture::GetPixels ()
 
 const BYTE *FPatchTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -228,9 +231,9 @@ const BYTE *FPatchTexture::GetColumn (unsigned int column, const Span **spans_ou
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans(Pixels);
+			Spans = CreateSpans();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -298,6 +301,7 @@ void FPatchTexture::MakeTexture ()
 				out++, in++;
 			}
 		}
+		CachePixels(Pixels, Width*Height);
 		return;
 	}
 
@@ -351,6 +355,7 @@ void FPatchTexture::MakeTexture ()
 			column = (const column_t *)((const BYTE *)column + column->length + 4);
 		}
 	}
+	CachePixels(Pixels, numpix);
 }
 
 
@@ -191,6 +191,7 @@ void FPCXTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -212,10 +213,11 @@ FTextureFormat FPCXTexture::GetFormat()
 
 const BYTE *FPCXTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -242,10 +244,11 @@ const BYTE *FPCXTexture::GetColumn (unsigned int column, const Span **spans_out)
 
 const BYTE *FPCXTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -534,6 +537,7 @@ void FPCXTexture::MakeTexture()
 		}
 		delete [] buffer;
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
 //===========================================================================
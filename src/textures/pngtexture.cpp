@@ -65,7 +65,7 @@ protected:
 
 	FString SourceFile;
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 
 	BYTE BitDepth;
 	BYTE ColorType;
@@ -365,6 +365,7 @@ void FPNGTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -396,10 +397,11 @@ FTextureFormat FPNGTexture::GetFormat()
 
 const BYTE *FPNGTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -415,9 +417,9 @@ const BYTE *FPNGTexture::GetColumn (unsigned int column, const Span **spans_out)
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -430,10 +432,11 @@ const BYTE *FPNGTexture::GetColumn (unsigned int column, const Span **spans_out)
 
 const BYTE *FPNGTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -575,6 +578,7 @@ void FPNGTexture::MakeTexture ()
 		}
 	}
 	delete lump;
+	CachePixels(Pixels, Width*Height);
 }
 
 //===========================================================================
@@ -206,6 +206,7 @@ void FRawPageTexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -216,10 +217,11 @@ void FRawPageTexture::Unload ()
 
 const BYTE *FRawPageTexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		column %= 320;
@@ -239,10 +241,11 @@ const BYTE *FRawPageTexture::GetColumn (unsigned int column, const Span **spans_
 
 const BYTE *FRawPageTexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -273,5 +276,6 @@ void FRawPageTexture::MakeTexture ()
 		}
 		dest_p -= 200*320-1;
 	}
+	CachePixels(Pixels, Width*Height);
 }
 
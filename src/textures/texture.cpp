@@ -45,6 +45,8 @@
 #include "v_video.h"
 #include "m_fixed.h"
 #include "textures/textures.h"
+#include "threadpool.h"
+#include <zlib.h>
 
 typedef bool (*CheckFunc)(FileReader & file);
 typedef FTexture * (*CreateFunc)(FileReader & file, int lumpnum);
@@ -152,7 +154,8 @@ FTexture::FTexture (const char *name, int lumpnum)
   WidthBits(0), HeightBits(0), xScale(FRACUNIT), yScale(FRACUNIT), SourceLump(lumpnum),
   UseType(TEX_Any), bNoDecals(false), bNoRemap0(false), bWorldPanning(false),
   bMasked(true), bAlphaTexture(false), bHasCanvas(false), bWarped(0), bComplex(false), bMultiPatch(false), bKeepAround(false),
-  Rotations(0xFFFF), SkyOffset(0), Width(0), Height(0), WidthMask(0), Native(NULL)
+  Rotations(0xFFFF), SkyOffset(0), Width(0), Height(0), WidthMask(0), Native(NULL),
+  CachedPixels(NULL), PackedPixels(NULL), CachedSize(0), PackedSize(0), PackedSourceSize(0), LastUseFrame(0)
 {
 	id.SetInvalid();
 	if (name != NULL)
@@ -175,6 +178,7 @@ FTexture::~FTexture ()
 	FTexture *link = Wads.GetLinkedTexture(SourceLump);
 	if (link == this) Wads.SetLinkedTexture(SourceLump, NULL);
 	KillNative();
+	FreePackedPixels();
 }
 
 bool FTexture::CheckModified ()
@@ -222,102 +226,162 @@ void FTexture::HackHack (int newheight)
 {
 }
 
-FTexture::Span **FTexture::CreateSpans (const BYTE *pixels) const
+FTexture::SpanTable *FTexture::CreateSpans () const
 {
-	Span **spans, *span;
+	return new SpanTable(Width, Height, bMasked);
+}
+
+void FTexture::FreeSpans (SpanTable *spans) const
+{
+	delete spans;
+}
+
+//==========================================================================
+//
+// FTexture :: SpanTable
+//
+//==========================================================================
 
-	if (!bMasked)
-	{ // Texture does not have holes, so it can use a simpler span structure
-		spans = (Span **)M_Malloc (sizeof(Span*)*Width + sizeof(Span)*2);
-		span = (Span *)&spans[Width];
-		for (int x = 0; x < Width; ++x)
+FTexture::SpanTable::SpanTable(int width, int height, bool masked)
+{
+	Width = width;
+	Height = height;
+	Blocks = NULL;
+	Solid[0].TopOffset = 0;
+	Solid[0].Length = height;
+	Solid[1].TopOffset = 0;
+	Solid[1].Length = 0;
+
+	if (masked)
+	{ // Texture might have holes, so every column needs its own spans.
+		Columns = new const Span *[width];
+		memset(Columns, 0, sizeof(Span *) * width);
+		for (int i = 0; i < NUM_BUCKETS; ++i)
 		{
-			spans[x] = span;
+			Buckets[i] = -1;
 		}
-		span[0].Length = Height;
-		span[0].TopOffset = 0;
-		span[1].Length = 0;
-		span[1].TopOffset = 0;
 	}
 	else
-	{ // Texture might have holes, so build a complete span structure
-		int numcols = Width;
-		int numrows = Height;
-		int numspans = numcols;	// One span to terminate each column
-		const BYTE *data_p;
-		bool newspan;
-		int x, y;
-
-		data_p = pixels;
-
-		// Count the number of spans in this texture
-		for (x = numcols; x > 0; --x)
+	{ // Texture does not have holes, so all columns can use the same span.
+		Columns = NULL;
+	}
+}
+
+FTexture::SpanTable::~SpanTable()
+{
+	while (Blocks != NULL)
+	{
+		Block *next = Blocks->Next;
+		M_Free(Blocks);
+		Blocks = next;
+	}
+	if (Columns != NULL)
+	{
+		delete[] Columns;
+	}
+}
+
+//==========================================================================
+//
+// SpanTable :: AllocSpans
+//
+// Span lists are never freed individually, so they are packed into
+// blocks which grow along with the texture's needs.
+//
+//==========================================================================
+
+FTexture::Span *FTexture::SpanTable::AllocSpans(int count)
+{
+	if (Blocks == NULL || Blocks->Used + count > Blocks->Size)
+	{
+		int size = MAX(count, Blocks == NULL ? 32 : Blocks->Size * 2);
+		size = MIN(size, MAX(count, Width * 4));
+		Block *block = (Block *)M_Malloc(sizeof(Block) + sizeof(Span) * (size - 1));
+		block->Next = Blocks;
+		block->Size = size;
+		block->Used = 0;
+		Blocks = block;
+	}
+	Span *spans = &Blocks->Spans[Blocks->Used];
+	Blocks->Used += count;
+	return spans;
+}
+
+//==========================================================================
+//
+// SpanTable :: BuildColumn
+//
+//==========================================================================
+
+const FTexture::Span *FTexture::SpanTable::BuildColumn(unsigned int column, const BYTE *columndata)
+{
+	TArray<Span> spans;
+	unsigned int hash = 0;
+	bool newspan = true;
+	int y;
+
+	for (y = 0; y < Height; ++y)
+	{
+		if (columndata[y] == 0)
 		{
 			newspan = true;
-			for (y = numrows; y > 0; --y)
-			{
-				if (*data_p++ == 0)
-				{
-					if (!newspan)
-					{
-						newspan = true;
-					}
-				}
-				else if (newspan)
-				{
-					newspan = false;
-					numspans++;
-				}
-			}
 		}
+		else if (newspan)
+		{
+			Span span = { (WORD)y, 1 };
+			spans.Push(span);
+			newspan = false;
+		}
+		else
+		{
+			spans.Last().Length++;
+		}
+	}
+	Span terminator = { 0, 0 };
+	spans.Push(terminator);
 
-		// Allocate space for the spans
-		spans = (Span **)M_Malloc (sizeof(Span*)*numcols + sizeof(Span)*numspans);
+	for (unsigned i = 0; i < spans.Size(); ++i)
+	{
+		hash = hash * 31 + ((spans[i].TopOffset << 16) | spans[i].Length);
+	}
 
-		// Fill in the spans
-		for (x = 0, span = (Span *)&spans[numcols], data_p = pixels; x < numcols; ++x)
+	// Columns with the same runs can share their spans.
+	int count = spans.Size();
+	for (int i = Buckets[hash % NUM_BUCKETS]; i >= 0; i = Entries[i].Next)
+	{
+		if (Entries[i].Hash == hash && Entries[i].Count == count &&
+			!memcmp(Entries[i].Spans, &spans[0], sizeof(Span) * count))
 		{
-			newspan = true;
-			spans[x] = span;
-			for (y = 0; y < numrows; ++y)
-			{
-				if (*data_p++ == 0)
-				{
-					if (!newspan)
-					{
-						newspan = true;
-						span++;
-					}
-				}
-				else
-				{
-					if (newspan)
-					{
-						newspan = false;
-						span->TopOffset = y;
-						span->Length = 1;
-					}
-					else
-					{
-						span->Length++;
-					}
-				}
-			}
-			if (!newspan)
-			{
-				span++;
-			}
-			span->TopOffset = 0;
-			span->Length = 0;
-			span++;
+			return Columns[column] = Entries[i].Spans;
 		}
 	}
-	return spans;
+
+	Span *stored = AllocSpans(count);
+	memcpy(stored, &spans[0], sizeof(Span) * count);
+
+	Entry entry = { stored, hash, count, Buckets[hash % NUM_BUCKETS] };
+	Buckets[hash % NUM_BUCKETS] = Entries.Push(entry);
+	return Columns[column] = stored;
 }
 
-void FTexture::FreeSpans (Span **spans) const
+//==========================================================================
+//
+// SpanTable :: GetMemoryUsage
+//
+//==========================================================================
+
+size_t FTexture::SpanTable::GetMemoryUsage() const
 {
-	M_Free (spans);
+	size_t size = sizeof(*this);
+	if (Columns != NULL)
+	{
+		size += sizeof(Span *) * Width + Entries.Size() * sizeof(Entry);
+	}
+	for (Block *block = Blocks; block != NULL; block = block->Next)
+	{
+		size += sizeof(Block) + sizeof(Span) * (block->Size - 1);
+	}
+	return size;
 }
 
 void FTexture::CopyToBlock (BYTE *dest, int dwidth, int dheight, int xpos, int ypos, int rotate, const BYTE *translation)
@@ -562,6 +626,11 @@ FTexture *FTexture::GetRawTexture()
 	return this;
 }
 
+bool FTexture::GetBuildSources(TArray<FTexture *> &sources)
+{
+	return true;
+}
+
 void FTexture::SetScaledSize(int fitwidth, int fitheight)
 {
 	xScale = FLOAT2FIXED(float(Width) / fitwidth);
@@ -571,6 +640,150 @@ void FTexture::SetScaledSize(int fitwidth, int fitheight)
 	if (MulScale16(yScale, fitheight) != Height) yScale++;
 }
 
+//==========================================================================
+//
+// Pixel cache
+//
+// Textures that can recreate their pixels at any time report them here
+// so that the texture manager can throw out the least recently used ones
+// once the total grows past texcache_budget. The pixels of an evicted
+// texture can be kept around zlib compressed, which is a lot cheaper to
+// restore than decoding the source image again.
+//
+// Calls to CachePixels may come from the precaching worker threads.
+//
+//==========================================================================
+
+static FThreadLock PixelCacheLock;
+
+DWORD FTexture::CacheFrame;
+size_t FTexture::ResidentBytes, FTexture::PackedBytes;
+int FTexture::ResidentCount, FTexture::PackedCount;
+int FTexture::NumEvicted, FTexture::NumRestored;
+bool FTexture::KeepPacked;
+
+void FTexture::CachePixels(const BYTE *pixels, int size)
+{
+	FThreadLockGuard lock(PixelCacheLock);
+
+	if (CachedPixels != NULL)
+	{
+		ResidentBytes -= CachedSize;
+	}
+	else
+	{
+		ResidentCount++;
+	}
+	CachedPixels = pixels;
+	CachedSize = size;
+	ResidentBytes += size;
+	LastUseFrame = CacheFrame;
+}
+
+//==========================================================================
+//
+// Called by Unload. Unless the texture manager is evicting this texture,
+// the compressed copy goes away as well.
+//
+//==========================================================================
+
+void FTexture::UncachePixels()
+{
+	FThreadLockGuard lock(PixelCacheLock);
+
+	if (CachedPixels != NULL)
+	{
+		ResidentBytes -= CachedSize;
+		ResidentCount--;
+		CachedPixels = NULL;
+	}
+	if (!KeepPacked)
+	{
+		FreePackedPixels();
+	}
+}
+
+//==========================================================================
+//
+// Restores the pixels from the compressed copy, if there is one.
+// The buffer is allocated with new[], just like MakeTexture does.
+//
+//==========================================================================
+
+bool FTexture::UnpackPixels(BYTE *&pixels)
+{
+	if (PackedPixels == NULL)
+	{
+		return false;
+	}
+
+	BYTE *buffer = new BYTE[PackedSourceSize];
+	uLongf len = PackedSourceSize;
+
+	if (uncompress(buffer, &len, PackedPixels, PackedSize) != Z_OK || len != (uLongf)PackedSourceSize)
+	{
+		delete[] buffer;
+		FreePackedPixels();
+		return false;
+	}
+	FThreadLockGuard lock(PixelCacheLock);
+	pixels = buffer;
+	CachePixels(buffer, PackedSourceSize);
+	NumRestored++;
+	return true;
+}
+
+//==========================================================================
+//
+// Makes a compressed copy of the resident pixels. It is kept after the
+// pixels are restored so that evicting the texture again is free.
+//
+//==========================================================================
+
+bool FTexture::PackPixels()
+{
+	if (PackedPixels != NULL)
+	{
+		return true;
+	}
+	if (CachedPixels == NULL)
+	{
+		return false;
+	}
+
+	uLongf len = compressBound(CachedSize);
+	BYTE *buffer = new BYTE[len];
+
+	if (compress2(buffer, &len, CachedPixels, CachedSize, 1) != Z_OK)
+	{
+		delete[] buffer;
+		return false;
+	}
+
+	FThreadLockGuard lock(PixelCacheLock);
+	PackedPixels = new BYTE[len];
+	memcpy(PackedPixels, buffer, len);
+	delete[] buffer;
+	PackedSize = (int)len;
+	PackedSourceSize = CachedSize;
+	PackedBytes += PackedSize;
+	PackedCount++;
+	return true;
+}
+
+void FTexture::FreePackedPixels()
+{
+	FThreadLockGuard lock(PixelCacheLock);
+
+	if (PackedPixels != NULL)
+	{
+		delete[] PackedPixels;
+		PackedPixels = NULL;
+		PackedBytes -= PackedSize;
+		PackedCount--;
+	}
+}
+
 
 FDummyTexture::FDummyTexture ()
 {
@@ -55,6 +55,7 @@
 #include "textures/textures.h"
 #include "gstrings.h"
 #include "stats.h"
+#include "threadpool.h"
 
 FTextureManager TexMan;
 
@@ -64,6 +65,11 @@ CUSTOM_CVAR(Bool, vid_nopalsubstitutions, false, CVAR_ARCHIVE)
 	R_InitSkyMap ();
 }
 
+// Maximum amount of pixel data in megabytes that textures may keep in memory.
+// 0 means no limit.
+CVAR(Int, texcache_budget, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+CVAR(Bool, texcache_compress, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
 CCMD(cleartexturecache)
 {
 	if (NULL == Renderer)
@@ -372,6 +378,110 @@ void FTextureManager::UnloadAll ()
 	}
 }
 
+//==========================================================================
+//
+// FTextureManager :: TrimPixelCache
+//
+// Called once per frame, before anything gets drawn. If the textures'
+// pixel data has outgrown texcache_budget, the least recently used ones
+// are compressed or thrown out until it is back below 7/8 of the budget.
+// Anything that was used in the last frame stays, because the renderers
+// may still hold pointers into its pixels.
+//
+//==========================================================================
+
+struct FCacheCandidate
+{
+	DWORD LastUse;
+	FTexture *Texture;
+};
+
+static int STACK_ARGS SortByLastUse (const void *a, const void *b)
+{
+	DWORD use1 = ((const FCacheCandidate *)a)->LastUse;
+	DWORD use2 = ((const FCacheCandidate *)b)->LastUse;
+	return use1 < use2 ? -1 : use1 > use2 ? 1 : 0;
+}
+
+void FTextureManager::TrimPixelCache ()
+{
+	FTexture::CacheFrame++;
+
+	if (texcache_budget <= 0)
+	{
+		return;
+	}
+
+	size_t budget = size_t(texcache_budget) << 20;
+	if (FTexture::ResidentBytes + FTexture::PackedBytes <= budget)
+	{
+		return;
+	}
+	size_t target = budget - budget / 8;
+	TArray<FCacheCandidate> candidates;
+	unsigned int i;
+
+	for (i = 0; i < Textures.Size(); ++i)
+	{
+		FTexture *tex = Textures[i].Texture;
+		if (tex->CachedPixels != NULL || tex->PackedPixels != NULL)
+		{
+			FCacheCandidate cand = { tex->LastUseFrame, tex };
+			candidates.Push(cand);
+		}
+	}
+	if (candidates.Size() == 0)
+	{
+		return;
+	}
+	qsort(&candidates[0], candidates.Size(), sizeof(FCacheCandidate), SortByLastUse);
+
+	// First move the coldest textures out of the resident set.
+	FTexture::KeepPacked = texcache_compress;
+	for (i = 0; i < candidates.Size() && FTexture::ResidentBytes + FTexture::PackedBytes > target; ++i)
+	{
+		FTexture *tex = candidates[i].Texture;
+		if (candidates[i].LastUse + 1 >= FTexture::CacheFrame)
+		{
+			break;
+		}
+		if (tex->CachedPixels != NULL)
+		{
+			if (texcache_compress)
+			{
+				tex->PackPixels();
+			}
+			tex->Unload();
+			FTexture::NumEvicted++;
+		}
+	}
+	FTexture::KeepPacked = false;
+
+	// If that wasn't enough, drop compressed copies, oldest first.
+	for (i = 0; i < candidates.Size() && FTexture::ResidentBytes + FTexture::PackedBytes > target; ++i)
+	{
+		candidates[i].Texture->FreePackedPixels();
+	}
+}
+
+ADD_STAT(texcache)
+{
+	FString out;
+	out.Format("Resident: %d textures, %.1f MB  Packed: %d textures, %.1f MB  Budget: ",
+		FTexture::ResidentCount, FTexture::ResidentBytes / 1048576.,
+		FTexture::PackedCount, FTexture::PackedBytes / 1048576.);
+	if (texcache_budget > 0)
+	{
+		out.AppendFormat("%d MB", *texcache_budget);
+	}
+	else
+	{
+		out += "none";
+	}
+	out.AppendFormat("  Evicted: %d  Restored: %d", FTexture::NumEvicted, FTexture::NumRestored);
+	return out;
+}
+
 //==========================================================================
 //
 // FTextureManager :: AddTexture
@@ -1298,6 +1408,79 @@ private:
 	bool         m_dimmed;
 };
 
+struct PrecacheEntry
+{
+	FTexture *Texture;
+	int Flags;
+	int Depth;		// textures are only built after all their sources
+	bool Serial;	// must be built on the main thread
+	double Time;
+};
+
+struct PrecacheJob
+{
+	TArray<PrecacheEntry> Entries;
+	TArray<int> Batch;
+};
+
+//===========================================================================
+//
+// Adds a texture and, if requested, everything it is built from to
+// the precache list. Sources have to be complete before a texture using
+// them can be built on a worker thread, so they go into earlier batches.
+//
+//===========================================================================
+
+int AddPrecacheEntry(TArray<PrecacheEntry> &entries, TMap<FTexture *, int> &indices,
+	FTexture *tex, int flags, bool withsources, int recursion = 0)
+{
+	int *pindex = indices.CheckKey(tex);
+	if (pindex != NULL)
+	{
+		entries[*pindex].Flags |= flags;
+		return *pindex;
+	}
+
+	int index = entries.Reserve(1);
+	indices[tex] = index;
+	entries[index].Texture = tex;
+	entries[index].Flags = flags;
+	entries[index].Depth = 0;
+	entries[index].Serial = !withsources;
+	entries[index].Time = 0;
+
+	if (withsources)
+	{
+		TArray<FTexture *> sources;
+		int depth = 0;
+		bool serial = recursion >= 16 || !tex->GetBuildSources(sources);
+
+		for (unsigned i = 0; i < sources.Size(); i++)
+		{
+			if (sources[i] == NULL || sources[i] == tex) continue;
+			int source = AddPrecacheEntry(entries, indices, sources[i], 2, true, recursion + 1);
+			depth = MAX(depth, entries[source].Depth + 1);
+			serial |= entries[source].Serial;
+		}
+		entries[index].Depth = depth;
+		entries[index].Serial = serial;
+	}
+	return index;
+}
+
+void PrecacheEntryFunc(void *userdata, int index)
+{
+	PrecacheJob *job = (PrecacheJob *)userdata;
+	PrecacheEntry &entry = job->Entries[job->Batch[index]];
+	cycle_t clock;
+
+	clock.Reset();
+	clock.Clock();
+	Renderer->PrecacheTexture(entry.Texture, entry.Flags);
+	clock.Unclock();
+	entry.Time = clock.TimeMS();
+}
+
 } // unnamed namespace
 
 void FTextureManager::PrecacheLevel (void)
@@ -1326,15 +1509,90 @@ void FTextureManager::PrecacheLevel (void)
 		hitlist[level.info->PrecacheTextures[i].GetIndex()] |= 1;
 	}
 
+	// Free everything that is no longer needed before building the new set.
+	PrecacheJob job;
+	TMap<FTexture *, int> indices;
+	bool threaded = Renderer->CanPrecacheThreaded() && ThreadPool.GetNumThreads() > 1;
+	int maxdepth = 0;
+
+	for (int i = cnt - 1; i >= 0; i--)
+	{
+		if (hitlist[i] == 0)
+		{
+			Renderer->PrecacheTexture(ByIndex(i), 0);
+			precacheProgress.Update();
+		}
+	}
 	for (int i = cnt - 1; i >= 0; i--)
 	{
-		Renderer->PrecacheTexture(ByIndex(i), hitlist[i]);
-		precacheProgress.Update();
+		FTexture *tex = ByIndex(i);
+		if (hitlist[i] != 0 && tex != NULL)
+		{
+			int index = AddPrecacheEntry(job.Entries, indices, tex, hitlist[i], threaded);
+			maxdepth = MAX(maxdepth, job.Entries[index].Depth);
+		}
+	}
+
+	// Decode and compose everything that is safe to do so in parallel,
+	// one dependency level at a time.
+	if (threaded)
+	{
+		for (int depth = 0; depth <= maxdepth; depth++)
+		{
+			job.Batch.Clear();
+			for (unsigned i = 0; i < job.Entries.Size(); i++)
+			{
+				if (!job.Entries[i].Serial && job.Entries[i].Depth == depth)
+				{
+					job.Batch.Push(i);
+				}
+			}
+			ThreadPool.ParallelFor(job.Batch.Size(), PrecacheEntryFunc, &job);
+			precacheProgress.Update();
+		}
+	}
+
+	// Whatever is left must be done on the main thread.
+	job.Batch.Resize(1);
+	for (unsigned i = 0; i < job.Entries.Size(); i++)
+	{
+		if (job.Entries[i].Serial)
+		{
+			job.Batch[0] = i;
+			PrecacheEntryFunc(&job, 0);
+			precacheProgress.Update();
+		}
 	}
 
 	precacheProfiler.Unclock();
 	DPrintf(TEXTCOLOR_RED "Textures were precached in %.03f ms\n", precacheProfiler.TimeMS());
 
+	if (developer)
+	{
+		static const char *const formatnames[] = { "paletted", "grayscale", "truecolor", "compressed", "composite" };
+		double times[countof(formatnames)] = { 0 };
+		int counts[countof(formatnames)] = { 0 };
+
+		for (unsigned i = 0; i < job.Entries.Size(); i++)
+		{
+			FTexture *tex = job.Entries[i].Texture;
+			int format = tex->bMultiPatch ? 4 : MIN<int>(tex->GetFormat(), 3);
+			times[format] += job.Entries[i].Time;
+			counts[format]++;
+		}
+		for (unsigned i = 0; i < countof(formatnames); i++)
+		{
+			if (counts[i] > 0)
+			{
+				DPrintf("  %d %s textures: %.03f ms\n", counts[i], formatnames[i], times[i]);
+			}
+		}
+		if (threaded)
+		{
+			DPrintf("  using %d threads\n", ThreadPool.GetNumThreads());
+		}
+	}
+
 	delete[] hitlist;
 }
 
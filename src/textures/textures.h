@@ -224,6 +224,7 @@ public:
 		WORD TopOffset;
 		WORD Length;	// A length of 0 terminates this column
 	};
+	class SpanTable;
 
 	// Returns a single column of the texture
 	virtual const BYTE *GetColumn (unsigned int column, const Span **spans_out) = 0;
@@ -238,6 +239,10 @@ public:
 	virtual FTexture *GetRedirect(bool wantwarped);
 	virtual FTexture *GetRawTexture();		// for FMultiPatchTexture to override
 
+	// Adds the textures this one's pixels are built from. Returns false if
+	// building the pixels must not happen on a worker thread.
+	virtual bool GetBuildSources(TArray<FTexture *> &sources);
+
 	virtual void Unload () = 0;
 
 	// Returns the native pixel format for this image
@@ -299,15 +304,38 @@ public:
 
 	virtual void HackHack (int newheight);	// called by FMultipatchTexture to discover corrupt patches.
 
+	// Pixel cache statistics. Only textures that can rebuild their pixels
+	// at any time take part, see FTextureManager::TrimPixelCache.
+	static DWORD CacheFrame;
+	static size_t ResidentBytes, PackedBytes;
+	static int ResidentCount, PackedCount;
+	static int NumEvicted, NumRestored;
+
 protected:
 	WORD Width, Height, WidthMask;
 	static BYTE GrayMap[256];
 	FNativeTexture *Native;
 
+	// Pixel cache bookkeeping
+	const BYTE *CachedPixels;
+	BYTE *PackedPixels;
+	int CachedSize;
+	int PackedSize;
+	int PackedSourceSize;
+	DWORD LastUseFrame;
+	static bool KeepPacked;
+
+	void Touch() { LastUseFrame = CacheFrame; }
+	void CachePixels(const BYTE *pixels, int size);
+	void UncachePixels();
+	bool UnpackPixels(BYTE *&pixels);
+	bool PackPixels();
+	void FreePackedPixels();
+
 	FTexture (const char *name = NULL, int lumpnum = -1);
 
-	Span **CreateSpans (const BYTE *pixels) const;
-	void FreeSpans (Span **spans) const;
+	SpanTable *CreateSpans () const;
+	void FreeSpans (SpanTable *spans) const;
 	void CalcBitSize ();
 	void CopyInfo(FTexture *other)
 	{
@@ -326,6 +354,7 @@ public:
 	static void FlipNonSquareBlockRemap (BYTE *blockto, const BYTE *blockfrom, int x, int y, int srcpitch, const BYTE *remap);
 
 	friend class D3DTex;
+	friend class FTextureManager;
 
 public:
 
@@ -372,6 +401,55 @@ public:
 	bool ProcessData(unsigned char * buffer, int w, int h, bool ispatch);
 };
 
+// The span lists of a texture's columns. Spans for a column are only built
+// the first time the column is drawn, and columns with identical runs share
+// the same span list. Since only the pixel data decides what the spans look
+// like, a span table stays valid when its texture is unloaded.
+class FTexture::SpanTable
+{
+public:
+	SpanTable(int width, int height, bool masked);
+	~SpanTable();
+
+	// columndata points to the column's pixels.
+	const Span *GetColumn(unsigned int column, const BYTE *columndata)
+	{
+		if (Columns == NULL) return Solid;
+		const Span *spans = Columns[column];
+		return spans != NULL ? spans : BuildColumn(column, columndata);
+	}
+
+	size_t GetMemoryUsage() const;
+
+private:
+	enum { NUM_BUCKETS = 64 };
+
+	struct Block
+	{
+		Block *Next;
+		int Size, Used;
+		Span Spans[1];
+	};
+
+	struct Entry
+	{
+		const Span *Spans;
+		unsigned int Hash;
+		int Count;
+		int Next;
+	};
+
+	const Span *BuildColumn(unsigned int column, const BYTE *columndata);
+	Span *AllocSpans(int count);
+
+	Span Solid[2];
+	const Span **Columns;
+	int Width, Height;
+	Block *Blocks;
+	TArray<Entry> Entries;
+	int Buckets[NUM_BUCKETS];
+};
+
 // Texture manager
 class FTextureManager
 {
@@ -475,6 +553,7 @@ public:
 	int ReadTexture (FArchive &arc);
 
 	void UpdateAnimations (DWORD mstime);
+	void TrimPixelCache ();
 	int GuesstimateNumTextures ();
 
 	FSwitchDef *FindSwitch (FTextureID texture);
@@ -566,12 +645,13 @@ public:
 	int GetSourceLump() { return SourcePic->GetSourceLump(); }
 	void SetSpeed(float fac) { Speed = fac; }
 	FTexture *GetRedirect(bool wantwarped);
+	bool GetBuildSources(TArray<FTexture *> &sources);
 
 	DWORD GenTime;
 protected:
 	FTexture *SourcePic;
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 	float Speed;
 
 	virtual void MakeTexture (DWORD time);
@@ -602,6 +682,7 @@ public:
 	const BYTE *GetPixels ();
 	void Unload ();
 	bool CheckModified ();
+	bool GetBuildSources(TArray<FTexture *> &sources) { return false; }	// creates a DObject
 	void NeedUpdate() { bNeedsUpdate=true; }
 	void SetUpdated() { bNeedsUpdate = false; bDidUpdate = true; bFirstUpdate = false; }
 	DSimpleCanvas *GetCanvas() { return Canvas; }
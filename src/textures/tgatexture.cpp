@@ -92,7 +92,7 @@ public:
 
 protected:
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 
 	void ReadCompressed(FileReader &lump, BYTE * buffer, int bytesperpixel);
 
@@ -181,6 +181,7 @@ void FTGATexture::Unload ()
 		delete[] Pixels;
 		Pixels = NULL;
 	}
+	UncachePixels();
 }
 
 //==========================================================================
@@ -202,10 +203,11 @@ FTextureFormat FTGATexture::GetFormat()
 
 const BYTE *FTGATexture::GetColumn (unsigned int column, const Span **spans_out)
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	if ((unsigned)column >= (unsigned)Width)
 	{
 		if (WidthMask + 1 == Width)
@@ -221,9 +223,9 @@ const BYTE *FTGATexture::GetColumn (unsigned int column, const Span **spans_out)
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -236,10 +238,11 @@ const BYTE *FTGATexture::GetColumn (unsigned int column, const Span **spans_out)
 
 const BYTE *FTGATexture::GetPixels ()
 {
-	if (Pixels == NULL)
+	if (Pixels == NULL && !UnpackPixels(Pixels))
 	{
 		MakeTexture ();
 	}
+	Touch();
 	return Pixels;
 }
 
@@ -479,6 +482,7 @@ void FTGATexture::MakeTexture ()
 		break;
     }
 	delete [] buffer;
+	CachePixels(Pixels, Width*Height);
 }	
 
 //===========================================================================
@@ -112,9 +112,9 @@ const BYTE *FWarpTexture::GetColumn (unsigned int column, const Span **spans_out
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
@@ -233,6 +233,12 @@ FTexture *FWarpTexture::GetRedirect(bool wantwarped)
 	else return this;
 }
 
+bool FWarpTexture::GetBuildSources(TArray<FTexture *> &sources)
+{
+	sources.Push(SourcePic);
+	return true;
+}
+
 //==========================================================================
 //
 // FMultiPatchTexture :: CopyTrueColorPixels
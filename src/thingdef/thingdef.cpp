@@ -352,6 +352,7 @@ void LoadActors ()
 	while ((lump = Wads.FindLump ("DECORATE", &lastlump)) != -1)
 	{
 		FScanner sc(lump);
+		sc.UseTokenCache();
 		ParseDecorate (sc);
 	}
 	if (FScriptPosition::ErrorCounter > 0)
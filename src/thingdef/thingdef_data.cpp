@@ -533,6 +533,25 @@ AFuncDesc *FindFunction(const char * string)
 	return NULL;
 }
 
+//==========================================================================
+//
+// Find the name of an action function. This is a linear search and only
+// meant for diagnostics.
+//
+//==========================================================================
+
+const char *FindFunctionName(actionf_p func)
+{
+	for (unsigned i = 0; i < AFTable.Size(); i++)
+	{
+		if (AFTable[i].Function == func)
+		{
+			return AFTable[i].Name;
+		}
+	}
+	return NULL;
+}
+
 
 //==========================================================================
 //
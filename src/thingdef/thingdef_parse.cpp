@@ -1262,6 +1262,7 @@ void ParseDecorate (FScanner &sc)
 			}
 			FScanner newscanner;
 			newscanner.Open(sc.String);
+			newscanner.UseTokenCache();
 			ParseDecorate(newscanner);
 			break;
 		}
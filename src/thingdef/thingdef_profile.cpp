@@ -0,0 +1,402 @@
+/*
+** thingdef_profile.cpp
+**
+** Timing of action functions called from actor states
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** With decorate_profile on, every action function that a state calls is
+** timed and billed to the class of the state's owner, the state and the
+** action. Actions that run other states' actions (custom inventory and
+** A_CallSpecial chains) are only billed for their own time, so the
+** columns add up to the total.
+**
+** Running with -profileactions turns the profiler on at startup. At the
+** end of a -timedemo run a summary is printed, and written as CSV to the
+** file given after -profileactions, if any.
+**
+*/
+
+#include "actor.h"
+#include "info.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "r_state.h"
+#include "stats.h"
+#include "v_text.h"
+#include "thingdef/thingdef.h"
+
+bool ActionProfiling;
+
+CUSTOM_CVAR(Bool, decorate_profile, false, 0)
+{
+	ActionProfiling = self;
+}
+
+struct FActionProfileKey
+{
+	const PClass *Class;
+	FState *State;
+};
+
+struct FActionProfileHashTraits
+{
+	hash_t Hash(const FActionProfileKey key)
+	{
+		return (hash_t)(((size_t)key.Class >> 4) ^ ((size_t)key.State >> 2));
+	}
+	int Compare(const FActionProfileKey left, const FActionProfileKey right)
+	{
+		return left.Class != right.Class || left.State != right.State;
+	}
+};
+
+// Time per tic, for both single actions and everything together.
+struct FTicTime
+{
+	int CurTic;
+	int NumTics;		// Tics in which anything was billed
+	double TicMS;		// Time in CurTic
+	double MaxTicMS;
+	double TotalMS;
+
+	FTicTime()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		CurTic = -1;
+		NumTics = 0;
+		TicMS = MaxTicMS = TotalMS = 0;
+	}
+
+	void Add(double ms)
+	{
+		if (CurTic != gametic)
+		{
+			CurTic = gametic;
+			NumTics++;
+			TicMS = 0;
+		}
+		TicMS += ms;
+		TotalMS += ms;
+		if (TicMS > MaxTicMS)
+		{
+			MaxTicMS = TicMS;
+		}
+	}
+};
+
+struct FActionProfile
+{
+	unsigned int Calls;
+	double MaxCallMS;
+	FTicTime Time;
+
+	FActionProfile()
+	{
+		Calls = 0;
+		MaxCallMS = 0;
+	}
+};
+
+typedef TMap<FActionProfileKey, FActionProfile, FActionProfileHashTraits> FActionProfileMap;
+
+static FActionProfileMap ActionProfiles;
+static FTicTime AllActions;
+static double ChildMS;
+
+//==========================================================================
+//
+// FState :: CallProfiledAction
+//
+// CallAction goes here instead of calling the action directly while
+// profiling is on.
+//
+//==========================================================================
+
+void FState::CallProfiledAction(AActor *self, AActor *stateowner, StateCallData *statecall)
+{
+	FActionProfileKey key = { stateowner->GetClass(), this };
+	double outer = ChildMS;
+	cycle_t clock;
+
+	ChildMS = 0;
+	clock.Reset();
+	clock.Clock();
+	ActionFunc(self, stateowner, this, ParameterIndex-1, statecall);
+	clock.Unclock();
+
+	double total = clock.TimeMS();
+	double ms = total - ChildMS;
+	ChildMS = outer + total;
+
+	FActionProfile &prof = ActionProfiles[key];
+	prof.Calls++;
+	prof.Time.Add(ms);
+	if (ms > prof.MaxCallMS)
+	{
+		prof.MaxCallMS = ms;
+	}
+	AllActions.Add(ms);
+}
+
+//==========================================================================
+//
+// Report helpers
+//
+//==========================================================================
+
+typedef FActionProfileMap::Pair FActionProfilePair;
+
+static int STACK_ARGS sort_by_total(const void *a_, const void *b_)
+{
+	const FActionProfilePair *a = *(const FActionProfilePair **)a_;
+	const FActionProfilePair *b = *(const FActionProfilePair **)b_;
+	double a_ms = a->Value.Time.TotalMS, b_ms = b->Value.Time.TotalMS;
+
+	return a_ms < b_ms ? 1 : a_ms > b_ms ? -1 : 0;
+}
+
+static int STACK_ARGS sort_by_peak(const void *a_, const void *b_)
+{
+	const FActionProfilePair *a = *(const FActionProfilePair **)a_;
+	const FActionProfilePair *b = *(const FActionProfilePair **)b_;
+	double a_ms = a->Value.Time.MaxTicMS, b_ms = b->Value.Time.MaxTicMS;
+
+	return a_ms < b_ms ? 1 : a_ms > b_ms ? -1 : 0;
+}
+
+static int STACK_ARGS sort_by_calls(const void *a_, const void *b_)
+{
+	const FActionProfilePair *a = *(const FActionProfilePair **)a_;
+	const FActionProfilePair *b = *(const FActionProfilePair **)b_;
+
+	return a->Value.Calls < b->Value.Calls ? 1 : a->Value.Calls > b->Value.Calls ? -1 : 0;
+}
+
+static void GatherProfiles(TArray<FActionProfilePair *> &list,
+	int (STACK_ARGS *sorter)(const void *, const void *))
+{
+	FActionProfileMap::Iterator it(ActionProfiles);
+	FActionProfilePair *pair;
+
+	while (it.NextPair(pair))
+	{
+		list.Push(pair);
+	}
+	if (list.Size() > 0)
+	{
+		qsort(&list[0], list.Size(), sizeof(list[0]), sorter);
+	}
+}
+
+// Describes a state as Owner.Index plus its sprite frame, e.g. "ZombieMan.12 POSS E".
+static FString StateName(FState *state)
+{
+	FString name;
+	const PClass *owner = FState::StaticFindStateOwner(state);
+
+	if (owner != NULL)
+	{
+		name.Format("%s.%d", owner->TypeName.GetChars(), int(state - owner->ActorInfo->OwnedStates));
+	}
+	else
+	{
+		name = "?";
+	}
+	if (state->sprite < sprites.Size())
+	{
+		name.AppendFormat(" %s %c", sprites[state->sprite].name, state->GetFrame() + 'A');
+	}
+	return name;
+}
+
+static const char *ActionName(FState *state)
+{
+	const char *name = FindFunctionName(state->ActionFunc);
+	return name != NULL ? name : "?";
+}
+
+static void PrintProfiles(TArray<FActionProfilePair *> &list, unsigned int limit)
+{
+	Printf(TEXTCOLOR_YELLOW "%-20s %-26s %-20s %9s %10s %8s %8s\n",
+		"Class", "State", "Action", "Calls", "Total ms", "ms/tic", "Peak ms");
+	for (unsigned int i = 0; i < limit && i < list.Size(); ++i)
+	{
+		const FActionProfileKey &key = list[i]->Key;
+		FActionProfile &prof = list[i]->Value;
+
+		Printf("%-20.20s %-26.26s %-20.20s %9u %10.3f %8.4f %8.3f\n",
+			key.Class->TypeName.GetChars(), StateName(key.State).GetChars(), ActionName(key.State),
+			prof.Calls, prof.Time.TotalMS, prof.Time.TotalMS / MAX(prof.Time.NumTics, 1),
+			prof.Time.MaxTicMS);
+	}
+}
+
+static void WriteProfileCSV(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL)
+	{
+		Printf("Could not open %s for writing\n", filename);
+		return;
+	}
+
+	TArray<FActionProfilePair *> list;
+	GatherProfiles(list, sort_by_total);
+
+	fprintf(f, "class,state,action,calls,ms,tics,peaktickms,peakcallms\n");
+	for (unsigned int i = 0; i < list.Size(); ++i)
+	{
+		const FActionProfileKey &key = list[i]->Key;
+		FActionProfile &prof = list[i]->Value;
+
+		fprintf(f, "%s,%s,%s,%u,%.4f,%d,%.4f,%.4f\n",
+			key.Class->TypeName.GetChars(), StateName(key.State).GetChars(), ActionName(key.State),
+			prof.Calls, prof.Time.TotalMS, prof.Time.NumTics, prof.Time.MaxTicMS, prof.MaxCallMS);
+	}
+	fclose(f);
+	Printf("Wrote action profile to %s\n", filename);
+}
+
+static void PrintTotals()
+{
+	Printf("Actions took %.2f ms in %d tics: %.4f ms per tic, %.3f ms in the worst tic\n",
+		AllActions.TotalMS, AllActions.NumTics,
+		AllActions.TotalMS / MAX(AllActions.NumTics, 1), AllActions.MaxTicMS);
+}
+
+//==========================================================================
+//
+// P_ActionProfileSummary
+//
+// Called at the end of a timed demo so that a benchmark run leaves the
+// numbers behind in the log.
+//
+//==========================================================================
+
+void P_ActionProfileSummary()
+{
+	if (!ActionProfiling)
+	{
+		return;
+	}
+
+	TArray<FActionProfilePair *> list;
+	GatherProfiles(list, sort_by_total);
+	PrintTotals();
+	PrintProfiles(list, 10);
+
+	const char *csv = Args->CheckValue("-profileactions");
+	if (csv != NULL)
+	{
+		WriteProfileCSV(csv);
+	}
+}
+
+//==========================================================================
+//
+// CCMD actionprofile
+//
+//==========================================================================
+
+CCMD(actionprofile)
+{
+	int (STACK_ARGS *sorter)(const void *, const void *) = sort_by_total;
+	unsigned int limit = 20;
+
+	for (int i = 1; i < argv.argc(); ++i)
+	{
+		if (stricmp(argv[i], "clear") == 0)
+		{
+			ActionProfiles.Clear();
+			AllActions.Reset();
+			return;
+		}
+		else if (stricmp(argv[i], "csv") == 0)
+		{
+			if (i + 1 >= argv.argc())
+			{
+				Printf("Usage: actionprofile csv <filename>\n");
+			}
+			else
+			{
+				WriteProfileCSV(argv[i + 1]);
+			}
+			return;
+		}
+		else if (stricmp(argv[i], "total") == 0)
+		{
+			sorter = sort_by_total;
+		}
+		else if (stricmp(argv[i], "peak") == 0)
+		{
+			sorter = sort_by_peak;
+		}
+		else if (stricmp(argv[i], "calls") == 0)
+		{
+			sorter = sort_by_calls;
+		}
+		else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+		{
+			limit = (unsigned int)strtoul(argv[i], NULL, 0);
+		}
+		else
+		{
+			Printf("actionprofile [total|peak|calls] [<limit>]\n");
+			Printf("actionprofile clear : Reset profiling information\n");
+			Printf("actionprofile csv <filename> : Write profile to a file\n");
+			return;
+		}
+	}
+
+	if (!ActionProfiling && AllActions.NumTics == 0)
+	{
+		Printf("Set decorate_profile to collect action timings.\n");
+		return;
+	}
+
+	TArray<FActionProfilePair *> list;
+	GatherProfiles(list, sorter);
+	PrintTotals();
+	PrintProfiles(list, limit);
+}
+
+ADD_STAT(actions)
+{
+	FString out;
+	out.Format("Actions: %.3f ms this tic, %.3f ms peak, %u entries",
+		AllActions.CurTic == gametic ? AllActions.TicMS : 0., AllActions.MaxTicMS, ActionProfiles.CountUsed());
+	return out;
+}
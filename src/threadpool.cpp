@@ -0,0 +1,611 @@
+/*
+** threadpool.cpp
+** A small pool of worker threads for splitting independent work items
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "threadpool.h"
+#include "doomerrors.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "c_console.h"
+#include "templates.h"
+#include "v_text.h"
+
+FThreadPool ThreadPool;
+
+// Set for the pool's worker threads. Being thread local, it can be
+// checked without looking at the thread list, which may be changing.
+#ifdef _MSC_VER
+static __declspec(thread) bool IsPoolWorker;
+#else
+static __thread bool IsPoolWorker;
+#endif
+
+// Number of worker threads in addition to the main thread.
+// -1 picks one less than the number of available CPUs.
+CUSTOM_CVAR(Int, sys_workerthreads, -1, CVAR_ARCHIVE|CVAR_GLOBALCONFIG|CVAR_NOINITCALL)
+{
+	if (self < -1) self = -1;
+	else if (self > 32) self = 32;
+	else ThreadPool.Shutdown();	// new threads will be started on demand.
+}
+
+//==========================================================================
+//
+// Platform specific synchronization
+//
+//==========================================================================
+
+#ifdef _WIN32
+
+struct FThreadPoolData
+{
+	CRITICAL_SECTION CritSec;
+	HANDLE WorkSemaphore;
+	HANDLE DoneEvent;
+	TArray<HANDLE> Threads;
+	bool Quit;
+
+	FThreadPoolData()
+	{
+		InitializeCriticalSection(&CritSec);
+		WorkSemaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+		DoneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		Quit = false;
+	}
+
+	~FThreadPoolData()
+	{
+		CloseHandle(DoneEvent);
+		CloseHandle(WorkSemaphore);
+		DeleteCriticalSection(&CritSec);
+	}
+
+	void Lock() { EnterCriticalSection(&CritSec); }
+	void Unlock() { LeaveCriticalSection(&CritSec); }
+
+	static DWORD WINAPI ThreadFunc(LPVOID pool)
+	{
+		((FThreadPool *)pool)->WorkerLoop();
+		return 0;
+	}
+
+	bool StartThread(FThreadPool *pool)
+	{
+		DWORD id;
+		HANDLE thread = CreateThread(NULL, 0, ThreadFunc, pool, 0, &id);
+		if (thread == NULL) return false;
+		Threads.Push(thread);
+		return true;
+	}
+
+	void JoinThreads()
+	{
+		for (unsigned i = 0; i < Threads.Size(); i++)
+		{
+			WaitForSingleObject(Threads[i], INFINITE);
+			CloseHandle(Threads[i]);
+		}
+		Threads.Clear();
+	}
+
+	// All of the following must be called with the lock held.
+	void WakeWorkers(int count)
+	{
+		ReleaseSemaphore(WorkSemaphore, count, NULL);
+	}
+
+	void WaitForWork()
+	{
+		Unlock();
+		WaitForSingleObject(WorkSemaphore, INFINITE);
+		Lock();
+	}
+
+	void SignalDone()
+	{
+		SetEvent(DoneEvent);
+	}
+
+	void WaitForDone()
+	{
+		Unlock();
+		WaitForSingleObject(DoneEvent, INFINITE);
+		Lock();
+	}
+};
+
+#else
+
+struct FThreadPoolData
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t WorkCond;
+	pthread_cond_t DoneCond;
+	TArray<pthread_t> Threads;
+	unsigned Generation;
+	bool Quit;
+
+	FThreadPoolData()
+	{
+		pthread_mutex_init(&Mutex, NULL);
+		pthread_cond_init(&WorkCond, NULL);
+		pthread_cond_init(&DoneCond, NULL);
+		Generation = 0;
+		Quit = false;
+	}
+
+	~FThreadPoolData()
+	{
+		pthread_cond_destroy(&DoneCond);
+		pthread_cond_destroy(&WorkCond);
+		pthread_mutex_destroy(&Mutex);
+	}
+
+	void Lock() { pthread_mutex_lock(&Mutex); }
+	void Unlock() { pthread_mutex_unlock(&Mutex); }
+
+	static void *ThreadFunc(void *pool)
+	{
+		((FThreadPool *)pool)->WorkerLoop();
+		return NULL;
+	}
+
+	bool StartThread(FThreadPool *pool)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, ThreadFunc, pool) != 0) return false;
+		Threads.Push(thread);
+		return true;
+	}
+
+	void JoinThreads()
+	{
+		for (unsigned i = 0; i < Threads.Size(); i++)
+		{
+			pthread_join(Threads[i], NULL);
+		}
+		Threads.Clear();
+	}
+
+	// All of the following must be called with the lock held.
+	void WakeWorkers(int count)
+	{
+		Generation++;
+		pthread_cond_broadcast(&WorkCond);
+	}
+
+	void WaitForWork()
+	{
+		unsigned gen = Generation;
+		while (gen == Generation && !Quit)
+		{
+			pthread_cond_wait(&WorkCond, &Mutex);
+		}
+	}
+
+	void SignalDone()
+	{
+		pthread_cond_signal(&DoneCond);
+	}
+
+	void WaitForDone()
+	{
+		pthread_cond_wait(&DoneCond, &Mutex);
+	}
+};
+
+#endif
+
+//==========================================================================
+//
+// FThreadLock
+//
+//==========================================================================
+
+#ifdef _WIN32
+
+FThreadLock::FThreadLock()
+{
+	CRITICAL_SECTION *cs = new CRITICAL_SECTION;
+	InitializeCriticalSection(cs);
+	Handle = cs;
+}
+
+FThreadLock::~FThreadLock()
+{
+	CRITICAL_SECTION *cs = (CRITICAL_SECTION *)Handle;
+	DeleteCriticalSection(cs);
+	delete cs;
+}
+
+void FThreadLock::Enter()
+{
+	EnterCriticalSection((CRITICAL_SECTION *)Handle);
+}
+
+void FThreadLock::Leave()
+{
+	LeaveCriticalSection((CRITICAL_SECTION *)Handle);
+}
+
+#else
+
+FThreadLock::FThreadLock()
+{
+	pthread_mutex_t *mutex = new pthread_mutex_t;
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(mutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+	Handle = mutex;
+}
+
+FThreadLock::~FThreadLock()
+{
+	pthread_mutex_t *mutex = (pthread_mutex_t *)Handle;
+	pthread_mutex_destroy(mutex);
+	delete mutex;
+}
+
+void FThreadLock::Enter()
+{
+	pthread_mutex_lock((pthread_mutex_t *)Handle);
+}
+
+void FThreadLock::Leave()
+{
+	pthread_mutex_unlock((pthread_mutex_t *)Handle);
+}
+
+#endif
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FThreadPool::FThreadPool()
+{
+	Data = NULL;
+	NumWorkers = 0;
+	Busy = false;
+	Func = NULL;
+	UserData = NULL;
+	Count = 0;
+	NextItem = 0;
+	ItemsDone = 0;
+	ErrorType = ERROR_None;
+}
+
+FThreadPool::~FThreadPool()
+{
+	Shutdown();
+}
+
+//==========================================================================
+//
+// FThreadPool :: GetNumCPUs
+//
+//==========================================================================
+
+int FThreadPool::GetNumCPUs()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return MAX<int>(1, info.dwNumberOfProcessors);
+#else
+	return MAX<int>(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+//==========================================================================
+//
+// FThreadPool :: GetNumThreads
+//
+//==========================================================================
+
+int FThreadPool::GetNumThreads()
+{
+	int workers = sys_workerthreads;
+	if (workers < 0)
+	{
+		workers = MIN(GetNumCPUs() - 1, 16);
+	}
+	return workers + 1;
+}
+
+//==========================================================================
+//
+// FThreadPool :: StartThreads
+//
+//==========================================================================
+
+void FThreadPool::StartThreads(int numthreads)
+{
+	Data = new FThreadPoolData;
+	for (NumWorkers = 0; NumWorkers < numthreads; NumWorkers++)
+	{
+		if (!Data->StartThread(this)) break;
+	}
+}
+
+//==========================================================================
+//
+// FThreadPool :: Shutdown
+//
+// Stops all worker threads. Must not be called while a job is running.
+//
+//==========================================================================
+
+void FThreadPool::Shutdown()
+{
+	if (Data != NULL)
+	{
+		Data->Lock();
+		Data->Quit = true;
+		Data->WakeWorkers(NumWorkers);
+		Data->Unlock();
+		Data->JoinThreads();
+		delete Data;
+		Data = NULL;
+	}
+	NumWorkers = 0;
+}
+
+//==========================================================================
+//
+// FThreadPool :: IsWorkerThread
+//
+//==========================================================================
+
+bool FThreadPool::IsWorkerThread()
+{
+	return IsPoolWorker;
+}
+
+//==========================================================================
+//
+// FThreadPool :: DeferPrint
+//
+// Console output is not thread safe so anything a worker prints
+// is collected and printed by the main thread after the job.
+//
+//==========================================================================
+
+void FThreadPool::DeferPrint(int printlevel, const char *text)
+{
+	Data->Lock();
+	FDeferredPrint &print = DeferredPrints[DeferredPrints.Reserve(1)];
+	print.PrintLevel = printlevel;
+	print.Text = text;
+	Data->Unlock();
+}
+
+void FThreadPool::FlushPrints()
+{
+	TArray<FDeferredPrint> prints;
+
+	Data->Lock();
+	prints = DeferredPrints;
+	DeferredPrints.Clear();
+	Data->Unlock();
+
+	for (unsigned i = 0; i < prints.Size(); i++)
+	{
+		PrintString(prints[i].PrintLevel, prints[i].Text);
+	}
+}
+
+//==========================================================================
+//
+// FThreadPool :: RunItems
+//
+// Claims chunks of items until the current job is exhausted.
+// Must be called with the lock held and returns with the lock held.
+//
+//==========================================================================
+
+void FThreadPool::RunItems()
+{
+	// Hand out work in chunks so that small items do not spend all
+	// their time fighting over the lock.
+	int chunk = MAX(1, Count / ((NumWorkers + 1) * 8));
+
+	while (NextItem < Count)
+	{
+		int start = NextItem;
+		int end = MIN(start + chunk, Count);
+		JobFunc func = Func;
+		void *userdata = UserData;
+		NextItem = end;
+
+		Data->Unlock();
+		for (int i = start; i < end; i++)
+		{
+			try
+			{
+				func(userdata, i);
+			}
+			catch (CRecoverableError &err)
+			{
+				SetError(ERROR_Recoverable, err.GetMessage());
+			}
+			catch (CNoRunExit &)
+			{
+				SetError(ERROR_NoRunExit, NULL);
+			}
+			catch (CDoomError &err)
+			{
+				SetError(ERROR_Fatal, err.GetMessage());
+			}
+			catch (...)
+			{
+				// Anything else would take the whole process down if it left the thread.
+				SetError(ERROR_Fatal, NULL);
+			}
+		}
+		Data->Lock();
+
+		ItemsDone += end - start;
+		if (ItemsDone == Count)
+		{
+			Data->SignalDone();
+		}
+	}
+}
+
+//==========================================================================
+//
+// FThreadPool :: SetError
+//
+// Remembers the first error a job raised so that ParallelFor can throw
+// it again on the calling thread, as the same kind of error.
+//
+//==========================================================================
+
+void FThreadPool::SetError(int type, const char *message)
+{
+	Data->Lock();
+	if (ErrorType == ERROR_None)
+	{
+		ErrorType = type;
+		Error = message != NULL ? message : "Unknown error in worker thread";
+	}
+	Data->Unlock();
+}
+
+//==========================================================================
+//
+// FThreadPool :: WorkerLoop
+//
+//==========================================================================
+
+void FThreadPool::WorkerLoop()
+{
+	IsPoolWorker = true;
+	Data->Lock();
+	while (!Data->Quit)
+	{
+		Data->WaitForWork();
+		if (Data->Quit) break;
+		RunItems();
+	}
+	Data->Unlock();
+}
+
+//==========================================================================
+//
+// FThreadPool :: ParallelFor
+//
+//==========================================================================
+
+void FThreadPool::ParallelFor(int count, JobFunc func, void *userdata)
+{
+	if (count <= 0) return;
+
+	int numthreads = GetNumThreads() - 1;
+
+	if (Busy || numthreads <= 0 || count == 1)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			func(userdata, i);
+		}
+		return;
+	}
+
+	if (Data == NULL || NumWorkers != numthreads)
+	{
+		Shutdown();
+		StartThreads(numthreads);
+	}
+
+	Data->Lock();
+	Busy = true;
+	Func = func;
+	UserData = userdata;
+	Count = count;
+	NextItem = 0;
+	ItemsDone = 0;
+	Error = "";
+	ErrorType = ERROR_None;
+	Data->WakeWorkers(NumWorkers);
+
+	RunItems();
+	while (ItemsDone < Count)
+	{
+		Data->WaitForDone();
+	}
+
+	Func = NULL;
+	UserData = NULL;
+	Busy = false;
+	FString error = Error;
+	int errortype = ErrorType;
+	Data->Unlock();
+
+	FlushPrints();
+	switch (errortype)
+	{
+	case ERROR_Recoverable:
+		throw CRecoverableError(error);
+
+	case ERROR_NoRunExit:
+		throw CNoRunExit();
+
+	case ERROR_Fatal:
+		throw CFatalError(error);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(threadpoolinfo)
+{
+	Printf("%d CPUs, %d threads per job\n", FThreadPool::GetNumCPUs(), ThreadPool.GetNumThreads());
+}
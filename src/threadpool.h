@@ -0,0 +1,164 @@
+/*
+** threadpool.h
+** A small pool of worker threads for splitting independent work items
+**
+**---------------------------------------------------------------------------
+** Copyright 2016 The GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The pool only knows one kind of job: run a function for every index
+** in a range and return once all of them are done. The calling thread
+** participates in the work, so with no worker threads (sys_workerthreads 0)
+** everything simply runs serially in the caller.
+**
+** Jobs may not call into anything that is not thread safe. In particular
+** this means no DObject allocation and no renderer calls. Console output
+** from a worker thread is held back and printed once the job is done. FNames
+** can be looked up and created from jobs.
+**
+*/
+
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+
+#include "tarray.h"
+#include "zstring.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+struct FThreadPoolData;
+
+// Memory ordering for data that is published to other threads without a
+// lock. The writer issues a WriteBarrier between filling in an object and
+// storing the pointer to it. A reader issues a ReadBarrier between loading
+// that pointer and using what it points to, which needs nothing but a
+// compiler barrier on x86.
+#ifdef _MSC_VER
+inline void WriteBarrier() { long dummy = 0; _InterlockedExchange(&dummy, 1); }
+inline void ReadBarrier() { _ReadWriteBarrier(); }
+#else
+inline void WriteBarrier() { __sync_synchronize(); }
+#if defined(__i386__) || defined(__x86_64__)
+inline void ReadBarrier() { __asm__ __volatile__("" ::: "memory"); }
+#else
+inline void ReadBarrier() { __sync_synchronize(); }
+#endif
+#endif
+
+// A recursive mutex for data that pool jobs share. Unlike FCriticalSection
+// it does not drag any system headers into the files using it.
+class FThreadLock
+{
+public:
+	FThreadLock();
+	~FThreadLock();
+	void Enter();
+	void Leave();
+
+private:
+	void *Handle;
+};
+
+class FThreadLockGuard
+{
+public:
+	FThreadLockGuard(FThreadLock &lock) : Lock(lock) { Lock.Enter(); }
+	~FThreadLockGuard() { Lock.Leave(); }
+
+private:
+	FThreadLock &Lock;
+};
+
+class FThreadPool
+{
+public:
+	typedef void (*JobFunc)(void *userdata, int index);
+
+	FThreadPool();
+	~FThreadPool();
+
+	// Calls func(userdata, i) for each i in [0, count). Items may be
+	// processed in any order and on any thread. Nested calls from inside
+	// a job are executed serially on the calling thread. If a job throws,
+	// the first error is thrown again from here once all items are done,
+	// as the same kind of error; anything that is not a CDoomError is
+	// turned into a CFatalError.
+	void ParallelFor(int count, JobFunc func, void *userdata);
+
+	// Number of threads that will work on a job, including the caller.
+	int GetNumThreads();
+
+	void Shutdown();
+
+	// True if the calling thread is one of the pool's workers.
+	bool IsWorkerThread();
+	void DeferPrint(int printlevel, const char *text);
+
+	static int GetNumCPUs();
+
+private:
+	void StartThreads(int numthreads);
+	void WorkerLoop();
+	void RunItems();
+	void FlushPrints();
+	void SetError(int type, const char *message);
+
+	enum
+	{
+		ERROR_None,
+		ERROR_Recoverable,
+		ERROR_Fatal,
+		ERROR_NoRunExit
+	};
+
+	FThreadPoolData *Data;
+	int NumWorkers;
+	bool Busy;
+
+	JobFunc Func;
+	void *UserData;
+	int Count;
+	int NextItem;
+	int ItemsDone;
+	FString Error;
+	int ErrorType;
+
+	struct FDeferredPrint
+	{
+		int PrintLevel;
+		FString Text;
+	};
+	TArray<FDeferredPrint> DeferredPrints;
+
+	friend struct FThreadPoolData;
+};
+
+extern FThreadPool ThreadPool;
+
+#endif
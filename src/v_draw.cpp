@@ -106,6 +106,120 @@ static int PalFromRGB(uint32 rgb)
 	return LastPal;
 }
 
+//==========================================================================
+//
+// FDrawTags
+//
+//==========================================================================
+
+FDrawTags::Item *FDrawTags::NewItem(uint32 tag)
+{
+	// Tags that do not fit are dropped. No caller comes anywhere near this.
+	static Item overflow;
+
+	assert(NumItems < MAX_TAGS && "Too many tags for DrawTexture");
+	Item *item = NumItems < MAX_TAGS ? &Items[NumItems++] : &overflow;
+	item->Tag = tag;
+	return item;
+}
+
+int FDrawTags::AddInt(uint32 tag, int value)
+{
+	NewItem(tag)->Int = value;
+	return NumItems - 1;
+}
+
+int FDrawTags::AddFloat(uint32 tag, double value)
+{
+	NewItem(tag)->Float = value;
+	return NumItems - 1;
+}
+
+int FDrawTags::AddPtr(uint32 tag, const void *value)
+{
+	NewItem(tag)->Ptr = value;
+	return NumItems - 1;
+}
+
+//==========================================================================
+//
+// FDrawTags :: AddList
+//
+// Reads a tag list up to TAG_DONE, following TAG_MORE. (For floating point
+// attributes, consider that the C ABI dictates that all floats be promoted
+// to doubles when passed as function arguments.)
+//
+//==========================================================================
+
+void FDrawTags::AddList(uint32 tag, va_list tags)
+{
+	while (tag != TAG_DONE)
+	{
+		va_list *more_p;
+
+		switch (tag)
+		{
+		case TAG_IGNORE:
+			va_arg(tags, DWORD);
+			break;
+
+		case TAG_MORE:
+			more_p = va_arg(tags, va_list *);
+			va_end (tags);
+#ifndef NO_VA_COPY
+			va_copy (tags, *more_p);
+#else
+			tags = *more_p;
+#endif
+			break;
+
+		case DTA_DestWidthF:
+		case DTA_DestHeightF:
+		case DTA_VirtualWidthF:
+		case DTA_VirtualHeightF:
+		case DTA_TopOffsetF:
+		case DTA_LeftOffsetF:
+		case DTA_WindowLeftF:
+		case DTA_WindowRightF:
+			AddFloat(tag, va_arg(tags, double));
+			break;
+
+		case DTA_Translation:
+		case DTA_SpecialColormap:
+		case DTA_ColormapStyle:
+			AddPtr(tag, va_arg(tags, void *));
+			break;
+
+		default:
+			AddInt(tag, va_arg(tags, int));
+			break;
+		}
+		tag = va_arg(tags, DWORD);
+	}
+	va_end (tags);
+}
+
+void STACK_ARGS FDrawTags::AddTags(int tags_first, ...)
+{
+	va_list tags;
+	va_start(tags, tags_first);
+	AddList(tags_first, tags);
+}
+
+void FDrawTags::Append(const FDrawTags &other)
+{
+	for (int i = 0; i < other.NumItems; ++i)
+	{
+		*NewItem(other.Items[i].Tag) = other.Items[i];
+	}
+}
+
+//==========================================================================
+//
+// DCanvas :: DrawTexture
+//
+//==========================================================================
+
 void STACK_ARGS DCanvas::DrawTexture (FTexture *img, double x, double y, int tags_first, ...)
 {
 	va_list tags;
@@ -115,17 +229,36 @@ void STACK_ARGS DCanvas::DrawTexture (FTexture *img, double x, double y, int tag
 
 void STACK_ARGS DCanvas::DrawTextureV(FTexture *img, double x, double y, uint32 tag, va_list tags)
 {
-#ifndef NO_SWRENDER
-	FTexture::Span unmaskedSpan[2];
-	const FTexture::Span **spanptr, *spans;
-	static short bottomclipper[MAXWIDTH], topclipper[MAXWIDTH];
+	FDrawTags drawtags;
 
+	drawtags.AddList(tag, tags);
+	DrawTexture(img, x, y, drawtags);
+}
+
+void DCanvas::DrawTexture (FTexture *img, double x, double y, const FDrawTags &tags)
+{
 	DrawParms parms;
 
-	if (!ParseDrawTextureTags(img, x, y, tag, tags, &parms, false))
+	if (ParseDrawTextureTags(img, x, y, tags, &parms))
 	{
-		return;
+		DrawTextureParms(img, parms);
 	}
+}
+
+//==========================================================================
+//
+// DCanvas :: DrawTextureParms
+//
+// The software implementation
+//
+//==========================================================================
+
+void DCanvas::DrawTextureParms(FTexture *img, DrawParms &parms)
+{
+#ifndef NO_SWRENDER
+	FTexture::Span unmaskedSpan[2];
+	const FTexture::Span **spanptr, *spans;
+	static short bottomclipper[MAXWIDTH], topclipper[MAXWIDTH];
 
 	if (parms.masked)
 	{
@@ -327,7 +460,13 @@ void STACK_ARGS DCanvas::DrawTextureV(FTexture *img, double x, double y, uint32
 #endif
 }
 
-bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag, va_list tags, DrawParms *parms, bool hw) const
+//==========================================================================
+//
+// DCanvas :: ParseDrawTextureTags
+//
+//==========================================================================
+
+bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, const FDrawTags &tags, DrawParms *parms) const
 {
 	INTBOOL boolval;
 	int intval;
@@ -336,14 +475,12 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 
 	if (img == NULL || img->UseType == FTexture::TEX_Null)
 	{
-		va_end(tags);
 		return false;
 	}
 
 	// Do some sanity checks on the coordinates.
 	if (x < -16383 || x > 16383 || y < -16383 || y > 16383)
 	{
-		va_end(tags);
 		return false;
 	}
 
@@ -383,49 +520,34 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 	parms->x = x;
 	parms->y = y;
 
-	// Parse the tag list for attributes. (For floating point attributes,
-	// consider that the C ABI dictates that all floats be promoted to
-	// doubles when passed as function arguments.)
-	while (tag != TAG_DONE)
+	// Apply the tags in the order they were given.
+	for (int i = 0; i < tags.Size(); ++i)
 	{
-		va_list *more_p;
-		DWORD data;
+		const FDrawTags::Item &item = tags[i];
 
-		switch (tag)
+		switch (item.Tag)
 		{
-		case TAG_IGNORE:
 		default:
-			data = va_arg(tags, DWORD);
-			break;
-
-		case TAG_MORE:
-			more_p = va_arg(tags, va_list *);
-			va_end (tags);
-#ifndef NO_VA_COPY
-			va_copy (tags, *more_p);
-#else
-			tags = *more_p;
-#endif
 			break;
 
 		case DTA_DestWidth:
-			parms->destwidth = va_arg(tags, int);
+			parms->destwidth = item.Int;
 			break;
 
 		case DTA_DestWidthF:
-			parms->destwidth = va_arg(tags, double);
+			parms->destwidth = item.Float;
 			break;
 
 		case DTA_DestHeight:
-			parms->destheight = va_arg(tags, int);
+			parms->destheight = item.Int;
 			break;
 
 		case DTA_DestHeightF:
-			parms->destheight = va_arg(tags, double);
+			parms->destheight = item.Float;
 			break;
 
 		case DTA_Clean:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->x = (parms->x - 160.0) * CleanXfac + (Width * 0.5);
@@ -436,7 +558,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_CleanNoMove:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->destwidth = parms->texwidth * CleanXfac;
@@ -445,7 +567,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_CleanNoMove_1:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->destwidth = parms->texwidth * CleanXfac_1;
@@ -454,7 +576,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_320x200:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->virtWidth = 320;
@@ -463,7 +585,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_Bottom320x200:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->virtWidth = 320;
@@ -476,7 +598,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			{
 				bool xright = parms->x < 0;
 				bool ybot = parms->y < 0;
-				intval = va_arg(tags, int);
+				intval = item.Int;
 
 				if (hud_scale)
 				{
@@ -504,23 +626,23 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_VirtualWidth:
-			parms->virtWidth = va_arg(tags, int);
+			parms->virtWidth = item.Int;
 			break;
 
 		case DTA_VirtualWidthF:
-			parms->virtWidth = va_arg(tags, double);
+			parms->virtWidth = item.Float;
 			break;
 			
 		case DTA_VirtualHeight:
-			parms->virtHeight = va_arg(tags, int);
+			parms->virtHeight = item.Int;
 			break;
 
 		case DTA_VirtualHeightF:
-			parms->virtHeight = va_arg(tags, double);
+			parms->virtHeight = item.Float;
 			break;
 
 		case DTA_Fullscreen:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->x = parms->y = 0;
@@ -530,19 +652,19 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_Alpha:
-			parms->alpha = MIN<fixed_t>(FRACUNIT, va_arg (tags, fixed_t));
+			parms->alpha = MIN<fixed_t>(FRACUNIT, item.Int);
 			break;
 
 		case DTA_AlphaChannel:
-			parms->alphaChannel = va_arg(tags, INTBOOL);
+			parms->alphaChannel = item.Int;
 			break;
 
 		case DTA_FillColor:
-			parms->fillcolor = va_arg(tags, uint32);
+			parms->fillcolor = (uint32)item.Int;
 			break;
 
 		case DTA_Translation:
-			parms->remap = va_arg(tags, FRemapTable *);
+			parms->remap = (FRemapTable *)item.Ptr;
 			if (parms->remap != NULL && parms->remap->Inactive)
 			{ // If it's inactive, pretend we were passed NULL instead.
 				parms->remap = NULL;
@@ -550,31 +672,31 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_ColorOverlay:
-			parms->colorOverlay = va_arg(tags, DWORD);
+			parms->colorOverlay = (DWORD)item.Int;
 			break;
 
 		case DTA_FlipX:
-			parms->flipX = va_arg(tags, INTBOOL);
+			parms->flipX = item.Int;
 			break;
 
 		case DTA_TopOffset:
-			parms->top = va_arg(tags, int);
+			parms->top = item.Int;
 			break;
 
 		case DTA_TopOffsetF:
-			parms->top = va_arg(tags, double);
+			parms->top = item.Float;
 			break;
 
 		case DTA_LeftOffset:
-			parms->left = va_arg(tags, int);
+			parms->left = item.Int;
 			break;
 
 		case DTA_LeftOffsetF:
-			parms->left = va_arg(tags, double);
+			parms->left = item.Float;
 			break;
 
 		case DTA_CenterOffset:
-			if (va_arg(tags, int))
+			if (item.Int)
 			{
 				parms->left = parms->texwidth * 0.5;
 				parms->top = parms->texheight * 0.5;
@@ -582,7 +704,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_CenterBottomOffset:
-			if (va_arg(tags, int))
+			if (item.Int)
 			{
 				parms->left = parms->texwidth * 0.5;
 				parms->top = parms->texheight;
@@ -590,23 +712,23 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_WindowLeft:
-			parms->windowleft = va_arg(tags, int);
+			parms->windowleft = item.Int;
 			break;
 
 		case DTA_WindowLeftF:
-			parms->windowleft = va_arg(tags, double);
+			parms->windowleft = item.Float;
 			break;
 
 		case DTA_WindowRight:
-			parms->windowright = va_arg(tags, int);
+			parms->windowright = item.Int;
 			break;
 
 		case DTA_WindowRightF:
-			parms->windowright = va_arg(tags, double);
+			parms->windowright = item.Float;
 			break;
 
 		case DTA_ClipTop:
-			parms->uclip = va_arg(tags, int);
+			parms->uclip = item.Int;
 			if (parms->uclip < 0)
 			{
 				parms->uclip = 0;
@@ -614,7 +736,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_ClipBottom:
-			parms->dclip = va_arg(tags, int);
+			parms->dclip = item.Int;
 			if (parms->dclip > this->GetHeight())
 			{
 				parms->dclip = this->GetHeight();
@@ -622,7 +744,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_ClipLeft:
-			parms->lclip = va_arg(tags, int);
+			parms->lclip = item.Int;
 			if (parms->lclip < 0)
 			{
 				parms->lclip = 0;
@@ -630,7 +752,7 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_ClipRight:
-			parms->rclip = va_arg(tags, int);
+			parms->rclip = item.Int;
 			if (parms->rclip > this->GetWidth())
 			{
 				parms->rclip = this->GetWidth();
@@ -638,15 +760,15 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_ShadowAlpha:
-			parms->shadowAlpha = MIN<fixed_t>(FRACUNIT, va_arg (tags, fixed_t));
+			parms->shadowAlpha = MIN<fixed_t>(FRACUNIT, item.Int);
 			break;
 
 		case DTA_ShadowColor:
-			parms->shadowColor = va_arg(tags, int);
+			parms->shadowColor = item.Int;
 			break;
 
 		case DTA_Shadow:
-			boolval = va_arg(tags, INTBOOL);
+			boolval = item.Int;
 			if (boolval)
 			{
 				parms->shadowAlpha = FRACUNIT/2;
@@ -659,34 +781,32 @@ bool DCanvas::ParseDrawTextureTags (FTexture *img, double x, double y, DWORD tag
 			break;
 
 		case DTA_Masked:
-			parms->masked = va_arg(tags, INTBOOL);
+			parms->masked = item.Int;
 			break;
 
 		case DTA_BilinearFilter:
-			parms->bilinear = va_arg(tags, INTBOOL);
+			parms->bilinear = item.Int;
 			break;
 
 		case DTA_KeepRatio:
 			// I think this is a terribly misleading name, since it actually turns
 			// *off* aspect ratio correction.
-			parms->keepratio = va_arg(tags, INTBOOL);
+			parms->keepratio = item.Int;
 			break;
 
 		case DTA_RenderStyle:
-			parms->style.AsDWORD = va_arg(tags, DWORD);
+			parms->style.AsDWORD = (DWORD)item.Int;
 			break;
 
 		case DTA_SpecialColormap:
-			parms->specialcolormap = va_arg(tags, FSpecialColormap *);
+			parms->specialcolormap = (FSpecialColormap *)item.Ptr;
 			break;
 
 		case DTA_ColormapStyle:
-			parms->colormapstyle = va_arg(tags, FColormapStyle *);
+			parms->colormapstyle = (FColormapStyle *)item.Ptr;
 			break;
 		}
-		tag = va_arg(tags, DWORD);
 	}
-	va_end (tags);
 
 	if (parms->uclip >= parms->dclip || parms->lclip >= parms->rclip)
 	{
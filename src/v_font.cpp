@@ -180,6 +180,7 @@ public:
    const BYTE *GetPixels ();
    void SetSourceRemap(const BYTE *sourceremap);
    void Unload ();
+   bool GetBuildSources(TArray<FTexture *> &sources) { sources.Push(BaseTexture); return true; }
    ~FFontChar1 ();
 
 protected:
@@ -206,7 +207,7 @@ protected:
 	int SourceLump;
 	int SourcePos;
 	BYTE *Pixels;
-	Span **Spans;
+	SpanTable *Spans;
 	const BYTE *SourceRemap;
 
 	void MakeTexture ();
@@ -1758,9 +1759,9 @@ const BYTE *FFontChar2::GetColumn (unsigned int column, const Span **spans_out)
 	{
 		if (Spans == NULL)
 		{
-			Spans = CreateSpans (Pixels);
+			Spans = CreateSpans ();
 		}
-		*spans_out = Spans[column];
+		*spans_out = Spans->GetColumn(column, Pixels + column*Height);
 	}
 	return Pixels + column*Height;
 }
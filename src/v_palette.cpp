@@ -57,6 +57,7 @@
 #include "colormatcher.h"
 #include "v_palette.h"
 #include "r_data/colormaps.h"
+#include "stats.h"
 
 FPalette GPalette;
 FColorMatcher ColorMatcher;
@@ -107,16 +108,10 @@ CCMD (bumpgamma)
 /****************************/
 
 extern "C" BYTE BestColor_MMX (DWORD rgb, const DWORD *pal);
+extern int BestColor_SSE2 (const PalEntry *pal, int r, int g, int b, int first, int num);
 
-int BestColor (const uint32 *pal_in, int r, int g, int b, int first, int num)
+static int BestColor_C (const uint32 *pal_in, int r, int g, int b, int first, int num)
 {
-#ifdef X86_ASM
-	if (CPU.bMMX)
-	{
-		int pre = 256 - num - first;
-		return BestColor_MMX (((first+pre)<<24)|(r<<16)|(g<<8)|b, pal_in-pre) - pre;
-	}
-#endif
 	const PalEntry *pal = (const PalEntry *)pal_in;
 	int bestcolor = first;
 	int bestdist = 257*257+257*257+257*257;
@@ -139,6 +134,24 @@ int BestColor (const uint32 *pal_in, int r, int g, int b, int first, int num)
 	return bestcolor;
 }
 
+int BestColor (const uint32 *pal_in, int r, int g, int b, int first, int num)
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__i386__) || defined(__amd64__)
+	if (CPU.bSSE2 && (unsigned)(r|g|b) <= 255)
+	{
+		return BestColor_SSE2 ((const PalEntry *)pal_in, r, g, b, first, num);
+	}
+#endif
+#ifdef X86_ASM
+	if (CPU.bMMX)
+	{
+		int pre = 256 - num - first;
+		return BestColor_MMX (((first+pre)<<24)|(r<<16)|(g<<8)|b, pal_in-pre) - pre;
+	}
+#endif
+	return BestColor_C (pal_in, r, g, b, first, num);
+}
+
 FPalette::FPalette ()
 {
 }
@@ -290,9 +303,18 @@ void FPalette::MakeRemap (const DWORD *colors, BYTE *remap, const BYTE *useful,
 		{
 			if (workspace[i].Foreign == 1)
 			{
-				remap[workspace[i].PalEntry] = BestColor ((DWORD *)BaseColors,
-					RPART(workspace[i].Color), GPART(workspace[i].Color), BPART(workspace[i].Color),
-					1, 255);
+				int r = RPART(workspace[i].Color), g = GPART(workspace[i].Color), b = BPART(workspace[i].Color);
+
+				// The color matcher's table gives the same answer as BestColor
+				// over 1..254, without searching the whole palette.
+				if (ColorMatcher.IsBuiltFor ((const DWORD *)BaseColors))
+				{
+					remap[workspace[i].PalEntry] = ColorMatcher.Pick (r, g, b);
+				}
+				else
+				{
+					remap[workspace[i].PalEntry] = BestColor ((DWORD *)BaseColors, r, g, b, 1, 255);
+				}
 			}
 		}
 	}
@@ -640,3 +662,69 @@ CCMD (testcolor)
 		NormalLight.ChangeColor (color, desaturate);
 	}
 }
+
+//==========================================================================
+//
+// CCMD bench_colormatch
+//
+// Times the different ways of finding the closest palette color for a
+// set of random colors and checks that they all agree.
+//
+//==========================================================================
+
+CCMD (bench_colormatch)
+{
+	int count = argv.argc() > 1 ? atoi (argv[1]) : 1000000;
+	const uint32 *pal = (const uint32 *)GPalette.BaseColors;
+	TArray<DWORD> colors;
+	TArray<BYTE> results;
+	cycle_t plain, simd, table;
+	DWORD seed = 0x1234567;
+	int i, mismatches = 0;
+
+	if (count <= 0)
+	{
+		Printf ("bench_colormatch [count]\n");
+		return;
+	}
+	colors.Resize (count);
+	results.Resize (count);
+	for (i = 0; i < count; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		colors[i] = seed >> 8;
+	}
+
+	plain.Reset ();
+	plain.Clock ();
+	for (i = 0; i < count; ++i)
+	{
+		results[i] = (BYTE)BestColor_C (pal, RPART(colors[i]), GPART(colors[i]), BPART(colors[i]), 1, 255);
+	}
+	plain.Unclock ();
+
+	simd.Reset ();
+	simd.Clock ();
+	for (i = 0; i < count; ++i)
+	{
+		int c = BestColor (pal, RPART(colors[i]), GPART(colors[i]), BPART(colors[i]));
+		if (c != results[i]) mismatches++;
+	}
+	simd.Unclock ();
+
+	table.Reset ();
+	table.Clock ();
+	for (i = 0; i < count; ++i)
+	{
+		int c = ColorMatcher.Pick (RPART(colors[i]), GPART(colors[i]), BPART(colors[i]));
+		if (c != results[i]) mismatches++;
+	}
+	table.Unclock ();
+
+	Printf ("%d colors: C %.2f ms, BestColor %.2f ms, color matcher %.2f ms (%d table candidates)\n",
+		count, plain.TimeMS(), simd.TimeMS(), table.TimeMS(), ColorMatcher.GetNumCandidates());
+	if (mismatches > 0)
+	{
+		Printf ("%d mismatches\n", mismatches);
+	}
+}
@@ -80,10 +80,21 @@ void STACK_ARGS DCanvas::DrawChar (FFont *font, int normalcolor, int x, int y, B
 //
 void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *string, va_list taglist)
 {
-	INTBOOL boolval;
+	FDrawTags drawtags;
 	va_list tags;
-	uint32 tag;
 
+#ifndef NO_VA_COPY
+	va_copy(tags, taglist);
+#else
+	tags = taglist;
+#endif
+	drawtags.AddList(va_arg(tags, uint32), tags);
+	DrawText(font, normalcolor, x, y, string, drawtags);
+	va_end(taglist);
+}
+
+void DCanvas::DrawText(FFont *font, int normalcolor, int x, int y, const char *string, const FDrawTags &tags)
+{
 	int			maxstrlen = INT_MAX;
 	int 		w, maxwidth;
 	const BYTE *ch;
@@ -113,37 +124,15 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 	cx = x;
 	cy = y;
 
-	// Parse the tag list to see if we need to adjust for scaling.
+	// Check the tag list to see if we need to adjust for scaling.
  	maxwidth = Width;
 	scalex = scaley = 1;
 
-#ifndef NO_VA_COPY
-	va_copy(tags, taglist);
-#else
-	tags = taglist;
-#endif
-	tag = va_arg(tags, uint32);
-
-	while (tag != TAG_DONE)
+	for (int i = 0; i < tags.Size(); ++i)
 	{
-		va_list *more_p;
-		DWORD data;
-
-		switch (tag)
+		switch (tags[i].Tag)
 		{
-		case TAG_IGNORE:
 		default:
-			data = va_arg (tags, DWORD);
-			break;
-
-		case TAG_MORE:
-			more_p = va_arg (tags, va_list*);
-			va_end (tags);
-#ifndef NO_VA_COPY
-			va_copy (tags, *more_p);
-#else
-			tags = *more_p;
-#endif
 			break;
 
 		// We don't handle these. :(
@@ -154,8 +143,7 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 			return;
 
 		case DTA_CleanNoMove_1:
-			boolval = va_arg (tags, INTBOOL);
-			if (boolval)
+			if (tags[i].Int)
 			{
 				scalex = CleanXfac_1;
 				scaley = CleanYfac_1;
@@ -164,8 +152,7 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 			break;
 
 		case DTA_CleanNoMove:
-			boolval = va_arg (tags, INTBOOL);
-			if (boolval)
+			if (tags[i].Int)
 			{
 				scalex = CleanXfac;
 				scaley = CleanYfac;
@@ -175,8 +162,7 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 
 		case DTA_Clean:
 		case DTA_320x200:
-			boolval = va_arg (tags, INTBOOL);
-			if (boolval)
+			if (tags[i].Int)
 			{
 				scalex = scaley = 1;
 				maxwidth = 320;
@@ -184,27 +170,35 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 			break;
 
 		case DTA_VirtualWidth:
-			maxwidth = va_arg (tags, int);
+			maxwidth = tags[i].Int;
 			scalex = scaley = 1;
 			break;
 
 		case DTA_TextLen:
-			maxstrlen = va_arg (tags, int);
+			maxstrlen = tags[i].Int;
 			break;
 
 		case DTA_CellX:
-			forcedwidth = va_arg (tags, int);
+			forcedwidth = tags[i].Int;
 			break;
 
 		case DTA_CellY:
-			height = va_arg (tags, int);
+			height = tags[i].Int;
 			break;
 		}
-		tag = va_arg (tags, uint32);
 	}
-	va_end(tags);
 
 	height *= scaley;
+
+	// The tags are the same for every character, except for the translation.
+	FDrawTags chartags;
+	int transindex = chartags.AddPtr(DTA_Translation, range);
+	if (forcedwidth)
+	{
+		chartags.AddInt(DTA_DestWidth, forcedwidth);
+		chartags.AddInt(DTA_DestHeight, height);
+	}
+	chartags.Append(tags);
 		
 	while ((const char *)ch - string < maxstrlen)
 	{
@@ -218,6 +212,7 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 			if (newcolor != CR_UNDEFINED)
 			{
 				range = font->GetColorTranslation (newcolor);
+				chartags[transindex].Ptr = range;
 			}
 			continue;
 		}
@@ -231,31 +226,14 @@ void DCanvas::DrawTextV(FFont *font, int normalcolor, int x, int y, const char *
 
 		if (NULL != (pic = font->GetChar (c, &w)))
 		{
-#ifndef NO_VA_COPY
-			va_copy(tags, taglist);
-#else
-			tags = taglist;
-#endif
 			if (forcedwidth)
 			{
 				w = forcedwidth;
-				DrawTexture (pic, cx, cy,
-					DTA_Translation, range,
-					DTA_DestWidth, forcedwidth,
-					DTA_DestHeight, height,
-					TAG_MORE, &tags);
-			}
-			else
-			{
-				DrawTexture (pic, cx, cy,
-					DTA_Translation, range,
-					TAG_MORE, &tags);
 			}
-			va_end (tags);
+			DrawTexture (pic, cx, cy, chartags);
 		}
 		cx += (w + kerning) * scalex;
 	}
-	va_end(taglist);
 }
 
 void STACK_ARGS DCanvas::DrawText (FFont *font, int normalcolor, int x, int y, const char *string, ...)
@@ -273,6 +251,11 @@ void STACK_ARGS DCanvas::DrawTextA (FFont *font, int normalcolor, int x, int y,
 	DrawTextV(font, normalcolor, x, y, string, tags);
 }
 
+void DCanvas::DrawTextA (FFont *font, int normalcolor, int x, int y, const char *string, const FDrawTags &tags)
+{
+	DrawText(font, normalcolor, x, y, string, tags);
+}
+
 //
 // Find string width using this font
 //
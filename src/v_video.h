@@ -124,6 +124,48 @@ enum
 	DTA_CellY,			// vertical size of character cell
 };
 
+// A DrawTexture tag list that has been read into memory. Filling one of
+// these once and passing it to DCanvas::DrawTexture saves walking the
+// varargs again for every texture drawn with the same tags. The values
+// of single tags can be changed between draws through operator[].
+struct FDrawTags
+{
+	enum { MAX_TAGS = 48 };
+
+	struct Item
+	{
+		uint32 Tag;
+		union
+		{
+			int Int;
+			double Float;
+			const void *Ptr;
+		};
+	};
+
+	FDrawTags() : NumItems(0) {}
+
+	void Clear() { NumItems = 0; }
+	int Size() const { return NumItems; }
+	Item &operator[] (int index) { return Items[index]; }
+	const Item &operator[] (int index) const { return Items[index]; }
+
+	// These return the index of the new item.
+	int AddInt(uint32 tag, int value);
+	int AddFloat(uint32 tag, double value);
+	int AddPtr(uint32 tag, const void *value);
+
+	void AddList(uint32 tag, va_list tags);
+	void STACK_ARGS AddTags(int tags_first, ...);
+	void Append(const FDrawTags &other);
+
+private:
+	Item *NewItem(uint32 tag);
+
+	Item Items[MAX_TAGS];
+	int NumItems;
+};
+
 enum
 {
 	HUD_Normal,
@@ -206,6 +248,7 @@ public:
 
 	// 2D Texture drawing
 	void STACK_ARGS DrawTexture (FTexture *img, double x, double y, int tags, ...);
+	void DrawTexture (FTexture *img, double x, double y, const FDrawTags &tags);
 	void FillBorder (FTexture *img);	// Fills the border around a 4:3 part of the screen on non-4:3 displays
 	void VirtualToRealCoords(double &x, double &y, double &w, double &h, double vwidth, double vheight, bool vbottom=false, bool handleaspect=true) const;
 
@@ -217,8 +260,10 @@ public:
 	void STACK_ARGS DrawText (FFont *font, int normalcolor, int x, int y, const char *string, ...);
 #ifndef DrawText	// See WinUser.h for the definition of DrawText as a macro
 	void STACK_ARGS DrawTextA (FFont *font, int normalcolor, int x, int y, const char *string, ...);
+	void DrawTextA (FFont *font, int normalcolor, int x, int y, const char *string, const FDrawTags &tags);
 #endif
 	void DrawTextV (FFont *font, int normalcolor, int x, int y, const char *string, va_list tags);
+	void DrawText (FFont *font, int normalcolor, int x, int y, const char *string, const FDrawTags &tags);
 	void STACK_ARGS DrawChar (FFont *font, int normalcolor, int x, int y, BYTE character, ...);
 
 	struct DrawParms
@@ -255,6 +300,12 @@ public:
 		struct FColormapStyle *colormapstyle;
 	};
 
+	// Fills parms for drawing img at x/y. Returns false if there is nothing to draw.
+	bool ParseDrawTextureTags (FTexture *img, double x, double y, const FDrawTags &tags, DrawParms *parms) const;
+
+	// Draws a texture from already parsed parameters. The parms may be modified.
+	virtual void DrawTextureParms (FTexture *img, DrawParms &parms);
+
 protected:
 	BYTE *Buffer;
 	int Width;
@@ -263,8 +314,7 @@ protected:
 	int LockCount;
 
 	bool ClipBox (int &left, int &top, int &width, int &height, const BYTE *&src, const int srcpitch) const;
-	virtual void STACK_ARGS DrawTextureV (FTexture *img, double x, double y, uint32 tag, va_list tags);
-	bool ParseDrawTextureTags (FTexture *img, double x, double y, uint32 tag, va_list tags, DrawParms *parms, bool hw) const;
+	void STACK_ARGS DrawTextureV (FTexture *img, double x, double y, uint32 tag, va_list tags);
 
 	DCanvas() {}
 
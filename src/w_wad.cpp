@@ -60,6 +60,7 @@
 #include "doomstat.h"
 #include "compatibility.h"
 #include "sc_man.h"
+#include "threadpool.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -97,6 +98,11 @@ CVAR(Bool, check_outdated_iwad, true, CVAR_ARCHIVE);
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+// Lumps from the same file share one file handle, and the lump cache is
+// reference counted, so anything touching those must hold this lock to
+// allow reading lumps from worker threads.
+static FThreadLock LumpAccess;
+
 // CODE --------------------------------------------------------------------
 
 //==========================================================================
@@ -1644,6 +1650,7 @@ FWadLump::FWadLump (const FWadLump &copy)
 : FileReader()
 {
 	// This must be defined isn't called.
+	FThreadLockGuard guard(LumpAccess);
 	File = copy.File;
 	Length = copy.Length;
 	FilePos = copy.FilePos;
@@ -1656,6 +1663,7 @@ FWadLump::FWadLump (const FWadLump &copy)
 FWadLump & FWadLump::operator= (const FWadLump &copy)
 {
 	// Only the debug build actually calls this!
+	FThreadLockGuard guard(LumpAccess);
 	File = copy.File;
 	Length = copy.Length;
 	FilePos = copy.FilePos;
@@ -1670,6 +1678,7 @@ FWadLump & FWadLump::operator= (const FWadLump &copy)
 FWadLump::FWadLump(FResourceLump *lump, bool alwayscache)
 : FileReader()
 {
+	FThreadLockGuard guard(LumpAccess);
 	FileReader *f = lump->GetReader();
 
 	if (f != NULL && f->GetFile() != NULL && !alwayscache)
@@ -1694,6 +1703,7 @@ FWadLump::~FWadLump()
 {
 	if (Lump != NULL)
 	{
+		FThreadLockGuard guard(LumpAccess);
 		Lump->ReleaseCache();
 	}
 }
@@ -1718,6 +1728,7 @@ long FWadLump::Seek (long offset, int origin)
 		FilePos = clamp<long> (offset, 0, Length);
 		return 0;
 	}
+	FThreadLockGuard guard(LumpAccess);
 	return FileReader::Seek(offset, origin);
 }
 
@@ -1738,6 +1749,9 @@ long FWadLump::Read (void *buffer, long len)
 	}
 	else
 	{
+		// Another lump in the same file may have been read in the meantime.
+		FThreadLockGuard guard(LumpAccess);
+		if (ftell(File) != FilePos) fseek(File, FilePos, SEEK_SET);
 		numread = FileReader::Read(buffer, len);
 	}
 	return numread;
@@ -1751,6 +1765,8 @@ char *FWadLump::Gets(char *strbuf, int len)
 	}
 	else
 	{
+		FThreadLockGuard guard(LumpAccess);
+		if (ftell(File) != FilePos) fseek(File, FilePos, SEEK_SET);
 		return FileReader::Gets(strbuf, len);
 	}
 	return strbuf;
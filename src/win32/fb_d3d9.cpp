@@ -2927,24 +2927,21 @@ void D3DFB::DrawPixel(int x, int y, int palcolor, uint32 color)
 
 //==========================================================================
 //
-// D3DFB :: DrawTextureV
+// D3DFB :: DrawTextureParms
 //
 // If not in 2D mode, just call the normal software version.
 // If in 2D mode, then use Direct3D calls to perform the drawing.
 //
 //==========================================================================
 
-void STACK_ARGS D3DFB::DrawTextureV (FTexture *img, double x, double y, uint32 tags_first, va_list tags)
+void D3DFB::DrawTextureParms (FTexture *img, DrawParms &parms)
 {
 	if (In2D < 2)
 	{
-		Super::DrawTextureV(img, x, y, tags_first, tags);
+		Super::DrawTextureParms(img, parms);
 		return;
 	}
-
-	DrawParms parms;
-
-	if (!InScene || !ParseDrawTextureTags(img, x, y, tags_first, tags, &parms, true))
+	if (!InScene)
 	{
 		return;
 	}
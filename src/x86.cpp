@@ -365,4 +365,102 @@ void DoBlending_SSE2(const PalEntry *from, PalEntry *to, int count, int r, int g
 		}
 	}
 }
+
+// Nearest palette color by squared RGB distance, four entries at a time.
+// Returns exactly what the scalar BestColor() loop returns: the lowest
+// index in [first, num) with the minimal distance. r, g and b must be
+// in the range [0, 255].
+int BestColor_SSE2(const PalEntry *pal, int r, int g, int b, int first, int num)
+{
+	int bestcolor = first;
+	int bestdist = 257*257+257*257+257*257;
+	int color = first;
+
+	if (num - first >= 4)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbmask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i target = _mm_set_epi16(0, r, g, b, 0, r, g, b);
+		const __m128i four = _mm_set1_epi32(4);
+		__m128i index = _mm_set_epi32(first+3, first+2, first+1, first);
+		__m128i bestdists = _mm_set1_epi32(bestdist);
+		__m128i bestindex = _mm_set1_epi32(first);
+
+		for (; color + 4 <= num; color += 4)
+		{
+			__m128i entries = _mm_and_si128(_mm_loadu_si128((const __m128i *)&pal[color]), rgbmask);
+			__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(entries, zero), target);
+			__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(entries, zero), target);
+
+			// Each madd lane holds either b*b+g*g or r*r (+ 0 for alpha)
+			// of one entry. Pair them up again to get the full distance.
+			lo = _mm_madd_epi16(lo, lo);
+			hi = _mm_madd_epi16(hi, hi);
+			__m128i bg = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2,0,2,0)));
+			__m128i rr = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3,1,3,1)));
+			__m128i dist = _mm_add_epi32(bg, rr);
+
+			// Strictly less keeps the earliest index within each lane.
+			__m128i better = _mm_cmplt_epi32(dist, bestdists);
+			bestdists = _mm_or_si128(_mm_and_si128(better, dist), _mm_andnot_si128(better, bestdists));
+			bestindex = _mm_or_si128(_mm_and_si128(better, index), _mm_andnot_si128(better, bestindex));
+			index = _mm_add_epi32(index, four);
+		}
+
+		int dists[4], indices[4];
+		_mm_storeu_si128((__m128i *)dists, bestdists);
+		_mm_storeu_si128((__m128i *)indices, bestindex);
+		for (int i = 0; i < 4; ++i)
+		{
+			if (dists[i] < bestdist || (dists[i] == bestdist && indices[i] < bestcolor))
+			{
+				bestdist = dists[i];
+				bestcolor = indices[i];
+			}
+		}
+		if (bestdist == 0)
+		{
+			return bestcolor;
+		}
+	}
+
+	for (; color < num; color++)
+	{
+		int x = r - pal[color].r;
+		int y = g - pal[color].g;
+		int z = b - pal[color].b;
+		int dist = x*x + y*y + z*z;
+		if (dist < bestdist)
+		{
+			if (dist == 0)
+				return color;
+
+			bestdist = dist;
+			bestcolor = color;
+		}
+	}
+	return bestcolor;
+}
+
+// The 8 neighbour comparisons of hqNx in one go. Each table entry holds
+// Y, U and V in separate bytes; two pixels differ when any component
+// differs by more than the threshold. Bit k-1 (k<5) and bit k-2 (k>5)
+// of the result are set when w[5] and w[k] differ.
+int HQDiffPattern_SSE2(const int *w, const int *yuvtable)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i threshold = _mm_set1_epi32(0x00300706);
+	const __m128i center = _mm_set1_epi32(yuvtable[w[5]]);
+	__m128i lo = _mm_setr_epi32(yuvtable[w[1]], yuvtable[w[2]], yuvtable[w[3]], yuvtable[w[4]]);
+	__m128i hi = _mm_setr_epi32(yuvtable[w[6]], yuvtable[w[7]], yuvtable[w[8]], yuvtable[w[9]]);
+
+	lo = _mm_or_si128(_mm_subs_epu8(lo, center), _mm_subs_epu8(center, lo));
+	hi = _mm_or_si128(_mm_subs_epu8(hi, center), _mm_subs_epu8(center, hi));
+	lo = _mm_cmpeq_epi32(_mm_subs_epu8(lo, threshold), zero);
+	hi = _mm_cmpeq_epi32(_mm_subs_epu8(hi, threshold), zero);
+
+	// one byte per neighbour, 0xff where they are considered equal
+	__m128i same = _mm_packs_epi16(_mm_packs_epi32(lo, hi), zero);
+	return ~_mm_movemask_epi8(same) & 0xff;
+}
 #endif